@@ -0,0 +1,33 @@
+#ifndef INCLUDE_ALLOCATORS_ALLOCATOR_CONCEPTS_HPP
+#define INCLUDE_ALLOCATORS_ALLOCATOR_CONCEPTS_HPP
+
+#include <concepts>
+
+namespace yLab
+{
+
+/*
+ * There is a semantic rule additionally to the following concept.
+ * Method release shall either free all memory ever allocated through the allocator at once and
+ * return true, or do nothing and return false. A tree calls it instead of deallocating its nodes
+ * one by one
+ */
+template<typename Alloc>
+concept releasable_allocator = requires(Alloc alloc)
+{
+    { alloc.release() } -> std::same_as<bool>;
+};
+
+/*
+ * There is a semantic rule additionally to the following concept.
+ * After a.adopt(b) a shall be able to deallocate memory allocated by b
+ */
+template<typename Alloc>
+concept adoptable_allocator = requires(Alloc alloc, const Alloc &rhs)
+{
+    alloc.adopt(rhs);
+};
+
+} // namespace yLab
+
+#endif // INCLUDE_ALLOCATORS_ALLOCATOR_CONCEPTS_HPP
@@ -0,0 +1,291 @@
+#ifndef INCLUDE_ALLOCATORS_SLAB_ALLOCATOR_HPP
+#define INCLUDE_ALLOCATORS_SLAB_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <new>
+#include <memory>
+#include <array>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+namespace yLab
+{
+
+/*
+ * Arena that carves small blocks out of large slabs. Every freed block is put into the free list of
+ * its size class and is reused by subsequent allocations of the same size class. All slabs can be
+ * dropped at once by release().
+ *
+ * Arenas can be merged: the absorbed arena hands its slabs and free lists over and forwards all
+ * further requests to the absorbing one, so that blocks of both arenas may be deallocated through
+ * either of them. Merged arenas form a forest where every tree is represented by its root.
+ * The arena is not thread-safe
+ */
+class Slab_Arena final : public std::enable_shared_from_this<Slab_Arena>
+{
+public:
+
+    static constexpr std::size_t block_alignment = alignof(std::max_align_t);
+    static constexpr std::size_t max_block_size = 256;
+    static constexpr std::size_t default_slab_size = 64 * 1024;
+
+    explicit Slab_Arena(std::size_t slab_size = default_slab_size) noexcept
+        : slab_size_{slab_size < min_slab_size ? min_slab_size : slab_size} {}
+
+    Slab_Arena(const Slab_Arena &rhs) = delete;
+    Slab_Arena &operator=(const Slab_Arena &rhs) = delete;
+
+    ~Slab_Arena() { release(); }
+
+    // replaces arena with the root of its tree of merged arenas
+    static Slab_Arena &resolve(std::shared_ptr<Slab_Arena> &arena) noexcept
+    {
+        assert(arena);
+
+        while (arena->forward_)
+            arena = arena->forward_;
+
+        return *arena;
+    }
+
+    const Slab_Arena &root() const noexcept
+    {
+        auto arena = this;
+        while (arena->forward_)
+            arena = arena->forward_.get();
+
+        return *arena;
+    }
+
+    void *allocate(std::size_t size)
+    {
+        assert(!forward_);
+        assert(size != 0 && size <= max_block_size);
+
+        const auto size_class = size_class_of(size);
+
+        if (Free_Block *block = free_lists_[size_class])
+        {
+            free_lists_[size_class] = block->next;
+            return block;
+        }
+
+        const auto block_size = block_size_of(size_class);
+        if (static_cast<std::size_t>(slab_end_ - cursor_) < block_size)
+            add_slab();
+
+        return std::exchange(cursor_, cursor_ + block_size);
+    }
+
+    void deallocate(void *ptr, std::size_t size) noexcept
+    {
+        assert(!forward_);
+        assert(ptr);
+
+        const auto size_class = size_class_of(size);
+        free_lists_[size_class] = ::new (ptr) Free_Block{free_lists_[size_class]};
+    }
+
+    // All blocks allocated by the arena become invalid
+    void release() noexcept
+    {
+        for (Slab *slab = slabs_; slab != nullptr; )
+            ::operator delete(static_cast<void *>(std::exchange(slab, slab->next)),
+                              std::align_val_t{block_alignment});
+
+        slabs_ = nullptr;
+        n_slabs_ = 0;
+        cursor_ = slab_end_ = nullptr;
+        free_lists_.fill(nullptr);
+    }
+
+    // Both arenas shall be roots. rhs keeps forwarding to this arena afterwards
+    void merge(Slab_Arena &rhs)
+    {
+        assert(!forward_ && !rhs.forward_);
+
+        if (&rhs == this)
+            return;
+
+        rhs.forward_ = shared_from_this();
+
+        for (auto size_class = 0uz; size_class != n_size_classes; ++size_class)
+            free_lists_[size_class] = splice(rhs.free_lists_[size_class], free_lists_[size_class]);
+
+        slabs_ = splice(rhs.slabs_, slabs_);
+        n_slabs_ += std::exchange(rhs.n_slabs_, 0);
+
+        // the rest of the current slab of rhs stays unused until release()
+        rhs.cursor_ = rhs.slab_end_ = nullptr;
+    }
+
+    std::size_t n_slabs() const noexcept { return n_slabs_; }
+    std::size_t slab_size() const noexcept { return slab_size_; }
+
+private:
+
+    struct Free_Block final
+    {
+        Free_Block *next;
+    };
+
+    struct alignas(block_alignment) Slab final
+    {
+        Slab *next;
+    };
+
+    static constexpr std::size_t n_size_classes = max_block_size / block_alignment;
+    static constexpr std::size_t min_slab_size = sizeof(Slab) + max_block_size;
+
+    static std::size_t size_class_of(std::size_t size) noexcept
+    {
+        return (size + block_alignment - 1) / block_alignment - 1;
+    }
+
+    static std::size_t block_size_of(std::size_t size_class) noexcept
+    {
+        return (size_class + 1) * block_alignment;
+    }
+
+    // prepends list "from" to list "to" leaving "from" empty; O(length of "from")
+    template<typename List_Node>
+    static List_Node *splice(List_Node *&from, List_Node *to) noexcept
+    {
+        if (from == nullptr)
+            return to;
+
+        List_Node *last = from;
+        while (last->next)
+            last = last->next;
+        last->next = to;
+
+        return std::exchange(from, nullptr);
+    }
+
+    void add_slab()
+    {
+        void *memory = ::operator new(slab_size_, std::align_val_t{block_alignment});
+
+        slabs_ = ::new (memory) Slab{slabs_};
+        n_slabs_++;
+
+        cursor_ = static_cast<std::byte *>(memory) + sizeof(Slab);
+        slab_end_ = static_cast<std::byte *>(memory) + slab_size_;
+    }
+
+    std::array<Free_Block *, n_size_classes> free_lists_{};
+    Slab *slabs_ = nullptr;
+    std::size_t n_slabs_ = 0;
+    std::byte *cursor_ = nullptr;
+    std::byte *slab_end_ = nullptr;
+    std::size_t slab_size_;
+    std::shared_ptr<Slab_Arena> forward_;
+};
+
+/*
+ * Allocator that serves single objects from a Slab_Arena. All copies and rebound copies of an
+ * allocator share one arena; a tree gets its own arena on copy construction. adopt() merges arenas
+ * of two allocators so that they compare equal afterwards. Requests the arena cannot serve (arrays,
+ * big or over-aligned types) are forwarded to std::allocator
+ */
+template<typename T>
+class Slab_Allocator
+{
+    template<typename U>
+    friend class Slab_Allocator;
+
+public:
+
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    Slab_Allocator() : arena_{std::make_shared<Slab_Arena>()} {}
+
+    explicit Slab_Allocator(std::size_t slab_size)
+        : arena_{std::make_shared<Slab_Arena>(slab_size)} {}
+
+    template<typename U>
+    Slab_Allocator(const Slab_Allocator<U> &rhs) noexcept : arena_{rhs.arena_} {}
+
+    T *allocate(std::size_t n)
+    {
+        if (!served_by_arena(n))
+            return std::allocator<T>{}.allocate(n);
+
+        return static_cast<T *>(arena().allocate(sizeof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept
+    {
+        if (!served_by_arena(n))
+            std::allocator<T>{}.deallocate(ptr, n);
+        else
+        {
+            Slab_Arena::resolve(arena_).deallocate(ptr, sizeof(T));
+        }
+    }
+
+    Slab_Allocator select_on_container_copy_construction() const
+    {
+        return arena_ ? Slab_Allocator{arena_->root().slab_size()} : Slab_Allocator{};
+    }
+
+    // Drops all slabs at once if no other allocator or merged arena refers to the arena
+    bool release() noexcept
+    {
+        if (!arena_)
+            return false;
+
+        Slab_Arena &arena = Slab_Arena::resolve(arena_);
+        if (arena_.use_count() != 1)
+            return false;
+
+        arena.release();
+        return true;
+    }
+
+    void adopt(const Slab_Allocator &rhs)
+    {
+        if (rhs.arena_)
+            arena().merge(const_cast<Slab_Arena &>(rhs.arena_->root()));
+    }
+
+    std::size_t n_slabs() const noexcept { return arena_ ? arena_->root().n_slabs() : 0; }
+
+    template<typename U>
+    bool operator==(const Slab_Allocator<U> &rhs) const noexcept
+    {
+        if (arena_ && rhs.arena_)
+            return &arena_->root() == &rhs.arena_->root();
+        else
+            return arena_ == rhs.arena_;
+    }
+
+private:
+
+    static constexpr bool fits_arena = sizeof(T) <= Slab_Arena::max_block_size &&
+                                       alignof(T) <= Slab_Arena::block_alignment;
+
+    static bool served_by_arena(std::size_t n) noexcept { return fits_arena && n == 1; }
+
+    // a moved-from allocator gets a new arena on demand
+    Slab_Arena &arena()
+    {
+        if (!arena_)
+            arena_ = std::make_shared<Slab_Arena>();
+        return Slab_Arena::resolve(arena_);
+    }
+
+    std::shared_ptr<Slab_Arena> arena_;
+};
+
+} // namespace yLab
+
+#endif // INCLUDE_ALLOCATORS_SLAB_ALLOCATOR_HPP
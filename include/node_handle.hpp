@@ -0,0 +1,143 @@
+#ifndef INCLUDE_NODE_HANDLE_HPP
+#define INCLUDE_NODE_HANDLE_HPP
+
+#include <concepts>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <cassert>
+
+#include "nodes/node_base.hpp"
+#include "nodes/node_concepts.hpp"
+
+namespace yLab
+{
+
+/*
+ * Owner of a node extracted from a tree, like the node handles of std::set and std::map. The node
+ * keeps its memory until it is inserted into another tree or the handle is destroyed, so entries
+ * move between trees without reallocation. Allocator is the allocator of nodes of the tree; a copy
+ * of it is kept to destroy the node
+ */
+template<typename Node_T, typename Allocator>
+class Node_Handle final
+{
+    using node_ptr = Node_T *;
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+
+    using key_type = typename Node_T::key_type;
+    using value_type = typename Node_T::value_type;
+    using allocator_type = Allocator;
+
+    Node_Handle() noexcept = default;
+
+    Node_Handle(const Node_Handle &rhs) = delete;
+    Node_Handle &operator=(const Node_Handle &rhs) = delete;
+
+    Node_Handle(Node_Handle &&rhs) noexcept
+        : node_{std::exchange(rhs.node_, nullptr)}, alloc_{std::move(rhs.alloc_)}
+    {
+        rhs.alloc_.reset();
+    }
+
+    Node_Handle &operator=(Node_Handle &&rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            reset();
+            node_ = std::exchange(rhs.node_, nullptr);
+            alloc_ = std::move(rhs.alloc_);
+            rhs.alloc_.reset();
+        }
+
+        return *this;
+    }
+
+    ~Node_Handle() { reset(); }
+
+    bool empty() const noexcept { return node_ == nullptr; }
+    explicit operator bool() const noexcept { return !empty(); }
+
+    allocator_type get_allocator() const
+    {
+        assert(!empty());
+        return *alloc_;
+    }
+
+    // the key of a set
+    template<typename Node = Node_T>
+    requires (!contains_mapped_value<Node>)
+    const value_type &value() const
+    {
+        assert(!empty());
+        return node_->get_value();
+    }
+
+    // the key and the mapped value of a map
+    template<contains_mapped_value Node = Node_T>
+    const key_type &key() const
+    {
+        assert(!empty());
+        return node_->get_key();
+    }
+
+    template<contains_mapped_value Node = Node_T>
+    typename Node::mapped_type &mapped() const
+    {
+        assert(!empty());
+        return node_->get_value().second;
+    }
+
+    void swap(Node_Handle &rhs) noexcept
+    {
+        std::swap(node_, rhs.node_);
+        std::swap(alloc_, rhs.alloc_);
+    }
+
+    friend void swap(Node_Handle &lhs, Node_Handle &rhs) noexcept { lhs.swap(rhs); }
+
+    template<typename node_t, typename Compare, typename Alloc>
+    requires std::derived_from<node_t, Node_Base>
+    friend class Search_Tree;
+
+private:
+
+    Node_Handle(node_ptr node, const allocator_type &alloc) : node_{node}, alloc_{alloc} {}
+
+    // gives the node up to a tree
+    node_ptr release() noexcept
+    {
+        alloc_.reset();
+        return std::exchange(node_, nullptr);
+    }
+
+    void reset() noexcept
+    {
+        if (node_)
+        {
+            alloc_traits::destroy(*alloc_, node_);
+            alloc_traits::deallocate(*alloc_, node_, 1);
+            node_ = nullptr;
+        }
+
+        alloc_.reset();
+    }
+
+    node_ptr node_ = nullptr;
+    std::optional<allocator_type> alloc_;
+};
+
+// the result of insertion of a node handle: the node is handed back if its key is in the tree
+template<typename Iterator, typename Node_Handle_T>
+struct Node_Insert_Result final
+{
+    Iterator position;
+    bool inserted;
+    Node_Handle_T node;
+};
+
+} // namespace yLab
+
+#endif // INCLUDE_NODE_HANDLE_HPP
@@ -0,0 +1,89 @@
+#ifndef INCLUDE_NODES_COUNTED_NODE_HPP
+#define INCLUDE_NODES_COUNTED_NODE_HPP
+
+#include <cstddef>
+#include <utility>
+#include <ostream>
+#include <cassert>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "nodes/node.hpp"
+
+namespace yLab
+{
+
+/*
+ * Node of a multiset: a key occurring several times is stored once together with the number of
+ * its occurrences. The size of a subtree is the number of occurrences of its keys
+ */
+template<typename Key_T, typename Base = Node_Base>
+class Counted_Node final : public Node<Key_T, Base>
+{
+    using base_node = Base;
+    using base_node_ptr = base_node *;
+    using node_ptr = Counted_Node *;
+    using const_node_ptr = const Counted_Node *;
+
+public:
+
+    using typename Node<Key_T, Base>::key_type;
+    using size_type = std::size_t;
+
+    Counted_Node(const Key_T &key, node_ptr left = nullptr, node_ptr right = nullptr,
+                 base_node_ptr parent = nullptr)
+        : Node<Key_T, Base>{key, left, right, parent}, size_{1 + size(left) + size(right)} {}
+
+    Counted_Node(Key_T &&key, node_ptr left = nullptr, node_ptr right = nullptr,
+                 base_node_ptr parent = nullptr)
+        : Node<Key_T, Base>{std::move(key), left, right, parent},
+          size_{1 + size(left) + size(right)} {}
+
+    template<typename... Args>
+    explicit Counted_Node(std::in_place_t, Args &&... args)
+        : Node<Key_T, Base>{std::in_place, std::forward<Args>(args)...}, size_{1} {}
+
+    static size_type size(const_node_ptr node) noexcept { return node ? node->size_ : 0; }
+
+    size_type count() const noexcept { return count_; }
+
+    // sizes of the ancestors of the node are to be recomputed by the caller
+    void set_count(size_type count) noexcept
+    {
+        assert(count != 0);
+
+        size_ = size_ - count_ + count;
+        count_ = count;
+    }
+
+    // recomputes the size of the subtree after a change of children of the node
+    void update() noexcept
+    {
+        size_ = count_ + size(static_cast<const_node_ptr>(this->get_left())) +
+                         size(static_cast<const_node_ptr>(this->get_right()));
+    }
+
+    // rotations of Node_Base that maintain subtree sizes
+    void left_rotate() noexcept { base_node::template left_rotate<Counted_Node>(); }
+    void right_rotate() noexcept { base_node::template right_rotate<Counted_Node>(); }
+
+private:
+
+    size_type count_ = 1;
+    size_type size_;
+};
+
+template<typename Key_T, typename Base>
+void dot_dump(std::ostream &os, const Counted_Node<Key_T, Base> &node)
+{
+    fmt::print(os, "    node_{} [shape = record, color = blue, style = filled, "
+                   "fillcolor = chartreuse, fontcolor = black, "
+                   "label = \"key: {} | count: {} | size: {}\"];\n",
+               fmt::ptr(&node), node.get_key(), node.count(),
+               Counted_Node<Key_T, Base>::size(&node));
+}
+
+} // namespace yLab
+
+#endif // INCLUDE_NODES_COUNTED_NODE_HPP
@@ -0,0 +1,100 @@
+#ifndef INCLUDE_NODES_IMPLICIT_NODE_HPP
+#define INCLUDE_NODES_IMPLICIT_NODE_HPP
+
+#include <cstddef>
+#include <utility>
+#include <ostream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "nodes/node.hpp"
+
+namespace yLab
+{
+
+/*
+ * Node of a sequence addressed by positions: the size of the left subtree is the position of the
+ * node within its subtree. reverse() mirrors the subtree lazily: the links of the node are swapped
+ * at once together with their thread flags, while its children get mirrored by push() once they
+ * are about to move or to be read
+ */
+template<typename T>
+class Implicit_Node final : public Node<T>
+{
+    using base_node = Node_Base;
+    using base_node_ptr = base_node *;
+    using node_ptr = Implicit_Node *;
+    using const_node_ptr = const Implicit_Node *;
+
+public:
+
+    using typename Node<T>::key_type;
+    using size_type = std::size_t;
+
+    Implicit_Node(const T &value, node_ptr left = nullptr, node_ptr right = nullptr,
+                  base_node_ptr parent = nullptr)
+        : Node<T>{value, left, right, parent}, size_{1 + size(left) + size(right)} {}
+
+    Implicit_Node(T &&value, node_ptr left = nullptr, node_ptr right = nullptr,
+                  base_node_ptr parent = nullptr)
+        : Node<T>{std::move(value), left, right, parent}, size_{1 + size(left) + size(right)} {}
+
+    using Node<T>::get_key;
+    key_type &get_key() noexcept { return this->key_; }
+
+    static size_type size(const_node_ptr node) noexcept { return node ? node->size_ : 0; }
+
+    bool has_pending_reversal() const noexcept { return reversed_; }
+
+    // mirrors the subtree
+    void reverse() noexcept
+    {
+        std::swap(this->left_, this->right_);
+        reversed_ = !reversed_;
+    }
+
+    // passes the pending reversal on to the children
+    void push() noexcept
+    {
+        if (!reversed_)
+            return;
+
+        if (auto left = static_cast<node_ptr>(this->get_left()))
+            left->reverse();
+        if (auto right = static_cast<node_ptr>(this->get_right()))
+            right->reverse();
+
+        reversed_ = false;
+    }
+
+    // recomputes the size of the subtree after a change of children of the node
+    void update() noexcept
+    {
+        size_ = 1 + size(static_cast<const_node_ptr>(this->get_left())) +
+                    size(static_cast<const_node_ptr>(this->get_right()));
+    }
+
+    // rotations of Node_Base that maintain subtree sizes
+    void left_rotate() noexcept { base_node::template left_rotate<Implicit_Node>(); }
+    void right_rotate() noexcept { base_node::template right_rotate<Implicit_Node>(); }
+
+private:
+
+    size_type size_;
+    bool reversed_ = false;
+};
+
+template<typename T>
+void dot_dump(std::ostream &os, const Implicit_Node<T> &node)
+{
+    fmt::print(os, "    node_{} [shape = record, color = blue, style = filled, "
+                   "fillcolor = chartreuse, fontcolor = black, "
+                   "label = \"value: {} | size: {} | reversed: {}\"];\n",
+               fmt::ptr(&node), node.get_key(), Implicit_Node<T>::size(&node),
+               node.has_pending_reversal());
+}
+
+} // namespace yLab
+
+#endif // INCLUDE_NODES_IMPLICIT_NODE_HPP
@@ -0,0 +1,183 @@
+#ifndef INCLUDE_NODES_LAZY_NODE_HPP
+#define INCLUDE_NODES_LAZY_NODE_HPP
+
+#include <cstddef>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <concepts>
+#include <ostream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "nodes/node.hpp"
+#include "nodes/node_concepts.hpp"
+
+namespace yLab
+{
+
+/*
+ * Adds a delta to the payload of keys selected by Projection. Projection shall return a reference
+ * when applied to a mutable key and shall not select the part of a key the tree is ordered by,
+ * so there is no default one and a projection of the whole key is rejected. Monoid shall provide
+ * shift(value, delta, n)
+ */
+template<typename T, typename Projection>
+struct Add_Action final
+{
+    using tag_type = T;
+
+    template<typename Key_T>
+    requires (!std::same_as<std::remove_cvref_t<std::invoke_result_t<Projection, Key_T &>>, Key_T>)
+    static void apply(Key_T &key, const tag_type &delta)
+    {
+        std::invoke(Projection{}, key) += delta;
+    }
+
+    template<typename Monoid>
+    static typename Monoid::value_type apply_to_aggregate(const typename Monoid::value_type &value,
+                                                          const tag_type &delta, std::size_t n)
+    {
+        return Monoid::shift(value, delta, n);
+    }
+
+    static tag_type compose(const tag_type &later, const tag_type &earlier)
+    {
+        return later + earlier;
+    }
+};
+
+/*
+ * Monoid node that accepts an update of the whole subtree in O(1): the key and the aggregate of
+ * the node are updated at once, while the children get the update by push() once they are about
+ * to move or to be read
+ */
+template<typename Key_T, typename Monoid, typename Action, typename Base = Node_Base>
+requires monoid_of<Monoid, Key_T> && action_of<Action, Key_T, Monoid>
+class Lazy_Node final : public Node<Key_T, Base>
+{
+    using base_node = Base;
+    using base_node_ptr = base_node *;
+    using node_ptr = Lazy_Node *;
+    using const_node_ptr = const Lazy_Node *;
+
+public:
+
+    using typename Node<Key_T, Base>::key_type;
+    using size_type = std::size_t;
+    using monoid_type = Monoid;
+    using aggregate_type = typename Monoid::value_type;
+    using action_type = Action;
+    using tag_type = typename Action::tag_type;
+
+    Lazy_Node(const Key_T &key, node_ptr left = nullptr, node_ptr right = nullptr,
+              base_node_ptr parent = nullptr)
+        : Node<Key_T, Base>{key, left, right, parent}
+    {
+        update();
+    }
+
+    Lazy_Node(Key_T &&key, node_ptr left = nullptr, node_ptr right = nullptr,
+              base_node_ptr parent = nullptr)
+        : Node<Key_T, Base>{std::move(key), left, right, parent}
+    {
+        update();
+    }
+
+    template<typename... Args>
+    explicit Lazy_Node(std::in_place_t, Args &&... args)
+        : Node<Key_T, Base>{std::in_place, std::forward<Args>(args)...}
+    {
+        update();
+    }
+
+    static size_type size(const_node_ptr node) noexcept { return node ? node->size_ : 0; }
+
+    static aggregate_type aggregate(const_node_ptr node)
+    {
+        return node ? node->aggregate_ : Monoid::identity();
+    }
+
+    bool has_pending_tag() const noexcept { return has_tag_; }
+
+    // updates the key of the node only; the aggregate is to be recomputed by update()
+    void apply_to_key(const tag_type &tag) { Action::apply(this->key_, tag); }
+
+    // updates every key of the subtree
+    void apply(const tag_type &tag)
+    {
+        Action::apply(this->key_, tag);
+        aggregate_ = Action::template apply_to_aggregate<Monoid>(aggregate_, tag, size_);
+        tag_ = has_tag_ ? Action::compose(tag, tag_) : tag;
+        has_tag_ = true;
+    }
+
+    // passes the pending update on to the children
+    void push() noexcept
+    {
+        if (!has_tag_)
+            return;
+
+        if (auto left = static_cast<node_ptr>(this->get_left()))
+            left->apply(tag_);
+        if (auto right = static_cast<node_ptr>(this->get_right()))
+            right->apply(tag_);
+
+        has_tag_ = false;
+    }
+
+    /*
+     * Recomputes the size and the aggregate of the subtree after a change of children of the
+     * node. The update pending at the node is taken into account, so it shall be pushed before
+     * any child is attached to the node
+     */
+    void update() noexcept
+    {
+        auto left = static_cast<const_node_ptr>(this->get_left());
+        auto right = static_cast<const_node_ptr>(this->get_right());
+
+        size_ = 1 + size(left) + size(right);
+        aggregate_ = Monoid::combine(Monoid::combine(child_aggregate(left),
+                                                     Monoid::lift(this->key_)),
+                                     child_aggregate(right));
+    }
+
+    // rotations of Node_Base that maintain subtree data
+    void left_rotate() noexcept { base_node::template left_rotate<Lazy_Node>(); }
+    void right_rotate() noexcept { base_node::template right_rotate<Lazy_Node>(); }
+
+private:
+
+    // the aggregate of a child subtree taking the update pending at this node into account
+    aggregate_type child_aggregate(const_node_ptr child) const
+    {
+        auto value = aggregate(child);
+
+        if (child && has_tag_)
+            value = Action::template apply_to_aggregate<Monoid>(value, tag_, child->size_);
+
+        return value;
+    }
+
+    size_type size_;
+    aggregate_type aggregate_;
+    tag_type tag_{};
+    bool has_tag_ = false;
+};
+
+template<typename Key_T, typename Monoid, typename Action, typename Base>
+void dot_dump(std::ostream &os, const Lazy_Node<Key_T, Monoid, Action, Base> &node)
+{
+    using node_type = Lazy_Node<Key_T, Monoid, Action, Base>;
+
+    fmt::print(os, "    node_{} [shape = record, color = blue, style = filled, "
+                   "fillcolor = chartreuse, fontcolor = black, "
+                   "label = \"key: {} | size: {} | aggregate: {} | pending: {}\"];\n",
+               fmt::ptr(&node), node.get_key(), node_type::size(&node),
+               node_type::aggregate(&node), node.has_pending_tag());
+}
+
+} // namespace yLab
+
+#endif // INCLUDE_NODES_LAZY_NODE_HPP
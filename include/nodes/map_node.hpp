@@ -0,0 +1,122 @@
+#ifndef INCLUDE_NODES_MAP_NODE_HPP
+#define INCLUDE_NODES_MAP_NODE_HPP
+
+#include <cstddef>
+#include <utility>
+#include <ostream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "nodes/node_base.hpp"
+
+namespace yLab
+{
+
+/*
+ * Node storing a key together with a mapped value in one pair, so that iterators of maps yield
+ * references to pairs like the ones of std::map. The constructor taking std::in_place builds the
+ * pair from any arguments, e.g. piecewise
+ */
+template<typename Key_T, typename Mapped_T, typename Base = Node_Base>
+class Map_Node : public Base
+{
+    using base_node = Base;
+    using base_node_ptr = base_node *;
+    using node_ptr = Map_Node *;
+
+public:
+
+    using key_type = Key_T;
+    using mapped_type = Mapped_T;
+    using value_type = std::pair<const key_type, mapped_type>;
+
+    Map_Node(const value_type &value, node_ptr left = nullptr, node_ptr right = nullptr,
+             base_node_ptr parent = nullptr)
+        : base_node{left, right, parent}, value_{value} {}
+
+    Map_Node(value_type &&value, node_ptr left = nullptr, node_ptr right = nullptr,
+             base_node_ptr parent = nullptr)
+        : base_node{left, right, parent}, value_{std::move(value)} {}
+
+    template<typename... Args>
+    explicit Map_Node(std::in_place_t, Args &&... args)
+        : base_node{nullptr, nullptr, nullptr}, value_(std::forward<Args>(args)...) {}
+
+    const key_type &get_key() const { return value_.first; }
+
+    value_type &get_value() { return value_; }
+    const value_type &get_value() const { return value_; }
+
+    static const key_type &key_of_value(const value_type &value) noexcept { return value.first; }
+
+protected:
+
+    value_type value_;
+};
+
+template<typename Key_T, typename Mapped_T, typename Base = Node_Base>
+class Augmented_Map_Node final : public Map_Node<Key_T, Mapped_T, Base>
+{
+    using map_node = Map_Node<Key_T, Mapped_T, Base>;
+    using base_node = Base;
+    using base_node_ptr = base_node *;
+    using node_ptr = Augmented_Map_Node *;
+    using const_node_ptr = const Augmented_Map_Node *;
+
+public:
+
+    using typename map_node::value_type;
+    using size_type = std::size_t;
+
+    Augmented_Map_Node(const value_type &value, node_ptr left = nullptr, node_ptr right = nullptr,
+                       base_node_ptr parent = nullptr)
+        : map_node{value, left, right, parent}, size_{1 + size(left) + size(right)} {}
+
+    Augmented_Map_Node(value_type &&value, node_ptr left = nullptr, node_ptr right = nullptr,
+                       base_node_ptr parent = nullptr)
+        : map_node{std::move(value), left, right, parent}, size_{1 + size(left) + size(right)} {}
+
+    template<typename... Args>
+    explicit Augmented_Map_Node(std::in_place_t, Args &&... args)
+        : map_node{std::in_place, std::forward<Args>(args)...}, size_{1} {}
+
+    static size_type size(const_node_ptr node) noexcept { return node ? node->size_ : 0; }
+
+    // recomputes the size of the subtree after a change of children of the node
+    void update() noexcept
+    {
+        size_ = 1 + size(static_cast<const_node_ptr>(this->get_left())) +
+                    size(static_cast<const_node_ptr>(this->get_right()));
+    }
+
+    // rotations of Node_Base that maintain subtree sizes
+    void left_rotate() noexcept { base_node::template left_rotate<Augmented_Map_Node>(); }
+    void right_rotate() noexcept { base_node::template right_rotate<Augmented_Map_Node>(); }
+
+private:
+
+    size_type size_;
+};
+
+template<typename Key_T, typename Mapped_T, typename Base>
+void dot_dump(std::ostream &os, const Map_Node<Key_T, Mapped_T, Base> &node)
+{
+    fmt::print(os, "    node_{} [shape = record, color = blue, style = filled, "
+                   "fillcolor = chartreuse, fontcolor = black, label = \"{} | {}\"];\n",
+               fmt::ptr(&node), node.get_key(), node.get_value().second);
+}
+
+template<typename Key_T, typename Mapped_T, typename Base>
+void dot_dump(std::ostream &os, const Augmented_Map_Node<Key_T, Mapped_T, Base> &node)
+{
+    fmt::print(os, "    node_{} [shape = record, color = blue, style = filled, "
+                   "fillcolor = chartreuse, fontcolor = black, "
+                   "label = \"key: {} | value: {} | size: {}\"];\n",
+               fmt::ptr(&node), node.get_key(), node.get_value().second,
+               Augmented_Map_Node<Key_T, Mapped_T, Base>::size(&node));
+}
+
+} // namespace yLab
+
+#endif // INCLUDE_NODES_MAP_NODE_HPP
@@ -0,0 +1,171 @@
+#ifndef INCLUDE_NODES_MONOID_NODE_HPP
+#define INCLUDE_NODES_MONOID_NODE_HPP
+
+#include <cstddef>
+#include <utility>
+#include <functional>
+#include <limits>
+#include <algorithm>
+#include <ostream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "nodes/node.hpp"
+#include "nodes/node_concepts.hpp"
+
+namespace yLab
+{
+
+/*
+ * Monoids over projections of keys: Projection maps a key to the value being folded. shift(value,
+ * delta, n) is the fold of n values after adding delta to each of them
+ */
+
+template<typename T, typename Projection = std::identity>
+struct Sum_Monoid final
+{
+    using value_type = T;
+
+    static value_type identity() { return value_type{}; }
+
+    template<typename Key_T>
+    static value_type lift(const Key_T &key) { return std::invoke(Projection{}, key); }
+
+    static value_type combine(const value_type &lhs, const value_type &rhs) { return lhs + rhs; }
+
+    template<typename Delta>
+    static value_type shift(const value_type &value, const Delta &delta, std::size_t n)
+    {
+        return value + delta * static_cast<value_type>(n);
+    }
+};
+
+template<typename T, typename Projection = std::identity>
+struct Min_Monoid final
+{
+    using value_type = T;
+
+    static value_type identity() { return std::numeric_limits<value_type>::max(); }
+
+    template<typename Key_T>
+    static value_type lift(const Key_T &key) { return std::invoke(Projection{}, key); }
+
+    static value_type combine(const value_type &lhs, const value_type &rhs)
+    {
+        return std::min(lhs, rhs);
+    }
+
+    template<typename Delta>
+    static value_type shift(const value_type &value, const Delta &delta, std::size_t)
+    {
+        return value + delta;
+    }
+};
+
+template<typename T, typename Projection = std::identity>
+struct Max_Monoid final
+{
+    using value_type = T;
+
+    static value_type identity() { return std::numeric_limits<value_type>::lowest(); }
+
+    template<typename Key_T>
+    static value_type lift(const Key_T &key) { return std::invoke(Projection{}, key); }
+
+    static value_type combine(const value_type &lhs, const value_type &rhs)
+    {
+        return std::max(lhs, rhs);
+    }
+
+    template<typename Delta>
+    static value_type shift(const value_type &value, const Delta &delta, std::size_t)
+    {
+        return value + delta;
+    }
+};
+
+/*
+ * Node keeping the size of its subtree and the fold of keys of the subtree by Monoid. Both are
+ * recomputed by update() wherever the tree recomputes sizes of subtrees
+ */
+template<typename Key_T, typename Monoid, typename Base = Node_Base>
+requires monoid_of<Monoid, Key_T>
+class Monoid_Node final : public Node<Key_T, Base>
+{
+    using base_node = Base;
+    using base_node_ptr = base_node *;
+    using node_ptr = Monoid_Node *;
+    using const_node_ptr = const Monoid_Node *;
+
+public:
+
+    using typename Node<Key_T, Base>::key_type;
+    using size_type = std::size_t;
+    using monoid_type = Monoid;
+    using aggregate_type = typename Monoid::value_type;
+
+    Monoid_Node(const Key_T &key, node_ptr left = nullptr, node_ptr right = nullptr,
+                base_node_ptr parent = nullptr)
+        : Node<Key_T, Base>{key, left, right, parent}
+    {
+        update();
+    }
+
+    Monoid_Node(Key_T &&key, node_ptr left = nullptr, node_ptr right = nullptr,
+                base_node_ptr parent = nullptr)
+        : Node<Key_T, Base>{std::move(key), left, right, parent}
+    {
+        update();
+    }
+
+    template<typename... Args>
+    explicit Monoid_Node(std::in_place_t, Args &&... args)
+        : Node<Key_T, Base>{std::in_place, std::forward<Args>(args)...}
+    {
+        update();
+    }
+
+    static size_type size(const_node_ptr node) noexcept { return node ? node->size_ : 0; }
+
+    static aggregate_type aggregate(const_node_ptr node)
+    {
+        return node ? node->aggregate_ : Monoid::identity();
+    }
+
+    // recomputes the size and the aggregate of the subtree after a change of children of the node
+    void update() noexcept
+    {
+        auto left = static_cast<const_node_ptr>(this->get_left());
+        auto right = static_cast<const_node_ptr>(this->get_right());
+
+        size_ = 1 + size(left) + size(right);
+        aggregate_ = Monoid::combine(Monoid::combine(aggregate(left), Monoid::lift(this->key_)),
+                                     aggregate(right));
+    }
+
+    // rotations of Node_Base that maintain subtree data
+    void left_rotate() noexcept { base_node::template left_rotate<Monoid_Node>(); }
+    void right_rotate() noexcept { base_node::template right_rotate<Monoid_Node>(); }
+
+private:
+
+    size_type size_;
+    aggregate_type aggregate_;
+};
+
+template<typename Key_T, typename Monoid, typename Base>
+void dot_dump(std::ostream &os, const Monoid_Node<Key_T, Monoid, Base> &node)
+{
+    using node_type = Monoid_Node<Key_T, Monoid, Base>;
+
+    fmt::print(os, "    node_{} [shape = record, color = blue, style = filled, "
+                   "fillcolor = chartreuse, fontcolor = black, "
+                   "label = \"key: {} | size: {} | aggregate: {}\"];\n",
+               fmt::ptr(&node), node.get_key(), node_type::size(&node),
+               node_type::aggregate(&node));
+}
+
+} // namespace yLab
+
+#endif // INCLUDE_NODES_MONOID_NODE_HPP
@@ -13,10 +13,11 @@
 namespace yLab
 {
 
-template<typename Key_T>
-class Node : public Node_Base
+// Base is either Node_Base or Parentless_Node_Base
+template<typename Key_T, typename Base = Node_Base>
+class Node : public Base
 {
-    using base_node = Node_Base;
+    using base_node = Base;
     using base_node_ptr = base_node *;
     using node_ptr = Node *;
     using const_node_ptr = const Node *;
@@ -24,26 +25,33 @@ class Node : public Node_Base
 public:
 
     using key_type = Key_T;
+    using value_type = key_type;
 
     Node(const key_type &key, node_ptr left = nullptr, node_ptr right = nullptr,
          base_node_ptr parent = nullptr)
-        : Node_Base{left, right, parent}, key_{key} {}
+        : base_node{left, right, parent}, key_{key} {}
 
     Node(key_type &&key, node_ptr left = nullptr, node_ptr right = nullptr,
          base_node_ptr parent = nullptr)
-        : Node_Base{left, right, parent}, key_{std::move(key)} {}
+        : base_node{left, right, parent}, key_{std::move(key)} {}
 
-    ~Node() override = default;
+    // constructs the key from args in place
+    template<typename... Args>
+    explicit Node(std::in_place_t, Args &&... args)
+        : base_node{nullptr, nullptr, nullptr}, key_(std::forward<Args>(args)...) {}
 
     const key_type &get_key() const { return key_; }
+    const value_type &get_value() const { return key_; }
+
+    static const key_type &key_of_value(const value_type &value) noexcept { return value; }
 
 protected:
 
     Key_T key_;
 };
 
-template<typename Key_T>
-void dot_dump(std::ostream &os, const Node<Key_T> &node)
+template<typename Key_T, typename Base>
+void dot_dump(std::ostream &os, const Node<Key_T, Base> &node)
 {
     fmt::print(os, "    node_{} [shape = record, color = blue, style = filled, "
                    "fillcolor = chartreuse, fontcolor = black, label = \"{}\"];\n",
@@ -3,22 +3,27 @@
 
 #include <cassert>
 #include <ostream>
+#include <type_traits>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include "nodes/node_concepts.hpp"
+#include "nodes/threaded_node_base.hpp"
+
 namespace yLab
 {
 
-class Node_Base
+class Node_Base : public Threaded_Node_Base<Node_Base>
 {
+    using base = Threaded_Node_Base<Node_Base>;
     using node_ptr = Node_Base *;
     using const_node_ptr = const Node_Base *;
 
 public:
 
     Node_Base(node_ptr left = nullptr, node_ptr right = nullptr,
-              node_ptr parent = nullptr) noexcept : left_{left}, right_{right}, parent_{parent} {}
+              node_ptr parent = nullptr) noexcept : base{left, right}, parent_{parent} {}
 
     Node_Base(const Node_Base &rhs) = delete;
     Node_Base &operator=(const Node_Base &rhs) = delete;
@@ -26,80 +31,21 @@ public:
     Node_Base(Node_Base &&rhs) = default;
     Node_Base &operator=(Node_Base &&rhs) = default;
 
-    virtual ~Node_Base() = default;
-
-    // getters and setters
-
-    /*
-     * _unsafe methods give you access to left_ and right_ pointers regardless of whether they
-     * represent a child or a thread; such methods shall be used after calling
-     * has_left_thread()/has_right_thread()
-     */
-
-    node_ptr get_left() noexcept { return left_thread_ ? nullptr : left_; }
-    const_node_ptr get_left() const noexcept { return left_thread_ ? nullptr : left_; }
-    node_ptr get_left_unsafe() noexcept { return left_; }
-    const_node_ptr get_left_unsafe() const noexcept { return left_; }
-
-    virtual void set_left(node_ptr left) noexcept
-    {
-        do_set_left(left);
-        left_ = left;
-        left_thread_ = false;
-    }
-
-    bool has_left_thread() const noexcept { return left_thread_; }
-    virtual void set_left_thread(node_ptr left) noexcept
-    {
-        do_set_left_thread(left);
-        left_ = left;
-        left_thread_ = true;
-    }
-
-    node_ptr get_right() noexcept { return right_thread_ ? nullptr : right_; }
-    const_node_ptr get_right() const noexcept { return right_thread_ ? nullptr : right_; }
-    node_ptr get_right_unsafe() noexcept { return right_; }
-    const_node_ptr get_right_unsafe() const noexcept { return right_; }
-    void set_right(node_ptr right) noexcept
-    {
-        do_set_right(right);
-        right_ = right;
-        right_thread_ = false;
-    }
-
-    bool has_right_thread() const noexcept { return right_thread_; }
-    void set_right_thread(node_ptr right) noexcept
-    {
-        do_set_right_thread(right);
-        right_ = right;
-        right_thread_ = true;
-    }
-
     node_ptr get_parent() noexcept { return parent_; }
     const_node_ptr get_parent() const noexcept { return parent_; }
     void set_parent(node_ptr parent) noexcept { parent_ = parent; }
 
-    // Basic interface of a node in a binary search tree
-
-    bool is_left_child() const noexcept { return parent_ && this == parent_->left_; }
-
-    const_node_ptr maximum() const & noexcept { return do_maximum(*this); }
-    node_ptr maximum() & noexcept { return do_maximum(*this); }
-
-    const_node_ptr minimum() const & noexcept { return do_minimum(*this); }
-    node_ptr minimum() & noexcept { return do_minimum(*this); }
-
-    node_ptr successor() noexcept { return has_right_thread() ? right_ : right_->minimum(); }
-    const_node_ptr successor() const noexcept
+    bool is_left_child() const noexcept
     {
-        return has_right_thread() ? right_ : right_->minimum();
+        return parent_ && this == parent_->get_left_unsafe();
     }
 
-    node_ptr predecessor() noexcept { return has_left_thread() ? left_ : left_->maximum(); }
-    const_node_ptr predecessor() const noexcept
-    {
-        return has_left_thread() ? left_ : left_->maximum();
-    }
+    /*
+     * Setters above do not maintain augmented data of a node. Rotations are parameterized by the
+     * actual type of nodes and recompute subtree sizes of x and y if Node_T contains them; the
+     * sizes of all other nodes do not change. Pending lazy updates of x and y are pushed to their
+     * children first
+     */
 
     /*
      *   |               |
@@ -109,21 +55,23 @@ public:
      *    / \         / \
      *   b   c       a   b
      */
+    template<typename Node_T = Node_Base>
     void left_rotate() noexcept
     {
         assert(!has_right_thread());
 
-        node_ptr y = right_;
+        node_ptr y = untag(right_);
+        push_before_rotation<Node_T>(y);
 
         if (y->has_left_thread())
         {
             // if "b" is a thread, then "y" is the successor of "x"
-            assert(y->left_ == this);
+            assert(y->get_left_unsafe() == this);
             set_right_thread(y);
         }
         else
         {
-            node_ptr b = y->left_;
+            node_ptr b = untag(y->left_);
             set_right(b);
             b->parent_ = this;
         }
@@ -137,6 +85,8 @@ public:
             parent_->set_right(y);
 
         set_parent(y);
+
+        update_after_rotation<Node_T>(y);
     }
 
     /*
@@ -147,21 +97,23 @@ public:
      *    / \         / \
      *   b   c       a   b
      */
+    template<typename Node_T = Node_Base>
     void right_rotate() noexcept
     {
         assert(!has_left_thread());
 
-        node_ptr y = left_;
+        node_ptr y = untag(left_);
+        push_before_rotation<Node_T>(y);
 
         if (y->has_right_thread())
         {
             // if "b" is a thread, then "y" is the predecessor of "x"
-            assert(y->right_ == this);
+            assert(y->get_right_unsafe() == this);
             set_left_thread(y);
         }
         else
         {
-            node_ptr b = y->right_;
+            node_ptr b = untag(y->right_);
             set_left(b);
             b->parent_ = this;
         }
@@ -175,47 +127,42 @@ public:
             parent_->set_right(y);
 
         set_parent(y);
+
+        update_after_rotation<Node_T>(y);
     }
 
 protected:
 
-    // for additional actions on setting left/right child
-    virtual void do_set_left(node_ptr left) noexcept {}
-    virtual void do_set_left_thread(node_ptr right) noexcept {}
-    virtual void do_set_right(node_ptr right) noexcept {}
-    virtual void do_set_right_thread(node_ptr right) noexcept {}
-
-    template<typename Self>
-    static auto do_maximum(Self &self) noexcept
-        -> std::conditional_t<std::is_const_v<Self>,
-            typename Self::const_node_ptr, typename Self::node_ptr>
+    // pending updates of this node and y shall reach their children before the children move
+    template<typename Node_T>
+    void push_before_rotation(node_ptr y) noexcept
     {
-        auto node = &self;
-        while (!node->has_right_thread())
-            node = node->right_;
-
-        return node;
+        if constexpr (contains_pending_updates<Node_T>)
+        {
+            static_cast<Node_T *>(this)->push();
+            static_cast<Node_T *>(y)->push();
+        }
     }
 
-    template<typename Self>
-    static auto do_minimum(Self &self) noexcept
-        -> std::conditional_t<std::is_const_v<Self>,
-            typename Self::const_node_ptr, typename Self::node_ptr>
+    // this node has just become a child of y
+    template<typename Node_T>
+    void update_after_rotation(node_ptr y) noexcept
     {
-        auto node = &self;
-        while (!node->has_left_thread())
-            node = node->left_;
+        if constexpr (maintains_subtree_data<Node_T>)
+        {
+            static_assert(std::is_base_of_v<Node_Base, Node_T>);
 
-        return node;
+            static_cast<Node_T *>(this)->update();
+            static_cast<Node_T *>(y)->update();
+        }
     }
 
-    node_ptr left_;
-    node_ptr right_;
     node_ptr parent_;
-    bool left_thread_ = false;
-    bool right_thread_ = false;
 };
 
+static_assert(alignof(Node_Base) >= 2,
+              "The lowest bit of a node address is reserved for a thread flag");
+
 inline void dot_dump(std::ostream &os, const Node_Base &node)
 {
     fmt::print(os, "    node_{} [color = black, style = filled, fillcolor = olivedrab, "
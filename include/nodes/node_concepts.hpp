@@ -2,6 +2,7 @@
 #define INCLUDE_NODES_NODE_CONCEPTS_HPP
 
 #include <concepts>
+#include <cstddef>
 
 namespace yLab
 {
@@ -9,7 +10,7 @@ namespace yLab
 /*
  * There is a semantic rule additionally to the following concept.
  * Method size shall return the number of nodes in the subtree
- * rooted at the node pointed to by node_ptr
+ * rooted at the node pointed to by node_ptr (of occurrences of keys if nodes count them)
  */
 template<typename T>
 concept contains_subtree_size = requires(const T *node_ptr)
@@ -18,6 +19,98 @@ concept contains_subtree_size = requires(const T *node_ptr)
     { T::size(node_ptr) } -> std::convertible_to<typename T::size_type>;
 };
 
+/*
+ * Nodes keeping data about their subtrees. Method update shall recompute the data of the node from
+ * its key and the data of its children; it shall not throw
+ */
+template<typename T>
+concept maintains_subtree_data = requires(T *node_ptr)
+{
+    { node_ptr->update() } noexcept;
+};
+
+/*
+ * Monoid folding keys of type Key_T: lift maps a key to a value, combine shall be associative and
+ * identity shall be its neutral element
+ */
+template<typename M, typename Key_T>
+concept monoid_of = requires(const Key_T &key, const typename M::value_type &value)
+{
+    { M::identity() } -> std::convertible_to<typename M::value_type>;
+    { M::lift(key) } -> std::convertible_to<typename M::value_type>;
+    { M::combine(value, value) } -> std::convertible_to<typename M::value_type>;
+};
+
+/*
+ * There is a semantic rule additionally to the following concept.
+ * Method aggregate shall return the fold of keys of the subtree rooted at the node pointed to by
+ * node_ptr in ascending order
+ */
+template<typename T>
+concept contains_subtree_aggregate = requires(const T *node_ptr)
+{
+    typename T::monoid_type;
+    { T::aggregate(node_ptr) } -> std::convertible_to<typename T::monoid_type::value_type>;
+};
+
+// nodes of multisets storing the number of occurrences of their keys
+template<typename T>
+concept contains_key_count = requires(T *node_ptr, std::size_t count)
+{
+    { node_ptr->count() } -> std::convertible_to<std::size_t>;
+    node_ptr->set_count(count);
+};
+
+// nodes storing a mapped value next to the key; their values are pairs of both
+template<typename T>
+concept contains_mapped_value = requires(T *node_ptr)
+{
+    typename T::mapped_type;
+    { node_ptr->get_value().second } -> std::same_as<typename T::mapped_type &>;
+};
+
+/*
+ * Action updating payloads of keys lazily: apply shall not change the order of keys. Applying tag
+ * to a subtree of n keys maps its aggregate by apply_to_aggregate; compose(later, earlier) makes
+ * a tag equivalent to applying earlier and then later
+ */
+template<typename A, typename Key_T, typename Monoid>
+concept action_of = requires(Key_T &key, const typename A::tag_type &tag,
+                             const typename Monoid::value_type &value, std::size_t n)
+{
+    A::apply(key, tag);
+    { A::template apply_to_aggregate<Monoid>(value, tag, n) }
+        -> std::convertible_to<typename Monoid::value_type>;
+    { A::compose(tag, tag) } -> std::convertible_to<typename A::tag_type>;
+};
+
+// nodes that may keep an update pending for their children; push shall pass it on to them
+template<typename T>
+concept contains_pending_updates = requires(T *node_ptr)
+{
+    { node_ptr->push() } noexcept;
+};
+
+// nodes that mirror their subtrees lazily: links of a node may stay swapped until push()
+template<typename T>
+concept contains_pending_reversals = contains_pending_updates<T> && requires(const T *node_ptr)
+{
+    { node_ptr->has_pending_reversal() } -> std::same_as<bool>;
+};
+
+/*
+ * Nodes keeping a lazy update pending for their children. The key and the aggregate of the node
+ * already take the update into account
+ */
+template<typename T>
+concept contains_lazy_tags =
+    contains_subtree_aggregate<T> && contains_pending_updates<T> &&
+    requires(T *node_ptr, const typename T::tag_type &tag)
+{
+    typename T::action_type;
+    node_ptr->apply(tag);
+};
+
 } // namespace yLab
 
 #endif // INCLUDE_NODES_NODE_CONCEPTS_HPP
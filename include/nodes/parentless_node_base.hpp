@@ -0,0 +1,48 @@
+#ifndef INCLUDE_NODES_PARENTLESS_NODE_BASE_HPP
+#define INCLUDE_NODES_PARENTLESS_NODE_BASE_HPP
+
+#include <ostream>
+#include <cassert>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "nodes/threaded_node_base.hpp"
+
+namespace yLab
+{
+
+/*
+ * Base node of trees that restructure themselves top-down and, therefore, never climb up
+ * the tree: there is no pointer to the parent. Threads are still there, so iteration is O(1)
+ */
+class Parentless_Node_Base : public Threaded_Node_Base<Parentless_Node_Base>
+{
+    using base = Threaded_Node_Base<Parentless_Node_Base>;
+    using node_ptr = Parentless_Node_Base *;
+
+public:
+
+    Parentless_Node_Base(node_ptr left = nullptr, node_ptr right = nullptr) noexcept
+        : base{left, right} {}
+
+    // nodes of such trees are created without a parent
+    Parentless_Node_Base(node_ptr left, node_ptr right, [[maybe_unused]] node_ptr parent) noexcept
+        : base{left, right}
+    {
+        assert(parent == nullptr);
+    }
+};
+
+static_assert(alignof(Parentless_Node_Base) >= 2,
+              "The lowest bit of a node address is reserved for a thread flag");
+
+inline void dot_dump(std::ostream &os, const Parentless_Node_Base &node)
+{
+    fmt::print(os, "    node_{} [color = black, style = filled, fillcolor = olivedrab, "
+                   "label = \"end node\"];\n", fmt::ptr(&node));
+}
+
+} // namespace yLab
+
+#endif // INCLUDE_NODES_PARENTLESS_NODE_BASE_HPP
@@ -0,0 +1,150 @@
+#ifndef INCLUDE_NODES_THREADED_NODE_BASE_HPP
+#define INCLUDE_NODES_THREADED_NODE_BASE_HPP
+
+#include <cassert>
+#include <cstdint>
+
+namespace yLab
+{
+
+/*
+ * Links of a node of a threaded binary tree: two children and threads to the in-order
+ * predecessor and successor in place of missing children. Derived is the most derived base node
+ * type, so that the links point to it. Derived adds everything else: e.g. Node_Base adds a parent
+ * pointer and rotations
+ */
+template<typename Derived>
+class Threaded_Node_Base
+{
+    using node_ptr = Derived *;
+    using const_node_ptr = const Derived *;
+
+public:
+
+    using base_node_type = Derived;
+
+    Threaded_Node_Base(node_ptr left = nullptr, node_ptr right = nullptr) noexcept
+        : left_{tag(left, false)}, right_{tag(right, false)} {}
+
+    Threaded_Node_Base(const Threaded_Node_Base &rhs) = delete;
+    Threaded_Node_Base &operator=(const Threaded_Node_Base &rhs) = delete;
+
+    Threaded_Node_Base(Threaded_Node_Base &&rhs) = default;
+    Threaded_Node_Base &operator=(Threaded_Node_Base &&rhs) = default;
+
+    // getters and setters
+
+    /*
+     * _unsafe methods give you access to left_ and right_ pointers regardless of whether they
+     * represent a child or a thread; such methods shall be used after calling
+     * has_left_thread()/has_right_thread()
+     */
+
+    node_ptr get_left() noexcept { return has_left_thread() ? nullptr : untag(left_); }
+    const_node_ptr get_left() const noexcept
+    {
+        return has_left_thread() ? nullptr : untag(left_);
+    }
+    node_ptr get_left_unsafe() noexcept { return untag(left_); }
+    const_node_ptr get_left_unsafe() const noexcept { return untag(left_); }
+
+    void set_left(node_ptr left) noexcept { left_ = tag(left, false); }
+
+    bool has_left_thread() const noexcept { return left_ & thread_bit; }
+    void set_left_thread(node_ptr left) noexcept { left_ = tag(left, true); }
+
+    node_ptr get_right() noexcept { return has_right_thread() ? nullptr : untag(right_); }
+    const_node_ptr get_right() const noexcept
+    {
+        return has_right_thread() ? nullptr : untag(right_);
+    }
+    node_ptr get_right_unsafe() noexcept { return untag(right_); }
+    const_node_ptr get_right_unsafe() const noexcept { return untag(right_); }
+
+    void set_right(node_ptr right) noexcept { right_ = tag(right, false); }
+
+    bool has_right_thread() const noexcept { return right_ & thread_bit; }
+    void set_right_thread(node_ptr right) noexcept { right_ = tag(right, true); }
+
+    // copies the left link of rhs together with its thread flag
+    void copy_left_link(const Threaded_Node_Base &rhs) noexcept { left_ = rhs.left_; }
+    void copy_right_link(const Threaded_Node_Base &rhs) noexcept { right_ = rhs.right_; }
+
+    // Basic interface of a node in a threaded binary search tree
+
+    const_node_ptr maximum() const & noexcept { return do_maximum(self()); }
+    node_ptr maximum() & noexcept { return do_maximum(self()); }
+
+    const_node_ptr minimum() const & noexcept { return do_minimum(self()); }
+    node_ptr minimum() & noexcept { return do_minimum(self()); }
+
+    node_ptr successor() noexcept
+    {
+        return has_right_thread() ? untag(right_) : untag(right_)->minimum();
+    }
+    const_node_ptr successor() const noexcept
+    {
+        return has_right_thread() ? untag(right_) : untag(right_)->minimum();
+    }
+
+    node_ptr predecessor() noexcept
+    {
+        return has_left_thread() ? untag(left_) : untag(left_)->maximum();
+    }
+    const_node_ptr predecessor() const noexcept
+    {
+        return has_left_thread() ? untag(left_) : untag(left_)->maximum();
+    }
+
+protected:
+
+    node_ptr self() noexcept { return static_cast<node_ptr>(this); }
+    const_node_ptr self() const noexcept { return static_cast<const_node_ptr>(this); }
+
+    template<typename Node_Ptr>
+    static Node_Ptr do_maximum(Node_Ptr node) noexcept
+    {
+        while (!node->has_right_thread())
+            node = node->get_right_unsafe();
+
+        return node;
+    }
+
+    template<typename Node_Ptr>
+    static Node_Ptr do_minimum(Node_Ptr node) noexcept
+    {
+        while (!node->has_left_thread())
+            node = node->get_left_unsafe();
+
+        return node;
+    }
+
+    /*
+     * Thread flags live in the lowest bit of left_ and right_: nodes are at least pointer-aligned,
+     * so this bit of a node address is always zero and the flags take no extra space
+     */
+
+    using link_type = std::uintptr_t;
+
+    static constexpr link_type thread_bit = 1;
+
+    static link_type tag(const_node_ptr node, bool is_thread) noexcept
+    {
+        const auto link = reinterpret_cast<link_type>(node);
+        assert((link & thread_bit) == 0);
+
+        return link | (is_thread ? thread_bit : 0);
+    }
+
+    static node_ptr untag(link_type link) noexcept
+    {
+        return reinterpret_cast<node_ptr>(link & ~thread_bit);
+    }
+
+    link_type left_;
+    link_type right_;
+};
+
+} // namespace yLab
+
+#endif // INCLUDE_NODES_THREADED_NODE_BASE_HPP
@@ -5,18 +5,23 @@
 #include <iterator>
 #include <cstddef>
 #include <memory>
+#include <utility>
+#include <type_traits>
 
 #include "nodes/node_base.hpp"
+#include "nodes/parentless_node_base.hpp"
 
 namespace yLab
 {
 
+// Node_T::base_node_type is either Node_Base or Parentless_Node_Base
 template <typename Node_T>
-requires std::derived_from<Node_T, Node_Base>
+requires std::derived_from<Node_T, typename Node_T::base_node_type>
 class tree_iterator final
 {
+    using node_ptr = Node_T *;
     using const_node_ptr = const Node_T *;
-    using const_base_node_ptr = const Node_Base *;
+    using const_base_node_ptr = const typename Node_T::base_node_type *;
 
     const_base_node_ptr node_;
 
@@ -24,15 +29,16 @@ public:
 
     using iterator_category = std::bidirectional_iterator_tag;
     using difference_type = std::ptrdiff_t;
-    using value_type = typename Node_T::key_type;
-    using reference = const value_type &;
-    using pointer = const value_type *;
+    using value_type = typename Node_T::value_type;
+    // values of sets are constant keys; values of maps are pairs with a mutable mapped value
+    using reference = decltype(std::declval<Node_T &>().get_value());
+    using pointer = std::add_pointer_t<reference>;
 
     tree_iterator() = default;
     explicit tree_iterator(const_base_node_ptr node) noexcept : node_{node} {}
 
-    reference operator*() const { return get_key(); }
-    pointer operator->() const { return std::addressof(get_key()); }
+    reference operator*() const { return get_value(); }
+    pointer operator->() const { return std::addressof(get_value()); }
 
     tree_iterator &operator++() noexcept
     {
@@ -62,13 +68,15 @@ public:
 
     bool operator==(const tree_iterator &rhs) const noexcept { return node_ == rhs.node_; }
 
-    template<typename node_t, typename Compare>
-    requires std::derived_from<node_t, Node_Base>
-    friend class Search_Tree;
+    template<typename node_t, typename Compare, typename Allocator>
+    friend class Threaded_Tree;
 
 private:
 
-    reference get_key() const { return static_cast<const_node_ptr>(node_)->get_key(); }
+    reference get_value() const
+    {
+        return const_cast<node_ptr>(static_cast<const_node_ptr>(node_))->get_value();
+    }
 };
 
 } // namespace yLab
@@ -0,0 +1,531 @@
+#ifndef INCLUDE_TREES_IMPLICIT_SPLAY_SEQUENCE_HPP
+#define INCLUDE_TREES_IMPLICIT_SPLAY_SEQUENCE_HPP
+
+#include <utility>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <initializer_list>
+#include <type_traits>
+#include <algorithm>
+#include <memory>
+
+#include "nodes/node_base.hpp"
+#include "nodes/implicit_node.hpp"
+#include "trees/threaded_tree_base.hpp"
+#include "trees/splay_strategies.hpp"
+#include "tree_iterator.hpp"
+
+namespace yLab
+{
+
+/*
+ * Sequence of elements addressed by their positions (a rope): a threaded splay tree whose nodes
+ * are ordered by position, which is the number of nodes in the left subtrees on the way from the
+ * root. Access, insertion, erasure, cutting, splicing and reversal of a range take O(log n)
+ * amortized; a step of an iterator takes O(1) amortized.
+ *
+ * reverse() mirrors only the root of the subtree of the range and leaves the rest of the subtree
+ * to be mirrored on the way down by lookups. Iterators follow the threads that are valid only in
+ * a fully mirrored tree, so the first call of begin() or end() after reverse() pushes all pending
+ * reversals down in O(n)
+ */
+template<typename T, typename Allocator = std::allocator<T>>
+class Implicit_Splay_Sequence final : public Threaded_Tree_Base<Implicit_Node<T>, Allocator>
+{
+    using tree_base = Threaded_Tree_Base<Implicit_Node<T>, Allocator>;
+
+    using typename tree_base::node_type;
+    using typename tree_base::base_node_type;
+    using typename tree_base::base_node_ptr;
+    using typename tree_base::const_base_node_ptr;
+    using typename tree_base::node_ptr;
+    using typename tree_base::const_node_ptr;
+    using typename tree_base::node_allocator_type;
+    using typename tree_base::node_alloc_traits;
+
+public:
+
+    using value_type = T;
+    using pointer = value_type *;
+    using const_pointer = const value_type *;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using typename tree_base::size_type;
+    using difference_type = std::ptrdiff_t;
+    using iterator = tree_iterator<node_type>;
+    using const_iterator = iterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = reverse_iterator;
+    using typename tree_base::allocator_type;
+
+    Implicit_Splay_Sequence() : Implicit_Splay_Sequence(allocator_type()) {}
+
+    explicit Implicit_Splay_Sequence(const allocator_type &alloc) : tree_base(alloc) {}
+
+    template<std::input_iterator It>
+    Implicit_Splay_Sequence(It first, It last, const allocator_type &alloc = allocator_type())
+        : Implicit_Splay_Sequence(alloc)
+    {
+        for (; first != last; ++first)
+            push_back(*first);
+    }
+
+    Implicit_Splay_Sequence(std::initializer_list<value_type> ilist,
+                            const allocator_type &alloc = allocator_type())
+        : Implicit_Splay_Sequence(ilist.begin(), ilist.end(), alloc) {}
+
+    Implicit_Splay_Sequence(const Implicit_Splay_Sequence &rhs)
+        : Implicit_Splay_Sequence(rhs.begin(), rhs.end(),
+                                  node_alloc_traits::select_on_container_copy_construction(
+                                      rhs.alloc_)) {}
+
+    Implicit_Splay_Sequence &operator=(const Implicit_Splay_Sequence &rhs)
+    {
+        auto tmp_sequence{rhs};
+        swap(tmp_sequence);
+
+        return *this;
+    }
+
+    Implicit_Splay_Sequence(Implicit_Splay_Sequence &&rhs)
+        noexcept (std::is_nothrow_move_constructible_v<node_allocator_type>)
+        : tree_base(std::move(rhs)),
+          has_pending_reversals_{std::exchange(rhs.has_pending_reversals_, false)} {}
+
+    Implicit_Splay_Sequence &operator=(Implicit_Splay_Sequence &&rhs) noexcept (noexcept(swap(rhs)))
+    {
+        swap(rhs);
+        return *this;
+    }
+
+    ~Implicit_Splay_Sequence() = default;
+
+    // observers
+
+    using tree_base::get_allocator;
+
+    // capacity
+
+    size_type size() const noexcept { return node_type::size(root()); }
+    using tree_base::empty;
+
+    // iterators
+
+    const_iterator begin() const noexcept
+    {
+        push_all_reversals();
+        return const_iterator{get_leftmost()};
+    }
+
+    const_iterator end() const noexcept
+    {
+        push_all_reversals();
+        return const_iterator{&end_};
+    }
+
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
+
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    // element access
+
+    // both overloads splay the element at position pos to the root; pos shall be less than size()
+    reference operator[](size_type pos) { return static_cast<node_ptr>(access(pos))->get_key(); }
+
+    const_reference operator[](size_type pos) const
+    {
+        return static_cast<const_node_ptr>(access(pos))->get_key();
+    }
+
+    // modifiers
+
+    void swap(Implicit_Splay_Sequence &rhs)
+        noexcept (std::is_nothrow_swappable_v<node_allocator_type>)
+    {
+        tree_base::swap(rhs);
+        std::swap(has_pending_reversals_, rhs.has_pending_reversals_);
+    }
+
+    void clear() noexcept
+    {
+        clean_up();
+        reset();
+        has_pending_reversals_ = false;
+    }
+
+    /*
+     * Inserts value before position pos or at the end if pos == size(). The new node is linked as
+     * a leaf and splayed to the root, which makes it take one descent and one splay
+     */
+    iterator insert_at(size_type pos, const value_type &value)
+    {
+        assert(pos <= size());
+
+        base_node_ptr node = create_node(value);
+        base_node_ptr end_node = &end_;
+
+        if (pos == 0)
+            set_leftmost(node);
+        if (pos == size())
+            set_rightmost(node);
+
+        if (empty())
+        {
+            node->set_parent(end_node);
+            node->set_left_thread(end_node);
+            node->set_right_thread(end_node);
+            set_root(node);
+
+            return iterator{node};
+        }
+
+        for (auto parent = static_cast<node_ptr>(get_root()); ; )
+        {
+            parent->push();
+
+            auto left_size = node_type::size(static_cast<node_ptr>(parent->get_left()));
+
+            if (pos <= left_size)
+            {
+                if (base_node_ptr left = parent->get_left())
+                {
+                    parent = static_cast<node_ptr>(left);
+                    continue;
+                }
+
+                node->set_left_thread(parent->get_left_unsafe());
+                node->set_right_thread(parent);
+                parent->set_left(node);
+            }
+            else
+            {
+                pos -= left_size + 1;
+
+                if (base_node_ptr right = parent->get_right())
+                {
+                    parent = static_cast<node_ptr>(right);
+                    continue;
+                }
+
+                node->set_left_thread(parent);
+                node->set_right_thread(parent->get_right_unsafe());
+                parent->set_right(node);
+            }
+
+            node->set_parent(parent);
+            break;
+        }
+
+        // sizes of the ancestors of the node are fixed by the rotations
+        splay(node, end_node);
+
+        return iterator{node};
+    }
+
+    void push_back(const value_type &value) { insert_at(size(), value); }
+
+    // erases elements at positions [pos, pos + len)
+    void erase_range(size_type pos, size_type len) { extract(pos, len); }
+
+    // moves elements at positions [pos, pos + len) to a new sequence
+    Implicit_Splay_Sequence extract(size_type pos, size_type len)
+    {
+        assert(pos <= size() && len <= size() - pos);
+
+        // both sequences share the allocator as nodes of one of them are freed by the other
+        Implicit_Splay_Sequence result{get_allocator()};
+        if (len == 0)
+            return result;
+
+        auto range = isolate(pos, len);
+        unlink_range(range);
+
+        base_node_ptr result_end = &result.end_;
+        range.first->set_parent(result_end);
+        range.first->set_left_thread(result_end);
+        range.last->set_right_thread(result_end);
+
+        result.set_root(range.first);
+        result.set_leftmost(range.first);
+        result.set_rightmost(range.last);
+        result.has_pending_reversals_ = has_pending_reversals_;
+
+        return result;
+    }
+
+    // moves all elements of rhs before position pos or to the end if pos == size()
+    void splice(size_type pos, Implicit_Splay_Sequence &&rhs)
+    {
+        assert(pos <= size());
+        assert(this != &rhs);
+
+        if (rhs.empty())
+            return;
+
+        adopt_allocator_of(rhs);
+
+        auto range = isolate(pos, 0);
+        base_node_ptr first = rhs.get_leftmost();
+        base_node_ptr last = rhs.get_rightmost();
+        base_node_ptr root = rhs.get_root();
+
+        rhs.adjust_tree_to_end_nodes(range.before, range.after);
+        has_pending_reversals_ = has_pending_reversals_ || rhs.has_pending_reversals_;
+        rhs.reset();
+        rhs.has_pending_reversals_ = false;
+
+        link_range(root, first, last, range);
+    }
+
+    // reverses the order of elements at positions [pos, pos + len)
+    void reverse(size_type pos, size_type len)
+    {
+        assert(pos <= size() && len <= size() - pos);
+
+        if (len < 2)
+            return;
+
+        auto range = isolate(pos, len);
+        auto first = static_cast<node_ptr>(range.first);
+
+        // the first node is the root of the range and the last node is its right child
+        first->reverse();
+        has_pending_reversals_ = true;
+
+        // the first and the last nodes change places, so the threads leading out of the range
+        // swap their targets; the links of the last node are yet to be swapped by push()
+        first->set_right_thread(range.after);
+        range.last->set_right_thread(range.before);
+
+        if (range.before == &end_)
+            set_leftmost(range.last);
+        if (range.after == &end_)
+            set_rightmost(range.first);
+    }
+
+private:
+
+    using tree_base::get_root;
+    using tree_base::set_root;
+    using tree_base::get_leftmost;
+    using tree_base::set_leftmost;
+    using tree_base::get_rightmost;
+    using tree_base::set_rightmost;
+    using tree_base::create_node;
+    using tree_base::adopt_allocator_of;
+    using tree_base::clean_up;
+    using tree_base::reset;
+    using tree_base::adjust_tree_to_end_nodes;
+    using tree_base::update_node;
+
+    const_node_ptr root() const noexcept { return static_cast<const_node_ptr>(get_root()); }
+
+    // pushes all pending reversals down to the leaves visiting every node before its children
+    void push_all_reversals() const noexcept
+    {
+        if (!has_pending_reversals_)
+            return;
+
+        auto root = const_cast<base_node_ptr>(get_root());
+
+        for (base_node_ptr node = root; node; )
+        {
+            static_cast<node_ptr>(node)->push();
+
+            if (base_node_ptr left = node->get_left())
+                node = left;
+            else if (base_node_ptr right = node->get_right())
+                node = right;
+            else
+            {
+                // climbs to the nearest ancestor with a right subtree not visited yet
+                for (;;)
+                {
+                    if (node == root)
+                    {
+                        node = nullptr;
+                        break;
+                    }
+
+                    base_node_ptr parent = node->get_parent();
+                    if (node->is_left_child() && parent->get_right())
+                    {
+                        node = parent->get_right();
+                        break;
+                    }
+
+                    node = parent;
+                }
+            }
+        }
+
+        has_pending_reversals_ = false;
+    }
+
+    /*
+     * Descends to the node at position k. Pending reversals are pushed down the path, so that the
+     * links of every node on it are valid
+     */
+    base_node_ptr select_node(size_type k) const noexcept
+    {
+        assert(k < size());
+
+        auto node = const_cast<node_ptr>(root());
+
+        for (;;)
+        {
+            node->push();
+
+            auto left = static_cast<node_ptr>(node->get_left());
+            auto left_size = node_type::size(left);
+
+            if (k < left_size)
+                node = left;
+            else if (k == left_size)
+                return node;
+            else
+            {
+                k -= left_size + 1;
+                node = static_cast<node_ptr>(node->get_right());
+            }
+        }
+    }
+
+    // makes node a child of top, which is an ancestor of the node or the end node
+    static void splay(base_node_ptr node, const_base_node_ptr top) noexcept
+    {
+        Full_Splay::splay<node_type>(node, top);
+    }
+
+    base_node_ptr access(size_type pos) const noexcept
+    {
+        base_node_ptr node = select_node(pos);
+        splay(node, &end_);
+
+        return node;
+    }
+
+    struct Range final
+    {
+        base_node_ptr before; // the node preceding the range or the end node
+        base_node_ptr after;  // the node following the range or the end node
+        base_node_ptr parent; // the parent of the subtree of the range
+        base_node_ptr first = nullptr;
+        base_node_ptr last = nullptr;
+    };
+
+    /*
+     * Splays the node preceding [pos, pos + len) to the root and the node following it right
+     * below, so that the range makes up one subtree. The first node of the range is splayed to
+     * the root of this subtree and the last one to the right child of the first one: these are
+     * the only nodes of the range with threads leading out of it
+     */
+    Range isolate(size_type pos, size_type len) const noexcept
+    {
+        auto end_node = const_cast<base_node_ptr>(&end_);
+        Range range{end_node, end_node, end_node};
+
+        if (pos != 0)
+        {
+            range.before = select_node(pos - 1);
+            splay(range.before, range.parent);
+            range.parent = range.before;
+        }
+
+        if (pos + len != size())
+        {
+            range.after = select_node(pos + len);
+            splay(range.after, range.parent);
+            range.parent = range.after;
+        }
+
+        if (len != 0)
+        {
+            range.first = range.last = select_node(pos);
+            splay(range.first, range.parent);
+
+            if (len != 1)
+            {
+                range.last = select_node(pos + len - 1);
+                splay(range.last, range.first);
+            }
+        }
+
+        return range;
+    }
+
+    // the subtree of root takes the place of the empty range
+    void link_range(base_node_ptr root, base_node_ptr first, base_node_ptr last,
+                    const Range &range) noexcept
+    {
+        base_node_ptr end_node = &end_;
+
+        root->set_parent(range.parent);
+
+        if (range.parent == end_node)
+            set_root(root);
+        else if (range.parent == range.after)
+            range.after->set_left(root);
+        else
+            range.before->set_right(root);
+
+        update_parents(range);
+
+        if (range.before == end_node)
+            set_leftmost(first);
+        if (range.after == end_node)
+            set_rightmost(last);
+    }
+
+    // cuts the subtree of the range off the tree
+    void unlink_range(const Range &range) noexcept
+    {
+        base_node_ptr end_node = &end_;
+
+        if (range.parent == end_node)
+            set_root(nullptr);
+        else if (range.parent == range.after)
+            range.after->set_left_thread(range.before);
+        else
+            range.before->set_right_thread(range.after);
+
+        update_parents(range);
+
+        if (range.before == end_node)
+            set_leftmost(range.after);
+        if (range.after == end_node)
+            set_rightmost(range.before);
+    }
+
+    void update_parents(const Range &range) noexcept
+    {
+        base_node_ptr end_node = &end_;
+
+        if (range.after != end_node)
+            update_node(range.after);
+        if (range.before != end_node)
+            update_node(range.before);
+    }
+
+    using tree_base::end_;
+
+    mutable bool has_pending_reversals_ = false;
+};
+
+template<typename T, typename Allocator>
+bool operator==(const Implicit_Splay_Sequence<T, Allocator> &lhs,
+                const Implicit_Splay_Sequence<T, Allocator> &rhs)
+{
+    return (lhs.size() == rhs.size()) &&
+           (std::equal(lhs.begin(), lhs.end(), rhs.begin()));
+}
+
+} // namespace yLab
+
+#endif // INCLUDE_TREES_IMPLICIT_SPLAY_SEQUENCE_HPP
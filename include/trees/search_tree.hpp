@@ -12,61 +12,108 @@
 #include <ostream>
 #include <algorithm>
 #include <compare>
+#include <memory>
+#include <future>
+#include <thread>
+#include <bit>
+#include <span>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include "nodes/node_base.hpp"
 #include "nodes/node_concepts.hpp"
-#include "tree_iterator.hpp"
+#include "trees/threaded_tree.hpp"
+#include "node_handle.hpp"
 
 namespace yLab
 {
 
-template<typename Node_T, typename Compare = std::less<typename Node_T::key_type>>
+// the shape of a copy of a tree: the same as the one of the original or perfectly balanced
+enum class Copy_Shape { preserve, balance };
+
+// selects overloads of operations that share the work between several threads
+struct Parallel_Tag final
+{
+    explicit Parallel_Tag() = default;
+};
+
+inline constexpr Parallel_Tag parallel{};
+
+template<typename Node_T, typename Compare = std::less<typename Node_T::key_type>,
+         typename Allocator = std::allocator<typename Node_T::key_type>>
 requires std::derived_from<Node_T, Node_Base>
-class Search_Tree
+class Search_Tree : public Threaded_Tree<Node_T, Compare, Allocator>
 {
+    using tree_base = Threaded_Tree<Node_T, Compare, Allocator>;
+
 protected:
 
-    using base_node_type = Node_Base;
-    using base_node_ptr = base_node_type *;
-    using const_base_node_ptr = const base_node_type *;
-    using node_ptr = Node_T *;
-    using const_node_ptr = const Node_T *;
-    using node_type = Node_T;
+    using typename tree_base::base_node_type;
+    using typename tree_base::base_node_ptr;
+    using typename tree_base::const_base_node_ptr;
+    using typename tree_base::node_ptr;
+    using typename tree_base::const_node_ptr;
+    using typename tree_base::node_type;
+    using typename tree_base::node_allocator_type;
+    using typename tree_base::node_alloc_traits;
 
 public:
 
-    using key_type = typename node_type::key_type;
-    using key_compare = Compare;
-    using value_type = key_type;
-    using value_compare = key_compare;
-    using pointer = value_type *;
-    using const_pointer = const value_type *;
-    using reference = value_type &;
-    using const_reference = const value_type &;
-    using size_type = std::size_t;
-    using difference_type = std::ptrdiff_t;
-    using iterator = tree_iterator<node_type>;
-    using const_iterator = iterator;
-    using reverse_iterator = std::reverse_iterator<iterator>;
-    using const_reverse_iterator = reverse_iterator;
+    using typename tree_base::key_type;
+    using typename tree_base::key_compare;
+    using typename tree_base::value_type;
+    using typename tree_base::value_compare;
+    using typename tree_base::pointer;
+    using typename tree_base::const_pointer;
+    using typename tree_base::reference;
+    using typename tree_base::const_reference;
+    using typename tree_base::size_type;
+    using typename tree_base::difference_type;
+    using typename tree_base::iterator;
+    using typename tree_base::const_iterator;
+    using typename tree_base::reverse_iterator;
+    using typename tree_base::const_reverse_iterator;
+    using typename tree_base::allocator_type;
+    using node_handle = Node_Handle<node_type, node_allocator_type>;
+    using insert_return_type = Node_Insert_Result<iterator, node_handle>;
 
     Search_Tree() : Search_Tree(key_compare()) {}
 
-    explicit Search_Tree(const key_compare &comp) : comp_(comp) {}
+    explicit Search_Tree(const key_compare &comp, const allocator_type &alloc = allocator_type())
+        : tree_base(comp, alloc) {}
+
+    explicit Search_Tree(const allocator_type &alloc) : Search_Tree(key_compare(), alloc) {}
 
     template<std::input_iterator It>
-    Search_Tree(It first, It last, const key_compare &comp = key_compare()) : Search_Tree(comp)
+    Search_Tree(It first, It last, const key_compare &comp = key_compare(),
+                const allocator_type &alloc = allocator_type())
+        : Search_Tree(comp, alloc)
     {
         insert(first, last);
     }
 
-    Search_Tree(std::initializer_list<value_type> ilist, const key_compare &comp = key_compare())
-               : Search_Tree(ilist.begin(), ilist.end(), comp) {}
+    Search_Tree(std::initializer_list<value_type> ilist, const key_compare &comp = key_compare(),
+                const allocator_type &alloc = allocator_type())
+               : Search_Tree(ilist.begin(), ilist.end(), comp, alloc) {}
+
+    Search_Tree(const Search_Tree &rhs) : Search_Tree(rhs, Copy_Shape::preserve) {}
 
-    Search_Tree(const Search_Tree &rhs) : Search_Tree(rhs.begin(), rhs.end(), rhs.comp_) {}
+    // both kinds of copies take O(n) and make no comparisons
+    Search_Tree(const Search_Tree &rhs, Copy_Shape shape)
+        : Search_Tree(rhs.comp_,
+                      node_alloc_traits::select_on_container_copy_construction(rhs.alloc_))
+    {
+        // balanced copies are built from keys, which would lose counts of repeated keys
+        if (shape == Copy_Shape::balance && !contains_key_count<node_type>)
+            load_sorted_prefix(rhs.begin(), rhs.end());
+        else
+            clone_tree_of(rhs);
+    }
 
     Search_Tree &operator=(const Search_Tree &rhs)
     {
@@ -76,12 +123,7 @@ public:
         return *this;
     }
 
-    Search_Tree(Search_Tree &&rhs) noexcept (std::is_nothrow_move_constructible_v<key_compare>)
-        : size_{std::exchange(rhs.size_, 0)}, comp_(std::move(rhs.comp_))
-    {
-        if (rhs.get_root())
-            take_ownership_of_tree_of(rhs);
-    }
+    Search_Tree(Search_Tree &&rhs) = default;
 
     Search_Tree &operator=(Search_Tree &&rhs) noexcept (noexcept(swap(rhs)))
     {
@@ -89,31 +131,20 @@ public:
         return *this;
     }
 
-    virtual ~Search_Tree() { clean_up(); }
-
-    // observers
-
-    key_compare key_comp() const { return comp_; }
-    value_compare value_comp() const { return key_comp(); }
-
-    // capacity
-
-    size_type size() const noexcept { return size_; }
-    bool empty() const noexcept { return size() == 0; }
+    virtual ~Search_Tree() = default;
 
-    // iterators
+    /*
+     * Copies of trees at least this large preserving the shape are made by several threads if
+     * the allocator is always equal: each thread copies its own subtree
+     */
+    static constexpr size_type parallel_copy_threshold = 1 << 16;
 
-    const_iterator begin() const noexcept { return const_iterator{get_leftmost()}; }
-    const_iterator end() const noexcept { return const_iterator{&end_}; }
-
-    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
-    const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
-
-    const_iterator cbegin() const noexcept { return begin(); }
-    const_iterator cend() const noexcept { return end(); }
-
-    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
-    const_reverse_iterator crend() const noexcept { return rend(); }
+    using tree_base::begin;
+    using tree_base::end;
+    using tree_base::size;
+    using tree_base::empty;
+    using tree_base::swap;
+    using tree_base::clear;
 
     // lookup
 
@@ -123,8 +154,36 @@ public:
         return const_iterator{node};
     }
 
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    const_iterator find(const K &key) const
+    {
+        auto node = do_find(key);
+        return const_iterator{node};
+    }
+
     bool contains(const key_type &key) const { return find(key) != end(); }
 
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    bool contains(const K &key) const { return find(key) != end(); }
+
+    // the number of occurrences of key: at most 1 unless nodes count repeated keys
+    size_type count(const key_type &key) const { return count_of(find(key)); }
+
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    size_type count(const K &key) const { return count_of(find(key)); }
+
+    // the number of occurrences of all keys; equals size() unless nodes count repeated keys
+    size_type total_count() const
+    {
+        if constexpr (contains_key_count<node_type>)
+            return node_type::size(static_cast<const_node_ptr>(get_root()));
+        else
+            return size();
+    }
+
     // Finds first element that is not less than key
     const_iterator lower_bound(const key_type &key) const
     {
@@ -132,6 +191,14 @@ public:
         return const_iterator{node};
     }
 
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    const_iterator lower_bound(const K &key) const
+    {
+        auto node = do_lower_bound(key);
+        return const_iterator{node};
+    }
+
     // Finds first element that is greater than key
     const_iterator upper_bound(const key_type &key) const
     {
@@ -139,240 +206,685 @@ public:
         return const_iterator{node};
     }
 
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    const_iterator upper_bound(const K &key) const
+    {
+        auto node = do_upper_bound(key);
+        return const_iterator{node};
+    }
+
     // Modifiers
 
-    void swap(Search_Tree &rhs) noexcept (std::is_nothrow_swappable_v<key_compare>)
+    /*
+     * The flag tells whether the key is new. A multiset counts one more occurrence of a key it
+     * already contains instead
+     */
+    std::pair<iterator, bool> insert(const value_type &value)
     {
-        if (get_root())
-        {
-            if (rhs.get_root())
-            {
-                adjust_tree_to_end_node_of(rhs);
-                rhs.adjust_tree_to_end_node_of(*this);
-                std::swap(end_, rhs.end_);
-            }
-            else
-                rhs.take_ownership_of_tree_of(*this);
-        }
-        else if (rhs.get_root())
-            take_ownership_of_tree_of(rhs);
+        auto res = insert_unique(node_type::key_of_value(value), value);
+        count_repeated_key(res);
 
-        std::swap(size_, rhs.size_);
-        std::swap(comp_, rhs.comp_);
+        return res;
     }
 
-    void clear() noexcept
+    std::pair<iterator, bool> insert(value_type &&value)
     {
-        clean_up();
-        reset();
-        size_ = 0;
+        auto res = insert_unique(node_type::key_of_value(value), std::move(value));
+        count_repeated_key(res);
+
+        return res;
     }
 
-    std::pair<iterator, bool> insert(const key_type &key)
+    /*
+     * Constructs the value from args right in a new node. A value passed as the only argument is
+     * looked up before the node is created; otherwise the node is freed if its key is not new
+     */
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args &&... args)
     {
-        auto [node, parent] = find_with_parent(key);
-
-        if (node == nullptr)
+        if constexpr (sizeof...(Args) == 1 &&
+                      (std::same_as<std::remove_cvref_t<Args>, value_type> && ...))
+            return insert(std::forward<Args>(args)...);
+        else
         {
-            node = do_insert(key, const_cast<base_node_ptr>(parent));
+            node_ptr node = create_node(std::in_place, std::forward<Args>(args)...);
+            auto res = link_or_destroy(node, find_insert_position(key_of(node)));
+            count_repeated_key(res);
 
-            if (size() == 0)
-            {
-                set_leftmost(const_cast<base_node_ptr>(node));
-                set_rightmost(const_cast<base_node_ptr>(node));
-            }
-            else if (comp_(key, *begin()))
-                set_leftmost(const_cast<base_node_ptr>(node));
-            else if (comp_(static_cast<node_ptr>(get_rightmost())->get_key(), key))
-                set_rightmost(const_cast<base_node_ptr>(node));
+            return res;
+        }
+    }
 
-            size_++;
+    /*
+     * Hinted insertion: if the key belongs right before hint, the new node is attached next to
+     * hint or to its predecessor without a descent from the root; otherwise the key is looked up
+     * from the root. Passing end() as the hint appends keys arriving in ascending order. The cost
+     * of the check is given at find_insert_position()
+     */
 
-            return std::pair{iterator{node}, true};
-        }
+    iterator insert(const_iterator hint, const value_type &value)
+    {
+        auto res = insert_at(find_insert_position(hint, node_type::key_of_value(value)), value);
+        count_repeated_key(res);
+
+        return res.first;
+    }
+
+    iterator insert(const_iterator hint, value_type &&value)
+    {
+        auto res = insert_at(find_insert_position(hint, node_type::key_of_value(value)),
+                             std::move(value));
+        count_repeated_key(res);
+
+        return res.first;
+    }
+
+    template<typename... Args>
+    iterator emplace_hint(const_iterator hint, Args &&... args)
+    {
+        if constexpr (sizeof...(Args) == 1 &&
+                      (std::same_as<std::remove_cvref_t<Args>, value_type> && ...))
+            return insert(hint, std::forward<Args>(args)...);
         else
-            return std::pair{iterator{node}, false};
+        {
+            node_ptr node = create_node(std::in_place, std::forward<Args>(args)...);
+            auto res = link_or_destroy(node, find_insert_position(hint, key_of(node)));
+            count_repeated_key(res);
+
+            return res.first;
+        }
     }
 
     template<std::input_iterator It>
     void insert(It first, It last)
     {
+        if (empty())
+            first = load_sorted_prefix(std::move(first), last);
+
         for (; first != last; ++first)
             insert(*first);
     }
 
+    // replaces the content of the tree with keys from [first, last) in O(n) if they are sorted
+    template<std::input_iterator It>
+    void assign_sorted(It first, It last)
+    {
+        clear();
+        insert(std::move(first), last);
+    }
+
     void insert(std::initializer_list<value_type> ilist) { insert(ilist.begin(), ilist.end()); }
 
+    // maps: the mapped value is constructed from args only if key is not in the tree yet
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args)
+    requires contains_mapped_value<node_type>
+    {
+        return insert_unique(key, std::in_place, std::piecewise_construct,
+                             std::forward_as_tuple(key),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&obj)
+    requires contains_mapped_value<node_type>
+    {
+        auto res = try_emplace(key, std::forward<M>(obj));
+        if (!res.second)
+            res.first->second = std::forward<M>(obj);
+
+        return res;
+    }
+
+    template<contains_mapped_value Node = node_type>
+    typename Node::mapped_type &operator[](const key_type &key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    template<contains_mapped_value Node = node_type>
+    typename Node::mapped_type &at(const key_type &key)
+    {
+        if (auto it = find(key); it != end())
+            return it->second;
+
+        throw std::out_of_range{"yLab::Search_Tree::at: no such key"};
+    }
+
+    template<contains_mapped_value Node = node_type>
+    const typename Node::mapped_type &at(const key_type &key) const
+    {
+        if (auto it = find(key); it != end())
+            return it->second;
+
+        throw std::out_of_range{"yLab::Search_Tree::at: no such key"};
+    }
+
     iterator erase(iterator pos)
     {
-        base_node_ptr node = base_ptr(pos);
         auto res = std::next(pos);
+        destroy_node(detach_node(pos));
 
-        if (node == get_leftmost())
-            set_leftmost(base_ptr(res));
+        return res;
+    }
 
-        if (node == get_rightmost())
-            set_rightmost(size() == 1 ? &end_ : base_ptr(std::prev(pos)));
+    // erases all occurrences of key and returns their number
+    size_type erase(const key_type &key) { return erase_key_at(find(key)); }
 
-        unlink_node(node);
-        size_--;
+    template<typename K>
+    requires transparent_comparator<key_compare> && (!std::convertible_to<K, iterator>)
+    size_type erase(const K &key) { return erase_key_at(find(key)); }
 
-        delete node;
+    // erases one occurrence of key from a multiset; returns the number of erased keys
+    size_type erase_one(const key_type &key)
+    requires contains_key_count<node_type>
+    {
+        return erase_one_at(find(key));
+    }
 
-        return res;
+    template<typename K>
+    requires contains_key_count<node_type> && transparent_comparator<key_compare>
+    size_type erase_one(const K &key) { return erase_one_at(find(key)); }
+
+    /*
+     * Node handles: extract() unlinks a node from the tree without freeing it, insert() links the
+     * node of a handle without allocating. A node handle may be inserted into any tree of the same
+     * type which allocator is equal to the one of the tree the node was extracted from or can
+     * adopt it. A node of a multiset carries all occurrences of its key
+     */
+
+    node_handle extract(const_iterator pos)
+    {
+        assert(pos != end());
+        return node_handle{static_cast<node_ptr>(detach_node(pos)), alloc_};
     }
 
-    size_type erase(const key_type &key)
+    node_handle extract(const key_type &key)
     {
-        if (auto it = find(key); it == end())
-            return 0;
-        else
+        auto it = find(key);
+        return (it == end()) ? node_handle{} : extract(it);
+    }
+
+    // a node which key is in the tree is given back; a multiset adds its occurrences instead
+    insert_return_type insert(node_handle &&handle)
+    {
+        if (handle.empty())
+            return insert_return_type{end(), false, node_handle{}};
+
+        return insert_handle(std::move(handle), find_insert_position(key_of(handle.node_)));
+    }
+
+    iterator insert(const_iterator hint, node_handle &&handle)
+    {
+        if (handle.empty())
+            return end();
+
+        return insert_handle(std::move(handle),
+                             find_insert_position(hint, key_of(handle.node_))).position;
+    }
+
+    /*
+     * Moves every node of source which key is not in the tree into the tree without reallocation.
+     * Both trees are walked in ascending order by their threads, and the hint follows the keys of
+     * source, so every node is linked right before the hint without a descent from the root:
+     * interleaving trees are merged in O(n + m). Where more than merge_walk_limit keys of the tree
+     * separate two consecutive keys of source, the hint jumps by lower_bound() instead, so a few
+     * keys merged into a large tree cost O(log n) each
+     */
+    void merge(Search_Tree &source)
+    {
+        if (&source == this)
+            return;
+
+        adopt_allocator_of(source);
+        // keys of source are read as they are, and its nodes come without pending updates
+        source.push_all_tags();
+
+        auto hint = begin();
+        for (auto it = source.begin(), ite = source.end(); it != ite;)
         {
-            erase(it);
-            return 1;
+            const key_type &key = key_of(it);
+
+            // moves the hint to the lower bound of key
+            for (size_type n_steps = 0; hint != end() && comp_(key_of(hint), key); ++hint)
+            {
+                if (++n_steps > merge_walk_limit)
+                {
+                    hint = lower_bound(key);
+                    break;
+                }
+            }
+
+            auto [found, parent] = find_insert_position(hint, key);
+
+            if (!found)
+            {
+                base_node_ptr node = source.detach_node(std::exchange(it, std::next(it)));
+                link_new_node(node, const_cast<base_node_ptr>(parent));
+            }
+            else if constexpr (contains_key_count<node_type>)
+            {
+                add_occurrences(const_cast<base_node_ptr>(found), weight(const_base_ptr(it)));
+                it = source.erase(it);
+            }
+            else
+                ++it;
         }
     }
 
-    void graphic_dump(std::ostream &os) const
+protected:
+
+    using tree_base::unknown_size;
+    using tree_base::const_base_ptr;
+    using tree_base::base_ptr;
+    using tree_base::const_ptr;
+    using tree_base::ptr;
+    using tree_base::key_of;
+    using tree_base::weight;
+    using tree_base::get_root;
+    using tree_base::set_root;
+    using tree_base::get_leftmost;
+    using tree_base::set_leftmost;
+    using tree_base::get_rightmost;
+    using tree_base::set_rightmost;
+    using tree_base::create_node;
+    using tree_base::destroy_node;
+    using tree_base::adopt_allocator_of;
+    using tree_base::adopt_allocator;
+    using tree_base::clean_up;
+    using tree_base::reset;
+    using tree_base::take_ownership_of_tree_of;
+    using tree_base::update_node;
+    using tree_base::load_sorted_prefix;
+    using tree_base::link_list;
+    using tree_base::end_;
+    using tree_base::size_;
+    using tree_base::comp_;
+    using tree_base::alloc_;
+
+    /*
+     * The number of keys merge() steps over by threads before it looks the next key up from the
+     * root: a descent costs about as many comparisons in a tree of 2^8 keys, while a step along a
+     * thread neither splays nor leaves the neighbourhood of the hint
+     */
+    static constexpr size_type merge_walk_limit = 8;
+
+    // helpers of lookups and erasure by keys of any type; it may be the end iterator
+
+    size_type count_of(const_iterator it) const noexcept
     {
-        os << "digraph Tree\n"
-              "{\n"
-              "    rankdir = TB;\n"
-              "    node [shape = record];\n\n";
+        return (it == end()) ? 0 : weight(const_base_ptr(it));
+    }
 
-        auto end_node = const_base_ptr(end());
+    size_type erase_key_at(iterator it)
+    {
+        if (it == end())
+            return 0;
 
-        dot_dump(os, *end_node);
-        dump_subtree(os, static_cast<const_node_ptr>(get_root()));
+        auto n_erased = weight(const_base_ptr(it));
+        erase(it);
 
-        os << '\n';
+        return n_erased;
+    }
 
-        for (auto node = const_base_ptr(begin()); node != end_node; node = node->successor())
-            arrow_dump(os, node);
+    size_type erase_one_at(iterator it)
+    requires contains_key_count<node_type>
+    {
+        if (it == end())
+            return 0;
 
-        if (!empty())
-            fmt::print(os, "    node_{} -> node_{} [color = \"blue\"];\n",
-                       fmt::ptr(end_node), fmt::ptr(end_node->get_left_unsafe()));
+        if (node_ptr node = ptr(it); node->count() > 1)
+        {
+            node->set_count(node->count() - 1);
+            update_path(node->get_parent());
+        }
+        else
+            erase(it);
 
-        os << '}' << std::endl;
+        return 1;
     }
 
-    bool subtree_sizes_verifier() const
-    requires contains_subtree_size<node_type>
+    // copies the nodes of rhs into this empty tree keeping their shape
+    void clone_tree_of(const Search_Tree &rhs)
     {
-        for (auto it = begin(), ite = end(); it != ite; ++it)
-        {
-            const_node_ptr node = const_ptr(it);
+        assert(get_root() == nullptr);
 
-            auto expected_size = 1 + node_type::size(static_cast<const_node_ptr>(node->get_left()))
-                                   + node_type::size(static_cast<const_node_ptr>(node->get_right()));
+        const_base_node_ptr rhs_root = rhs.get_root();
+        if (!rhs_root)
+            return;
 
-            if (expected_size != node_type::size(node))
-                return false;
+        rhs.push_all_tags();
+
+        base_node_ptr end_node = &end_;
+        base_node_ptr root = clone_node(rhs_root, end_node);
+        set_root(root);
+
+        try
+        {
+            clone_subtree(rhs_root, root, end_node, end_node, parallel_copy_depth(rhs.size()));
+        }
+        catch (...)
+        {
+            clean_up();
+            reset();
+            throw;
         }
 
-        return true;
+        set_leftmost(root->minimum());
+        set_rightmost(root->maximum());
+        size_ = rhs.size_;
     }
 
-protected:
+    base_node_ptr clone_node(const_base_node_ptr source, base_node_ptr parent)
+    {
+        node_ptr copy = create_node(static_cast<const_node_ptr>(source)->get_value(), nullptr,
+                                    nullptr, parent);
 
-    // access to underlying pointer of iterators
+        if constexpr (contains_key_count<node_type>)
+            copy->set_count(weight(source));
 
-    static const_base_node_ptr const_base_ptr(iterator it) noexcept { return it.node_; }
+        return copy;
+    }
 
-    static base_node_ptr base_ptr(iterator it) noexcept
+    // the number of levels of recursion at which the work is forked to keep all cores busy
+    static unsigned parallel_depth() noexcept
     {
-        return const_cast<base_node_ptr>(const_base_ptr(it));
+        return std::bit_width(std::max(1u, std::thread::hardware_concurrency())) - 1;
     }
 
-    static const_node_ptr const_ptr(iterator it) noexcept
+    // the number of levels of the tree at which copying of subtrees is split between threads
+    static unsigned parallel_copy_depth(size_type n_nodes) noexcept
     {
-        return static_cast<const_node_ptr>(const_base_ptr(it));
+        if constexpr (node_alloc_traits::is_always_equal::value)
+        {
+            if (n_nodes >= parallel_copy_threshold)
+                return parallel_depth();
+        }
+
+        return 0;
     }
 
-    static node_ptr ptr(iterator it) noexcept { return const_cast<node_ptr>(const_ptr(it)); }
+    /*
+     * Copies descendants of source under copy, which is a copy of source linked to its parent.
+     * The first and the last nodes of the subtree are threaded to prev and next. At the top depth
+     * levels the left subtree is copied by another thread
+     */
+    void clone_subtree(const_base_node_ptr source, base_node_ptr copy,
+                       base_node_ptr prev, base_node_ptr next, unsigned depth)
+    {
+        if (depth != 0 && !source->has_left_thread() && !source->has_right_thread())
+        {
+            const_base_node_ptr source_left = source->get_left_unsafe();
+            const_base_node_ptr source_right = source->get_right_unsafe();
 
-    // end-node routines
+            base_node_ptr left = clone_node(source_left, copy);
+            copy->set_left(left);
+            base_node_ptr right = clone_node(source_right, copy);
+            copy->set_right(right);
 
-    base_node_ptr get_root() noexcept { return end_.get_left(); }
-    const_base_node_ptr get_root() const noexcept { return end_.get_left(); }
-    void set_root(base_node_ptr root) noexcept { end_.set_left(root); }
+            auto left_task = std::async(std::launch::async, [=, this]
+            {
+                clone_subtree(source_left, left, prev, copy, depth - 1);
+            });
 
-    base_node_ptr get_leftmost() noexcept { return end_.get_right(); }
-    const_base_node_ptr get_leftmost() const noexcept { return end_.get_right(); }
-    void set_leftmost(base_node_ptr leftmost) noexcept { end_.set_right(leftmost); }
+            clone_subtree(source_right, right, copy, next, depth - 1);
+            left_task.get();
 
-    base_node_ptr get_rightmost() noexcept { return end_.get_parent(); }
-    const_base_node_ptr get_rightmost() const noexcept { return end_.get_parent(); }
-    void set_rightmost(base_node_ptr rightmost) noexcept { end_.set_parent(rightmost); }
+            update_node(copy);
 
-    void clean_up() noexcept
-    {
-        for (base_node_ptr node = get_root(), save; node != nullptr; node = save)
+            return;
+        }
+
+        // the subtree is walked in-order; threads of a node are linked when it is visited
+        const_base_node_ptr top = source;
+        base_node_ptr last = prev;
+        bool last_has_right_thread = false;
+
+        for (;;)
         {
-            if (base_node_ptr left = node->get_left())
+            while (!source->has_left_thread())
             {
-                save = left;
-                node->set_left(save->get_right());
-                save->set_right(node);
+                source = source->get_left_unsafe();
+                base_node_ptr child = clone_node(source, copy);
+                copy->set_left(child);
+                copy = child;
             }
-            else
+
+            for (;;)
             {
-                save = node->get_right();
-                delete node;
+                if (source->has_left_thread())
+                    copy->set_left_thread(last);
+
+                if (last_has_right_thread)
+                    last->set_right_thread(copy);
+
+                last = copy;
+                last_has_right_thread = source->has_right_thread();
+
+                if (!last_has_right_thread)
+                {
+                    source = source->get_right_unsafe();
+                    base_node_ptr child = clone_node(source, copy);
+                    copy->set_right(child);
+                    copy = child;
+
+                    break;
+                }
+
+                // the subtree of source is copied: climb while coming from right children
+                for (;;)
+                {
+                    update_node(copy);
+
+                    if (source == top)
+                    {
+                        last->set_right_thread(next);
+                        return;
+                    }
+
+                    const bool is_left_child = source->is_left_child();
+                    source = source->get_parent();
+                    copy = copy->get_parent();
+
+                    if (is_left_child)
+                        break;
+                }
             }
         }
     }
 
-    void reset() noexcept
+    // turns the tree into the list of its nodes in ascending order chained by right links
+    base_node_ptr unlink_list() noexcept
     {
-        set_root(nullptr);
-        set_leftmost(&end_);
-        set_rightmost(&end_);
+        if (empty())
+            return nullptr;
+
+        push_all_tags();
+
+        base_node_ptr end_node = &end_;
+        base_node_ptr head = get_leftmost();
+
+        for (base_node_ptr node = head, next; node != end_node; node = next)
+        {
+            next = node->successor();
+            node->set_right(next == end_node ? nullptr : next);
+        }
+
+        reset();
+        size_ = 0;
+
+        return head;
     }
 
-    void take_ownership_of_tree_of(Search_Tree &rhs) noexcept
+    /*
+     * Makes this empty tree a perfectly balanced one of nodes in ascending order. Subtrees at the
+     * top depth levels are linked by other threads
+     */
+    void link_array(std::span<const base_node_ptr> nodes, unsigned depth)
     {
         assert(get_root() == nullptr);
 
-        rhs.adjust_tree_to_end_node_of(*this);
+        if (nodes.empty())
+            return;
+
+        base_node_ptr end_node = &end_;
+        base_node_ptr root = link_range(nodes, end_node, end_node, depth);
 
-        set_root(rhs.get_root());
-        set_leftmost(rhs.get_leftmost());
-        set_rightmost(rhs.get_rightmost());
-        rhs.reset();
+        set_root(root);
+        root->set_parent(end_node);
+        set_leftmost(nodes.front());
+        set_rightmost(nodes.back());
+        size_ = nodes.size();
     }
 
-    void adjust_tree_to_end_node_of(Search_Tree &rhs) noexcept
+    // prev and next are the in-order predecessor and successor of the range
+    base_node_ptr link_range(std::span<const base_node_ptr> nodes,
+                             base_node_ptr prev, base_node_ptr next, unsigned depth)
     {
-        assert(get_root());
+        if (nodes.empty())
+            return nullptr;
+
+        const auto middle = nodes.size() / 2;
+        base_node_ptr root = nodes[middle];
+        auto left_nodes = nodes.first(middle);
+        auto right_nodes = nodes.subspan(middle + 1);
+
+        base_node_ptr left;
+        base_node_ptr right;
+
+        if (depth != 0)
+        {
+            auto left_task = std::async([=, this]
+            {
+                return link_range(left_nodes, prev, root, depth - 1);
+            });
+
+            right = link_range(right_nodes, root, next, depth - 1);
+            left = left_task.get();
+        }
+        else
+        {
+            left = link_range(left_nodes, prev, root, 0);
+            right = link_range(right_nodes, root, next, 0);
+        }
 
-        base_node_ptr right_end = &rhs.end_;
-        get_root()->set_parent(right_end);
-        get_leftmost()->set_left_thread(right_end);
-        get_rightmost()->set_right_thread(right_end);
+        if (left)
+        {
+            root->set_left(left);
+            left->set_parent(root);
+        }
+        else
+            root->set_left_thread(prev);
+
+        if (right)
+        {
+            root->set_right(right);
+            right->set_parent(root);
+        }
+        else
+            root->set_right_thread(next);
+
+        update_node(root);
+
+        return root;
     }
 
-    // implementation of operations on tree
+    // passes an update pending at a node on to its children
+    static void push_node(base_node_ptr node) noexcept
+    {
+        if constexpr (contains_lazy_tags<node_type>)
+            static_cast<node_ptr>(node)->push();
+    }
 
-    virtual const_base_node_ptr do_find(const key_type &key) const
+    // pushes all pending updates down to the leaves visiting every node before its children
+    void push_all_tags() const noexcept
     {
-        const_base_node_ptr node = get_root();
+        if constexpr (contains_lazy_tags<node_type>)
+        {
+            auto root = const_cast<base_node_ptr>(get_root());
 
-        while (node)
+            for (base_node_ptr node = root; node; )
+            {
+                push_node(node);
+
+                if (base_node_ptr left = node->get_left())
+                    node = left;
+                else if (base_node_ptr right = node->get_right())
+                    node = right;
+                else
+                {
+                    // climbs to the nearest ancestor with a right subtree not visited yet
+                    for (;;)
+                    {
+                        if (node == root)
+                        {
+                            node = nullptr;
+                            break;
+                        }
+
+                        base_node_ptr parent = node->get_parent();
+                        if (node->is_left_child() && parent->get_right())
+                        {
+                            node = parent->get_right();
+                            break;
+                        }
+
+                        node = parent;
+                    }
+                }
+            }
+        }
+    }
+
+    // recomputes augmented data of all nodes on the path from node to the root
+    void update_path(base_node_ptr node) noexcept
+    {
+        if constexpr (maintains_subtree_data<node_type>)
         {
-            if (comp_(key, static_cast<const_node_ptr>(node)->get_key()))
-                node = node->get_left();
-            else if (comp_(static_cast<const_node_ptr>(node)->get_key(), key))
-                node = node->get_right();
-            else
-                return node;
+            for (base_node_ptr end_node = &end_; node != end_node; node = node->get_parent())
+                update_node(node);
         }
+    }
+
+    // implementation of operations on tree
 
-        return &end_;
+    /*
+     * Lookups descend by the following *_with_parent methods that return the node found (nullptr
+     * if there is none) and the last node on the search path. Keys are of key_type or of any type
+     * the comparator is transparent for
+     */
+
+    template<typename K>
+    const_base_node_ptr do_find(const K &key) const
+    {
+        auto [node, parent] = find_with_parent(key);
+        return lookup_result(node, parent);
+    }
+
+    template<typename K>
+    const_base_node_ptr do_lower_bound(const K &key) const
+    {
+        auto [lower_bound, parent] = lower_bound_with_parent(key);
+        return lookup_result(lower_bound, parent);
+    }
+
+    template<typename K>
+    const_base_node_ptr do_upper_bound(const K &key) const
+    {
+        auto [upper_bound, parent] = upper_bound_with_parent(key);
+        return lookup_result(upper_bound, parent);
+    }
+
+    // turns the result of a lookup into a node or the end node; derived trees may restructure here
+    virtual const_base_node_ptr lookup_result(const_base_node_ptr node,
+                                              [[maybe_unused]] const_base_node_ptr parent) const
+    {
+        return node ? node : &end_;
     }
 
-    std::pair<const_base_node_ptr, const_base_node_ptr> find_with_parent(const key_type &key) const
+    template<typename K>
+    std::pair<const_base_node_ptr, const_base_node_ptr> find_with_parent(const K &key) const
     {
         const_base_node_ptr node = get_root();
         const_base_node_ptr parent = &end_;
@@ -390,44 +902,243 @@ protected:
         return std::pair{node, parent};
     }
 
-    virtual const_base_node_ptr do_lower_bound(const key_type &key) const
+    template<typename K>
+    std::pair<const_base_node_ptr, const_base_node_ptr> lower_bound_with_parent(const K &key) const
     {
+        const_base_node_ptr lower_bound = nullptr;
+        const_base_node_ptr parent = &end_;
         const_base_node_ptr node = get_root();
-        const_base_node_ptr lower_bound = &end_;
 
         while (node)
         {
+            parent = node;
+
             if (!comp_(static_cast<const_node_ptr>(node)->get_key(), key))
                 lower_bound = std::exchange(node, node->get_left());
             else
                 node = node->get_right();
         }
 
-        return lower_bound;
+        return std::pair{lower_bound, parent};
     }
 
-    virtual const_base_node_ptr do_upper_bound(const key_type &key) const
+    template<typename K>
+    std::pair<const_base_node_ptr, const_base_node_ptr> upper_bound_with_parent(const K &key) const
     {
+        const_base_node_ptr upper_bound = nullptr;
+        const_base_node_ptr parent = &end_;
         const_base_node_ptr node = get_root();
-        const_base_node_ptr upper_bound = &end_;
 
         while (node)
         {
+            parent = node;
+
             if (comp_(key, static_cast<const_node_ptr>(node)->get_key()))
                 upper_bound = std::exchange(node, node->get_left());
             else
                 node = node->get_right();
         }
 
-        return upper_bound;
+        return std::pair{upper_bound, parent};
+    }
+
+    /*
+     * Returns the same pair as find_with_parent(). A key greater than all keys of the tree is
+     * appended to the rightmost node without descending from the root
+     */
+    std::pair<const_base_node_ptr, const_base_node_ptr>
+    find_insert_position(const key_type &key) const
+    {
+        const_base_node_ptr rightmost = get_rightmost();
+
+        if (rightmost != &end_ && comp_(key_of(rightmost), key))
+            return std::pair{nullptr, rightmost};
+
+        return find_with_parent(key);
+    }
+
+    /*
+     * Same as above, but the key is first checked to lie between the predecessor of hint and hint.
+     * The predecessor is found in O(1) if hint is end() or has no left child: it is the rightmost
+     * node or the left thread of hint then. Otherwise it is the maximum of the left subtree of
+     * hint, and reaching it costs the height of that subtree, which is less than a descent from the
+     * root to the same node. A wrong hint costs two comparisons more than the descent it falls
+     * back to
+     */
+    std::pair<const_base_node_ptr, const_base_node_ptr>
+    find_insert_position(const_iterator hint, const key_type &key) const
+    {
+        const_base_node_ptr end_node = &end_;
+        const_base_node_ptr next = const_base_ptr(hint);
+
+        if (next != end_node && !comp_(key, key_of(next)))
+        {
+            if (!comp_(key_of(next), key))
+                return std::pair{next, next};
+
+            return find_insert_position(key);
+        }
+
+        // the key is less than the one of hint; a leftmost hint covers an empty tree too
+        if (next == get_leftmost())
+            return std::pair{nullptr, next};
+
+        const_base_node_ptr prev;
+        if (next == end_node)
+            prev = get_rightmost();
+        else if (next->has_left_thread())
+            prev = next->get_left_unsafe();
+        else
+            prev = next->get_left_unsafe()->maximum();
+
+        if (comp_(key_of(prev), key))
+        {
+            // either hint has no left child, or its predecessor has no right one
+            bool attach_to_next = next != end_node && next->has_left_thread();
+            return std::pair{nullptr, attach_to_next ? next : prev};
+        }
+
+        if (!comp_(key, key_of(prev)))
+            return std::pair{prev, prev};
+
+        return find_with_parent(key);
+    }
+
+    /*
+     * Inserts a node with key if the tree does not contain it yet; the node is constructed from
+     * args only in this case
+     */
+    template<typename... Args>
+    std::pair<iterator, bool> insert_unique(const key_type &key, Args &&... args)
+    {
+        return insert_at(find_insert_position(key), std::forward<Args>(args)...);
+    }
+
+    // position is a pair returned by find_insert_position()
+    template<typename... Args>
+    std::pair<iterator, bool> insert_at(std::pair<const_base_node_ptr, const_base_node_ptr> position,
+                                        Args &&... args)
+    {
+        auto [found, parent] = position;
+
+        if (found)
+            return std::pair{iterator{found}, false};
+
+        // args may hold the key, so it is not used after they are moved into the node
+        node_ptr node = create_node(std::forward<Args>(args)...);
+        return std::pair{link_new_node(node, const_cast<base_node_ptr>(parent)), true};
+    }
+
+    // the same for a node already constructed; the node is destroyed if its key is not new
+    std::pair<iterator, bool> link_or_destroy(
+        node_ptr node, std::pair<const_base_node_ptr, const_base_node_ptr> position)
+    {
+        auto [found, parent] = position;
+
+        if (found)
+        {
+            destroy_node(node);
+            return std::pair{iterator{found}, false};
+        }
+
+        return std::pair{link_new_node(node, const_cast<base_node_ptr>(parent)), true};
     }
 
-    virtual base_node_ptr do_insert(const key_type &key, base_node_ptr parent)
+    // position is a pair returned by find_insert_position() for the key of the node of handle
+    insert_return_type insert_handle(node_handle &&handle,
+                                     std::pair<const_base_node_ptr, const_base_node_ptr> position)
+    {
+        auto [found, parent] = position;
+
+        if (found)
+        {
+            if constexpr (contains_key_count<node_type>)
+            {
+                add_occurrences(const_cast<base_node_ptr>(found), handle.node_->count());
+                handle = node_handle{};
+            }
+
+            return insert_return_type{iterator{found}, false, std::move(handle)};
+        }
+
+        adopt_allocator(*handle.alloc_);
+        push_node(handle.node_); // a detached leaf may keep a tag meant for its former children
+        iterator pos = link_new_node(handle.release(), const_cast<base_node_ptr>(parent));
+
+        return insert_return_type{pos, true, node_handle{}};
+    }
+
+    // unlinks the node at pos from the tree and leaves it as a detached leaf
+    base_node_ptr detach_node(const_iterator pos)
+    {
+        base_node_ptr node = base_ptr(pos);
+
+        if (node == get_rightmost())
+            set_rightmost(node == get_leftmost() ? &end_ : base_ptr(std::prev(pos)));
+
+        if (node == get_leftmost())
+            set_leftmost(base_ptr(std::next(pos)));
+
+        unlink_node(node);
+        if (size_ != unknown_size)
+            size_--;
+
+        node->set_left_thread(nullptr);
+        node->set_right_thread(nullptr);
+        update_node(node);
+
+        return node;
+    }
+
+    // links a node which key is not in the tree under parent found by find_insert_position()
+    iterator link_new_node(base_node_ptr node, base_node_ptr parent)
+    {
+        node->set_parent(parent);
+        do_insert(node, parent);
+
+        const key_type &key = key_of(node);
+
+        if (get_leftmost() == &end_)
+        {
+            set_leftmost(node);
+            set_rightmost(node);
+        }
+        else if (comp_(key, key_of(get_leftmost())))
+            set_leftmost(node);
+        else if (comp_(key_of(get_rightmost()), key))
+            set_rightmost(node);
+
+        if (size_ != unknown_size)
+            size_++;
+
+        return iterator{node};
+    }
+
+    // a multiset counts one more occurrence of a key it already contains
+    void count_repeated_key(const std::pair<iterator, bool> &res) noexcept
+    {
+        if constexpr (contains_key_count<node_type>)
+        {
+            if (!res.second)
+                add_occurrences(base_ptr(res.first), 1);
+        }
+    }
+
+    void add_occurrences(base_node_ptr node, size_type n) noexcept
+    requires contains_key_count<node_type>
+    {
+        auto counted = static_cast<node_ptr>(node);
+        counted->set_count(counted->count() + n);
+        update_path(node->get_parent());
+    }
+
+    // links new_node with its parent already set as a leaf child of parent
+    virtual void do_insert(base_node_ptr new_node, base_node_ptr parent)
     {
         assert(parent);
         assert(!parent->get_left() || !parent->get_right());
 
-        base_node_ptr new_node = new node_type{key, nullptr, nullptr, parent};
+        const key_type &key = key_of(new_node);
         base_node_ptr end_node = &end_;
 
         if (parent == end_node)
@@ -460,7 +1171,7 @@ protected:
             parent->set_right(new_node);
         }
 
-        return new_node;
+        update_path(parent);
     }
 
     virtual void unlink_node(base_node_ptr node)
@@ -474,21 +1185,25 @@ protected:
                 if (node == get_root())
                     set_root(nullptr);
                 else
-                    bst_erase_no_children_case(node);
+                    update_path(bst_erase_no_children_case(node));
             }
             else
-                bst_erase_only_right_child_case(node);
+                update_path(bst_erase_only_right_child_case(node));
         }
         else
         {
             if (node->has_right_thread())
-                bst_erase_only_left_child_case(node);
+                update_path(bst_erase_only_left_child_case(node));
             else
-                bst_erase_both_children_case(node);
+                update_path(bst_erase_both_children_case(node));
         }
     }
 
-    static void bst_erase_no_children_case(base_node_ptr node)
+    /*
+     * bst_erase_* functions return the deepest node which subtree has changed
+     */
+
+    static base_node_ptr bst_erase_no_children_case(base_node_ptr node)
     {
         assert(node->has_left_thread());
         assert(node->has_right_thread());
@@ -500,9 +1215,11 @@ protected:
             successor->set_left_thread(predecessor);
         else
             predecessor->set_right_thread(successor);
+
+        return node->get_parent();
     }
 
-    static void bst_erase_only_left_child_case(base_node_ptr node)
+    static base_node_ptr bst_erase_only_left_child_case(base_node_ptr node)
     {
         assert(!node->has_left_thread());
         assert(node->has_right_thread());
@@ -520,9 +1237,11 @@ protected:
             parent->set_left(child);
         else
             parent->set_right(child);
+
+        return parent;
     }
 
-    static void bst_erase_only_right_child_case(base_node_ptr node)
+    static base_node_ptr bst_erase_only_right_child_case(base_node_ptr node)
     {
         assert(node->has_left_thread());
         assert(!node->has_right_thread());
@@ -540,9 +1259,11 @@ protected:
             parent->set_left(child);
         else
             parent->set_right(child);
+
+        return parent;
     }
 
-    static void bst_erase_both_children_case(base_node_ptr node)
+    static base_node_ptr bst_erase_both_children_case(base_node_ptr node)
     {
         assert(!node->has_left_thread());
         assert(!node->has_right_thread());
@@ -554,13 +1275,16 @@ protected:
         successor->set_left(left);
         left->set_parent(successor);
 
-        if (left->has_right_thread())
-            left->set_right_thread(successor);
+        // the predecessor of node is threaded to node
+        left->maximum()->set_right_thread(successor); // O(log n)
+
+        base_node_ptr deepest = successor;
 
         if (successor != right)
         {
             assert(successor->is_left_child());
             base_node_ptr s_parent = successor->get_parent();
+            deepest = s_parent;
 
             if (successor->has_right_thread())
             {
@@ -580,6 +1304,8 @@ protected:
         }
 
         transplant(node, successor);
+
+        return deepest;
     }
 
     // replaces the subtree rooted at node u with the subtree rooted at node v
@@ -597,61 +1323,8 @@ protected:
 
         v->set_parent(parent);
     }
-
-    void dump_subtree(std::ostream &os, const_node_ptr node) const
-    {
-        dot_dump(os, *node);
-
-        if (auto left = node->get_left())
-            dump_subtree(os, static_cast<const_node_ptr>(left));
-
-        if (auto right = node->get_right())
-            dump_subtree(os, static_cast<const_node_ptr>(right));
-    }
-
-    static void arrow_dump(std::ostream &os, const_base_node_ptr node)
-    {
-        assert(node);
-
-        auto self = fmt::ptr(node);
-
-        if (node->has_left_thread())
-            fmt::print(os, "    node_{}:w -> node_{} [style = dotted, color = \"blue\"];\n",
-                       self, fmt::ptr(node->get_left_unsafe()));
-        else
-            fmt::print(os, "    node_{} -> node_{} [color = \"blue\"];\n",
-                       self, fmt::ptr(node->get_left_unsafe()));
-
-        if (node->has_right_thread())
-            fmt::print(os, "    node_{}:e -> node_{} [style = dotted, color = \"red\"];\n",
-                       self, fmt::ptr(node->get_right_unsafe()));
-        else
-            fmt::print(os, "    node_{} -> node_{} [color = \"red\"];\n",
-                       self, fmt::ptr(node->get_right_unsafe()));
-    }
-
-    // left child of end_ is the root of the tree
-    // right child of end_ is the leftmost element of the tree
-    // parent of end_ is the rightmost element of the tree
-    base_node_type end_{nullptr, &end_, &end_};
-    size_type size_ = 0;
-    [[no_unique_address]] key_compare comp_;
 };
 
-template<typename Node_T, typename Compare>
-bool operator==(const Search_Tree<Node_T, Compare> &lhs, const Search_Tree<Node_T, Compare> &rhs)
-{
-    return (lhs.size() == rhs.size()) &&
-           (std::equal(lhs.begin(), lhs.end(), rhs.begin()));
-}
-
-template<typename Node_T, typename Compare>
-auto operator<=>(const Search_Tree<Node_T, Compare> &lhs, const Search_Tree<Node_T, Compare> &rhs)
--> decltype(std::compare_three_way{}(*lhs.begin(), *rhs.begin()))
-{
-    return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
-}
-
 } // namespace yLab
 
 #endif // INCLUDE_TREES_SEARCH_TREE_HPP
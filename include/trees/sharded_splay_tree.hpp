@@ -0,0 +1,589 @@
+#ifndef INCLUDE_TREES_SHARDED_SPLAY_TREE_HPP
+#define INCLUDE_TREES_SHARDED_SPLAY_TREE_HPP
+
+#include <functional>
+#include <memory>
+#include <iterator>
+#include <initializer_list>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+#include <cstddef>
+#include <cassert>
+#include <optional>
+#include <utility>
+
+#include "nodes/augmented_node.hpp"
+#include "trees/splay_tree_base.hpp"
+
+namespace yLab
+{
+
+/*
+ * Set of keys partitioned into key ranges (shards). Every shard is an augmented splay tree guarded
+ * by its own mutex, so operations on different shards run in parallel while a lookup still
+ * restructures its shard. The layout of the shards is guarded by a shared mutex: all operations
+ * hold it in the shared mode, clear() and rebalance() hold it exclusively.
+ *
+ * A shard that grows too large or too small moves keys to or from one neighbour holding the locks
+ * of these two shards only; the boundary between them is guarded by one more shared mutex.
+ * Queries lock their shards in ascending order and look the shards up again once they are locked,
+ * so they see a consistent state of the shards involved. Iterators chain the threaded lists of
+ * the shards; iteration shall not run concurrently with any modifier
+ */
+template<typename Key_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>>
+class Sharded_Splay_Tree final
+{
+    using shard_tree = Splay_Tree_Base<Augmented_Node<Key_T>, Compare, Allocator>;
+    using shard_iterator = typename shard_tree::const_iterator;
+
+    struct Shard final
+    {
+        Shard(const Compare &comp, const Allocator &alloc) : tree{comp, alloc} {}
+
+        // called under the lock of the shard after every change of the tree
+        void update_size() noexcept { n_keys.store(tree.size(), std::memory_order_relaxed); }
+
+        mutable std::mutex mutex;
+        shard_tree tree;
+        std::atomic<std::size_t> n_keys = 0; // lets neighbours be chosen without locking them
+    };
+
+    using shard_lock = std::unique_lock<std::mutex>;
+
+    struct Locked_Shards final
+    {
+        std::size_t first;
+        std::size_t last;
+        std::vector<shard_lock> locks;
+    };
+
+    enum class Load { over, under };
+
+public:
+
+    using key_type = Key_T;
+    using key_compare = Compare;
+    using value_type = key_type;
+    using value_compare = key_compare;
+    using const_reference = const value_type &;
+    using reference = const_reference;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using allocator_type = Allocator;
+
+    class iterator final
+    {
+    public:
+
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = key_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type *;
+        using reference = const value_type &;
+
+        iterator() = default;
+
+        reference operator*() const { return *it_; }
+        pointer operator->() const { return std::addressof(*it_); }
+
+        iterator &operator++()
+        {
+            ++it_;
+
+            // skips the end of this shard and the following empty shards
+            for (auto last = tree_->n_shards() - 1; it_ == shard().end() && i_ != last; )
+                it_ = tree_->shards_[++i_].tree.begin();
+
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            auto tmp{*this};
+            ++*this;
+            return tmp;
+        }
+
+        iterator &operator--()
+        {
+            while (it_ == shard().begin() && i_ != 0)
+                it_ = tree_->shards_[--i_].tree.end();
+
+            --it_;
+            return *this;
+        }
+
+        iterator operator--(int)
+        {
+            auto tmp{*this};
+            --*this;
+            return tmp;
+        }
+
+        bool operator==(const iterator &rhs) const { return i_ == rhs.i_ && it_ == rhs.it_; }
+
+    private:
+
+        friend class Sharded_Splay_Tree;
+
+        iterator(const Sharded_Splay_Tree *tree, size_type i, shard_iterator it)
+            : tree_{tree}, i_{i}, it_{it} {}
+
+        const shard_tree &shard() const { return tree_->shards_[i_].tree; }
+
+        const Sharded_Splay_Tree *tree_ = nullptr;
+        size_type i_ = 0;
+        shard_iterator it_;
+    };
+
+    using const_iterator = iterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = reverse_iterator;
+
+    /*
+     * Shards smaller than this never trigger rebalancing; neither do shards of trees having less
+     * than this many keys per shard
+     */
+    static constexpr size_type min_rebalance_size = 64;
+
+    static size_type default_n_shards() noexcept
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    explicit Sharded_Splay_Tree(size_type n_shards = default_n_shards(),
+                                const key_compare &comp = key_compare(),
+                                const allocator_type &alloc = allocator_type())
+        : comp_(comp)
+    {
+        assert(n_shards != 0);
+
+        for (size_type i = 0; i != n_shards; ++i)
+            shards_.emplace_back(comp, alloc);
+    }
+
+    template<std::input_iterator It>
+    Sharded_Splay_Tree(It first, It last, size_type n_shards = default_n_shards(),
+                       const key_compare &comp = key_compare(),
+                       const allocator_type &alloc = allocator_type())
+        : Sharded_Splay_Tree(n_shards, comp, alloc)
+    {
+        shards_.front().tree.insert(first, last);
+        size_ = shards_.front().tree.size();
+        rebalance();
+    }
+
+    Sharded_Splay_Tree(std::initializer_list<value_type> ilist,
+                       size_type n_shards = default_n_shards(),
+                       const key_compare &comp = key_compare(),
+                       const allocator_type &alloc = allocator_type())
+        : Sharded_Splay_Tree(ilist.begin(), ilist.end(), n_shards, comp, alloc) {}
+
+    // shards own mutexes, so the tree is neither copyable nor movable
+    Sharded_Splay_Tree(const Sharded_Splay_Tree &rhs) = delete;
+    Sharded_Splay_Tree &operator=(const Sharded_Splay_Tree &rhs) = delete;
+
+    // observers
+
+    key_compare key_comp() const { return comp_; }
+    value_compare value_comp() const { return key_comp(); }
+
+    // capacity
+
+    size_type size() const noexcept { return size_.load(std::memory_order_relaxed); }
+    bool empty() const noexcept { return size() == 0; }
+
+    size_type n_shards() const noexcept { return shards_.size(); }
+
+    size_type shard_size(size_type i) const
+    {
+        assert(i < n_shards());
+
+        std::shared_lock layout_lock{layout_mutex_};
+        shard_lock lock{shards_[i].mutex};
+
+        return shards_[i].tree.size();
+    }
+
+    // iterators
+
+    const_iterator begin() const
+    {
+        size_type i = 0;
+        for (auto last = n_shards() - 1; i != last && shards_[i].tree.empty(); ++i) {}
+
+        return const_iterator{this, i, shards_[i].tree.begin()};
+    }
+
+    const_iterator end() const
+    {
+        auto last = n_shards() - 1;
+        return const_iterator{this, last, shards_[last].tree.end()};
+    }
+
+    const_reverse_iterator rbegin() const { return const_reverse_iterator{end()}; }
+    const_reverse_iterator rend() const { return const_reverse_iterator{begin()}; }
+
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+    // lookup
+
+    bool contains(const key_type &key) const
+    {
+        std::shared_lock layout_lock{layout_mutex_};
+        auto shards = lock_shards_of(key, key);
+
+        return shards_[shards.first].tree.contains(key);
+    }
+
+    size_type n_less_than(const key_type &key) const
+    {
+        std::shared_lock layout_lock{layout_mutex_};
+
+        auto shards = lock_shards_of(std::nullopt, key);
+        auto i = shards.last;
+
+        size_type n_less = shards_[i].tree.n_less_than(key);
+        for (size_type j = 0; j != i; ++j)
+            n_less += shards_[j].tree.size();
+
+        return n_less;
+    }
+
+    // returns the number of keys in range [first, last)
+    size_type count_in_range(const key_type &first, const key_type &last) const
+    {
+        if (!comp_(first, last))
+            return 0;
+
+        std::shared_lock layout_lock{layout_mutex_};
+
+        auto shards = lock_shards_of(first, last);
+        auto i = shards.first;
+        auto j = shards.last;
+
+        const shard_tree &first_shard = shards_[i].tree;
+        const shard_tree &last_shard = shards_[j].tree;
+
+        if (i == j)
+            return first_shard.n_less_than(last) - first_shard.n_less_than(first);
+
+        size_type count = first_shard.size() - first_shard.n_less_than(first);
+        for (auto k = i + 1; k != j; ++k)
+            count += shards_[k].tree.size();
+
+        return count + last_shard.n_less_than(last);
+    }
+
+    // modifiers
+
+    bool insert(const key_type &key)
+    {
+        std::shared_lock layout_lock{layout_mutex_};
+
+        size_type i;
+        bool inserted;
+
+        {
+            auto shards = lock_shards_of(key, key);
+            i = shards.first;
+            Shard &shard = shards_[i];
+
+            inserted = shard.tree.insert(key).second;
+            if (inserted)
+            {
+                shard.update_size();
+                size_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (inserted && is_overloaded(shards_[i].n_keys.load(std::memory_order_relaxed)))
+            relieve_shard(i, Load::over);
+
+        return inserted;
+    }
+
+    template<std::input_iterator It>
+    void insert(It first, It last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    void insert(std::initializer_list<value_type> ilist) { insert(ilist.begin(), ilist.end()); }
+
+    size_type erase(const key_type &key)
+    {
+        std::shared_lock layout_lock{layout_mutex_};
+
+        size_type i;
+        size_type n_erased;
+
+        {
+            auto shards = lock_shards_of(key, key);
+            i = shards.first;
+            Shard &shard = shards_[i];
+
+            n_erased = shard.tree.erase(key);
+            if (n_erased)
+            {
+                shard.update_size();
+                size_.fetch_sub(n_erased, std::memory_order_relaxed);
+            }
+        }
+
+        if (n_erased && is_underloaded(shards_[i].n_keys.load(std::memory_order_relaxed)))
+            relieve_shard(i, Load::under);
+
+        return n_erased;
+    }
+
+    void clear()
+    {
+        std::unique_lock layout_lock{layout_mutex_};
+
+        for (Shard &shard : shards_)
+        {
+            shard.tree.clear();
+            shard.update_size();
+        }
+
+        bounds_.clear();
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+    /*
+     * Redistributes keys so that shard sizes differ by at most 1. It joins all shards into one tree
+     * and splits it back: O(n) as split points are found by walking the threaded list. Insertion
+     * and erasure do not call it: they only move keys between neighbouring shards
+     */
+    void rebalance()
+    {
+        std::unique_lock layout_lock{layout_mutex_};
+        do_rebalance();
+    }
+
+private:
+
+    /*
+     * Shard i holds keys in [bounds_[i - 1], bounds_[i]); shards past bounds_.size() are empty.
+     * The caller holds bounds_mutex_
+     */
+    size_type shard_index(const key_type &key) const
+    {
+        return std::ranges::upper_bound(bounds_, key, comp_) - bounds_.begin();
+    }
+
+    /*
+     * Locks the shards of first and last and all shards in between; the first shard is locked if
+     * first is nullopt. A boundary moves only while both shards next to it are locked, so once
+     * the shards are found again with the same result, they hold all their keys
+     */
+    Locked_Shards lock_shards_of(const std::optional<key_type> &first, const key_type &last) const
+    {
+        auto find_shards = [&]
+        {
+            std::shared_lock bounds_lock{bounds_mutex_};
+            return std::pair{first ? shard_index(*first) : 0, shard_index(last)};
+        };
+
+        for (auto shards = find_shards(); ; )
+        {
+            auto locks = lock_shards(shards.first, shards.second);
+
+            if (auto found = find_shards(); found == shards)
+                return Locked_Shards{shards.first, shards.second, std::move(locks)};
+            else
+                shards = found;
+        }
+    }
+
+    // locks shards first, ..., last in ascending order, so that no two queries deadlock
+    std::vector<shard_lock> lock_shards(size_type first, size_type last) const
+    {
+        std::vector<shard_lock> locks;
+        locks.reserve(last - first + 1);
+
+        for (auto i = first; i <= last; ++i)
+            locks.emplace_back(shards_[i].mutex);
+
+        return locks;
+    }
+
+    // a shard is overloaded once it is half as large again as the average one
+    bool is_overloaded(size_type shard_size) const noexcept
+    {
+        return shard_size > min_rebalance_size && 2 * n_shards() * shard_size > 3 * size();
+    }
+
+    // and underloaded once it is less than half as large as the average one
+    bool is_underloaded(size_type shard_size) const noexcept
+    {
+        return size() >= n_shards() * min_rebalance_size && 2 * n_shards() * shard_size < size();
+    }
+
+    // whether shard i is still larger (Load::over) or smaller (Load::under) than the average one
+    bool is_off_average(size_type i, Load load) const noexcept
+    {
+        auto shard_size = shards_[i].n_keys.load(std::memory_order_relaxed);
+        auto n_average = size() / n_shards();
+
+        return (load == Load::over) ? shard_size > n_average : shard_size < n_average;
+    }
+
+    /*
+     * Brings shard i to the average size moving keys to its lighter neighbour if the shard is
+     * overloaded or from its heavier one if it is underloaded. If the neighbour ends up off the
+     * average the same way, it passes the difference on to the next shard in the same direction,
+     * so the keys reach the nearest shard that can take or give them. Every step takes O(log n)
+     * amortized and locks two shards only; the caller holds layout_mutex_ in the shared mode
+     */
+    void relieve_shard(size_type i, Load load)
+    {
+        const auto n_open = [this]
+        {
+            std::shared_lock bounds_lock{bounds_mutex_};
+            return bounds_.size() + 1;
+        }();
+
+        // an overloaded last shard may open the next one
+        auto is_neighbour = [&](size_type j)
+        {
+            return j < n_shards() && (j < n_open || (load == Load::over && j == n_open));
+        };
+
+        auto prefers = [&](size_type a, size_type b)
+        {
+            auto a_size = shards_[a].n_keys.load(std::memory_order_relaxed);
+            auto b_size = shards_[b].n_keys.load(std::memory_order_relaxed);
+
+            return (load == Load::over) ? a_size < b_size : a_size > b_size;
+        };
+
+        auto j = i + 1;
+        if (i != 0 && (!is_neighbour(j) || prefers(i - 1, j)))
+            j = i - 1;
+
+        while (is_neighbour(j) && balance_pair(i, j, load) && is_off_average(j, load))
+            i = std::exchange(j, 2 * j - i);
+    }
+
+    /*
+     * Moves keys between neighbouring shards i and j, so that shard i gets the average size, if it
+     * is still off the average. Shard j keeps at least one key to start with the boundary between them.
+     * The boundary is found by select() and the keys are moved by split() and join()
+     */
+    bool balance_pair(size_type i, size_type j, Load load)
+    {
+        auto lo = std::min(i, j);
+        auto locks = lock_shards(lo, lo + 1);
+
+        if (!is_off_average(i, load))
+            return false;
+
+        shard_tree &left = shards_[lo].tree;
+        shard_tree &right = shards_[lo + 1].tree;
+
+        const auto n_keys = left.size() + right.size();
+        const auto n_target = std::min(size() / n_shards(), n_keys);
+        const auto n_left = std::min((lo == i) ? n_target : n_keys - n_target, n_keys - 1);
+
+        if (left.size() > n_left)
+        {
+            const key_type first_moved = *left.select(n_left);
+            auto [kept, moved] = std::move(left).split(first_moved, Split_Bound::lower);
+
+            [[maybe_unused]] bool joined = moved.join(std::move(right));
+            assert(joined);
+
+            left = std::move(kept);
+            right = std::move(moved);
+        }
+        else if (left.size() < n_left)
+        {
+            const key_type first_kept = *right.select(n_left - left.size());
+            auto [moved, kept] = std::move(right).split(first_kept, Split_Bound::lower);
+
+            [[maybe_unused]] bool joined = left.join(std::move(moved));
+            assert(joined);
+
+            right = std::move(kept);
+        }
+        else
+            return false;
+
+        shards_[lo].update_size();
+        shards_[lo + 1].update_size();
+
+        std::unique_lock bounds_lock{bounds_mutex_};
+
+        if (lo == bounds_.size())
+            bounds_.push_back(*right.begin());
+        else
+            bounds_[lo] = *right.begin();
+
+        return true;
+    }
+
+    void do_rebalance()
+    {
+        shard_tree all{comp_, shards_.front().tree.get_allocator()};
+
+        for (Shard &shard : shards_)
+        {
+            [[maybe_unused]] bool joined = all.join(std::move(shard.tree));
+            assert(joined);
+        }
+
+        bounds_.clear();
+
+        const auto n_keys = all.size();
+        const auto n_pieces = std::clamp<size_type>(n_keys, 1, n_shards());
+
+        // piece i starts with the key of rank i * n_keys / n_pieces
+        std::vector<key_type> split_keys;
+        split_keys.reserve(n_pieces - 1);
+
+        auto it = all.begin();
+        for (size_type i = 1, rank = 0; i != n_pieces; ++i)
+        {
+            auto last_rank = i * n_keys / n_pieces - 1;
+            std::advance(it, last_rank - rank);
+            rank = last_rank;
+
+            split_keys.push_back(*it);
+        }
+
+        for (auto i = n_pieces - 1; i != 0; --i)
+            shards_[i].tree = all.split(split_keys[i - 1]);
+
+        shards_.front().tree = std::move(all);
+
+        for (size_type i = 1; i != n_pieces; ++i)
+            bounds_.push_back(*shards_[i].tree.begin());
+
+        for (Shard &shard : shards_)
+            shard.update_size();
+    }
+
+    std::deque<Shard> shards_;
+    std::vector<key_type> bounds_;
+    mutable std::shared_mutex layout_mutex_;
+    mutable std::shared_mutex bounds_mutex_;
+    std::atomic<size_type> size_ = 0;
+    [[no_unique_address]] key_compare comp_;
+};
+
+} // namespace yLab
+
+#endif // INCLUDE_TREES_SHARDED_SPLAY_TREE_HPP
@@ -0,0 +1,129 @@
+#ifndef INCLUDE_TREES_SPLAY_STRATEGIES_HPP
+#define INCLUDE_TREES_SPLAY_STRATEGIES_HPP
+
+#include <cassert>
+
+#include "nodes/node_base.hpp"
+
+namespace yLab
+{
+
+/*
+ * Strategies of restructuring the access path of a splay tree after a lookup. Every strategy
+ * provides static member function template splay<Node_T>(node, end_node) where end_node is the
+ * parent of the root. Rotations are made by Node_Base::*_rotate<Node_T>, so that augmented data
+ * of nodes stays valid
+ */
+
+// Moves the node to the root
+struct Full_Splay final
+{
+    template<typename Node_T>
+    static void splay(Node_Base *node, const Node_Base *end_node) noexcept
+    {
+        assert(node);
+
+        for (Node_Base *parent; (parent = node->get_parent()) != end_node; )
+        {
+            if (Node_Base *grandparent = parent->get_parent(); grandparent == end_node)
+            {
+                // zig
+                if (node->is_left_child())
+                    parent->template right_rotate<Node_T>();
+                else
+                    parent->template left_rotate<Node_T>();
+            }
+            else if (node->is_left_child())
+            {
+                if (parent->is_left_child())
+                {
+                    // zig-zig
+                    grandparent->template right_rotate<Node_T>();
+                    parent->template right_rotate<Node_T>();
+                }
+                else
+                {
+                    // zig-zag
+                    parent->template right_rotate<Node_T>();
+                    grandparent->template left_rotate<Node_T>();
+                }
+            }
+            else
+            {
+                if (parent->is_left_child())
+                {
+                    // zig-zag
+                    parent->template left_rotate<Node_T>();
+                    grandparent->template right_rotate<Node_T>();
+                }
+                else
+                {
+                    // zig-zig
+                    grandparent->template left_rotate<Node_T>();
+                    parent->template left_rotate<Node_T>();
+                }
+            }
+        }
+    }
+};
+
+/*
+ * Semi-splaying (D. D. Sleator, R. E. Tarjan, "Self-Adjusting Binary Search Trees", 1985).
+ * In the zig-zig case only the parent is rotated above the grandparent and the splaying continues
+ * from the parent, so the node itself usually does not reach the root. The depth of every node on
+ * the access path is still roughly halved at the cost of about half of the rotations
+ */
+struct Semi_Splay final
+{
+    template<typename Node_T>
+    static void splay(Node_Base *node, const Node_Base *end_node) noexcept
+    {
+        assert(node);
+
+        for (Node_Base *parent; (parent = node->get_parent()) != end_node; )
+        {
+            if (Node_Base *grandparent = parent->get_parent(); grandparent == end_node)
+            {
+                // zig
+                if (node->is_left_child())
+                    parent->template right_rotate<Node_T>();
+                else
+                    parent->template left_rotate<Node_T>();
+            }
+            else if (node->is_left_child())
+            {
+                if (parent->is_left_child())
+                {
+                    // zig-zig
+                    grandparent->template right_rotate<Node_T>();
+                    node = parent;
+                }
+                else
+                {
+                    // zig-zag
+                    parent->template right_rotate<Node_T>();
+                    grandparent->template left_rotate<Node_T>();
+                }
+            }
+            else
+            {
+                if (parent->is_left_child())
+                {
+                    // zig-zag
+                    parent->template left_rotate<Node_T>();
+                    grandparent->template right_rotate<Node_T>();
+                }
+                else
+                {
+                    // zig-zig
+                    grandparent->template left_rotate<Node_T>();
+                    node = parent;
+                }
+            }
+        }
+    }
+};
+
+} // namespace yLab
+
+#endif // INCLUDE_TREES_SPLAY_STRATEGIES_HPP
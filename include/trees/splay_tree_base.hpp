@@ -6,23 +6,46 @@
 #include <initializer_list>
 #include <utility>
 #include <cassert>
+#include <memory>
+#include <span>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <future>
+#include <thread>
+#include <type_traits>
+#include <tuple>
+#include <bit>
 
 #include "nodes/node_concepts.hpp"
 #include "trees/search_tree.hpp"
+#include "trees/splay_strategies.hpp"
 
 namespace yLab
 {
 
-template<typename Node_T, typename Compare = std::less<typename Node_T::key_type>>
-class Splay_Tree_Base final : public Search_Tree<Node_T, Compare>
+// which ends of a key range [lo, hi] belong to it
+enum class Interval { closed, right_open, left_open, open };
+
+/*
+ * Splay_Strategy defines how find(), lower_bound() and upper_bound() restructure the tree.
+ * Other operations always splay the node to the root as they rely on its position
+ */
+template<typename Node_T, typename Compare = std::less<typename Node_T::key_type>,
+         typename Allocator = std::allocator<typename Node_T::key_type>,
+         typename Splay_Strategy = Full_Splay>
+class Splay_Tree_Base final : public Search_Tree<Node_T, Compare, Allocator>
 {
-    using base_tree = Search_Tree<Node_T, Compare>;
+    using base_tree = Search_Tree<Node_T, Compare, Allocator>;
 
     using typename base_tree::base_node_ptr;
     using typename base_tree::const_base_node_ptr;
     using typename base_tree::node_ptr;
     using typename base_tree::const_node_ptr;
 
+    using base_tree::key_of;
+    using base_tree::weight;
+
 public:
 
     using typename base_tree::node_type;
@@ -32,28 +55,37 @@ public:
     using typename base_tree::size_type;
     using typename base_tree::iterator;
     using typename base_tree::const_iterator;
+    using typename base_tree::allocator_type;
 
     Splay_Tree_Base() : Splay_Tree_Base{key_compare()} {}
 
-    explicit Splay_Tree_Base(const key_compare &comp) : base_tree(comp) {}
+    explicit Splay_Tree_Base(const key_compare &comp,
+                             const allocator_type &alloc = allocator_type())
+        : base_tree(comp, alloc) {}
+
+    explicit Splay_Tree_Base(const allocator_type &alloc) : base_tree(alloc) {}
 
     template<std::input_iterator it>
-    Splay_Tree_Base(it first, it second, const key_compare &comp = key_compare()) : base_tree(comp)
+    Splay_Tree_Base(it first, it second, const key_compare &comp = key_compare(),
+                    const allocator_type &alloc = allocator_type())
+        : base_tree(comp, alloc)
     {
         this->insert(first, second);
     }
 
     Splay_Tree_Base(std::initializer_list<value_type> ilist,
-                    const key_compare &comp = key_compare())
-        : Splay_Tree_Base(ilist.begin(), ilist.end(), comp) {}
+                    const key_compare &comp = key_compare(),
+                    const allocator_type &alloc = allocator_type())
+        : Splay_Tree_Base(ilist.begin(), ilist.end(), comp, alloc) {}
 
-    Splay_Tree_Base(const Splay_Tree_Base &rhs)
-        : Splay_Tree_Base(rhs.begin(), rhs.end(), rhs.comp_) {}
+    Splay_Tree_Base(const Splay_Tree_Base &rhs) : base_tree(rhs) {}
+
+    Splay_Tree_Base(const Splay_Tree_Base &rhs, Copy_Shape shape) : base_tree(rhs, shape) {}
 
     Splay_Tree_Base &operator=(const Splay_Tree_Base &rhs)
     {
         auto tmp_tree{rhs};
-        this->swap(tmp_tree);
+        base_tree::swap(tmp_tree);
 
         return *this;
     }
@@ -63,10 +95,24 @@ public:
 
     ~Splay_Tree_Base() override = default;
 
+    // a frozen tree has no pending tags, so it flushes those of the nodes it gets
+    void swap(Splay_Tree_Base &rhs) noexcept (noexcept(base_tree::swap(rhs)))
+    {
+        base_tree::swap(rhs);
+
+        if (is_frozen())
+            flush_updates();
+        if (rhs.is_frozen())
+            rhs.flush_updates();
+    }
+
     bool join(Splay_Tree_Base &&rhs)
     {
+        if (is_frozen())
+            rhs.flush_updates();
+
         if (this->empty())
-            this->swap(rhs); // leads to change of the comparator if one of rhs differs from ours
+            base_tree::swap(rhs); // changes the comparator if the one of rhs differs
         else if (!rhs.empty())
         {
             auto lhs_rightmost = static_cast<node_ptr>(this->get_rightmost());
@@ -75,12 +121,15 @@ public:
             if (!this->comp_(lhs_rightmost->get_key(), rhs_leftmost->get_key()))
                 return false;
 
+            this->adopt_allocator_of(rhs);
+
             splay(lhs_rightmost);
 
             base_node_ptr root = this->get_root();
             base_node_ptr rhs_root = rhs.get_root();
             root->set_right(rhs_root);
             rhs_root->set_parent(root);
+            this->update_node(root);
 
             rhs_leftmost->set_left_thread(root);
             base_node_ptr rhs_rightmost = rhs.get_rightmost();
@@ -89,280 +138,2117 @@ public:
 
             rhs.reset();
 
-            this->size_ += std::exchange(rhs.size_, 0);
+            auto rhs_size = std::exchange(rhs.size_, 0);
+            if (this->size_ != base_tree::unknown_size)
+                this->size_ = (rhs_size == base_tree::unknown_size) ? rhs_size
+                                                                     : this->size_ + rhs_size;
         }
 
         return true;
     }
 
+    /*
+     * Leaves keys not greater than key in this tree and returns the rest. Returns an empty tree
+     * if key is not in the tree
+     */
     Splay_Tree_Base split(const key_type &key)
-    requires contains_subtree_size<node_type>
     {
-        const_base_node_ptr node = do_find(key);
-        base_node_ptr end_node = &this->end_;
-
-        if (node == end_node)
+        if (!this->contains(key))
             return {};
 
-        // key is found => the tree is not empty
-        base_node_ptr left_root = this->get_root();
-        base_node_ptr right_root = left_root->get_right();
-        if (right_root)
-            left_root->set_right_thread(end_node);
-        else
-            return {};
-
-        Splay_Tree_Base right_tree;
+        return cut(key, Split_Bound::upper);
+    }
 
-        right_root->set_parent(&right_tree.end_);
-        right_tree.set_root(right_root);
-        right_tree.set_leftmost(right_root->minimum());
-        right_tree.set_rightmost(this->get_rightmost());
-        this->set_rightmost(const_cast<base_node_ptr>(node));
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    Splay_Tree_Base split(const K &key)
+    {
+        if (!this->contains(key))
+            return {};
 
-        const auto right_size = node_type::size(static_cast<node_ptr>(right_root));
-        right_tree.size_ = right_size;
-        this->size_ -= right_size;
+        return cut(key, Split_Bound::upper);
+    }
 
-        return right_tree;
+    /*
+     * Splits the tree into keys less than key and the rest (Split_Bound::lower) or into keys not
+     * greater than key and the rest (Split_Bound::upper). The tree is left empty. Takes
+     * O(log n) amortized; halves of a tree without subtree sizes count their sizes on demand
+     */
+    std::pair<Splay_Tree_Base, Splay_Tree_Base> split(const key_type &key, Split_Bound bound) &&
+    {
+        auto right_tree = cut(key, bound);
+        return std::pair{std::move(*this), std::move(right_tree)};
     }
 
-    size_type n_less_than(const key_type &key) const
-    requires contains_subtree_size<node_type>
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    std::pair<Splay_Tree_Base, Splay_Tree_Base> split(const K &key, Split_Bound bound) &&
     {
-        return this->empty() ? 0 : n_less_than_node(this->lower_bound(key));
+        auto right_tree = cut(key, bound);
+        return std::pair{std::move(*this), std::move(right_tree)};
     }
 
-private:
+    /*
+     * Batches at least 1 / batch_rebuild_ratio of the size of the tree are merged with the list of
+     * its nodes and linked into a perfectly balanced tree in O(n + m). A smaller batch is merged
+     * the same way with the slice of the tree between its least and greatest keys if it makes up
+     * at least 1 / batch_rebuild_ratio of that slice: the slice is split off and joined back in
+     * O(log n) amortized, so a batch crowded into a narrow key range costs O(m + log n). Other
+     * batches are processed key by key in ascending order, which takes O(m log(n / m + 1))
+     * amortized by the dynamic finger theorem for splay trees. Batches and set operations treat
+     * keys as distinct, so multisets do not provide them
+     */
+    static constexpr size_type batch_rebuild_ratio = 32;
+
+    // returns the number of inserted keys
+    size_type insert_batch(std::span<const key_type> keys)
+    requires std::same_as<key_type, value_type> && (!contains_key_count<node_type>)
+    {
+        auto batch = sorted_batch(keys);
+        bool is_small = batch.size() * batch_rebuild_ratio < this->size();
 
-    // Lookup
+        if (is_small && !is_dense_in_slice(batch))
+        {
+            size_type n_inserted = 0;
+            for (const key_type &key : batch)
+                n_inserted += this->insert(key).second;
 
-    const_base_node_ptr do_find(const key_type &key) const override
-    {
-        auto [node, parent] = this->find_with_parent(key);
-        auto result = lookup_splay(node, parent);
+            return n_inserted;
+        }
 
-        return result;
+        // nodes are created before the tree is touched, so that it stays intact if creation fails
+        base_node_ptr fresh = nullptr;
+        for (auto it = batch.rbegin(), ite = batch.rend(); it != ite; ++it)
+        {
+            try
+            {
+                base_node_ptr node = this->create_node(*it);
+                node->set_right(fresh);
+                fresh = node;
+            }
+            catch (...)
+            {
+                while (fresh)
+                    this->destroy_node(std::exchange(fresh, fresh->get_right_unsafe()));
+                throw;
+            }
+        }
+
+        if (!is_small)
+            return merge_list(fresh);
+
+        return in_slice(batch, [fresh](Splay_Tree_Base &slice) { return slice.merge_list(fresh); });
     }
 
-    const_base_node_ptr do_lower_bound(const key_type &key) const override
+    // returns the number of erased keys
+    size_type erase_batch(std::span<const key_type> keys)
+    requires (!contains_key_count<node_type>)
     {
-        const_base_node_ptr lower_bound = nullptr;
-        const_base_node_ptr parent = &this->end_;
-        const_base_node_ptr node = this->get_root();
+        auto batch = sorted_batch(keys);
+        bool is_small = batch.size() * batch_rebuild_ratio < this->size();
 
-        while (node)
+        if (is_small && !is_dense_in_slice(batch))
         {
-            parent = node;
+            size_type n_erased = 0;
+            for (const key_type &key : batch)
+                n_erased += this->erase(key);
 
-            if (!this->comp_(static_cast<const_node_ptr>(node)->get_key(), key))
-                lower_bound = std::exchange(node, node->get_left());
-            else
-                node = node->get_right();
+            return n_erased;
         }
 
-        auto result = lookup_splay(lower_bound, parent);
+        if (!is_small)
+            return filter_out(batch);
 
-        return result;
+        return in_slice(batch, [&batch](Splay_Tree_Base &slice) { return slice.filter_out(batch); });
     }
 
-    const_base_node_ptr do_upper_bound(const key_type &key) const override
+    /*
+     * Set operations reuse nodes of this tree (and of rhs for the union). If one tree is
+     * batch_rebuild_ratio times smaller than the other, keys of the smaller one are processed in
+     * ascending order by inserting, erasing or looking them up in the larger one: O(m log(n/m + 1))
+     * amortized by the dynamic finger theorem (except for freeing nodes that are dropped).
+     * Otherwise the trees are cut into runs of keys that do not interleave with keys of the other
+     * tree: a run is split off and joined to the result as a whole, and runs of rhs that hold no
+     * keys of this tree are skipped with lower_bound(), so k runs take O(k log n) amortized. Once
+     * runs shorter than log2(n + m) outnumber longer ones more than twice, the rest of the trees
+     * is merged node by node and linked into a perfectly balanced tree, so no operation exceeds O(n + m)
+     */
+
+    void merge_union(Splay_Tree_Base &&rhs)
+    requires (!contains_key_count<node_type>)
     {
-        const_base_node_ptr upper_bound = nullptr;
-        const_base_node_ptr parent = &this->end_;
-        const_base_node_ptr node = this->get_root();
+        if (this == &rhs || rhs.empty() || join_disjoint(rhs))
+            return;
 
-        while (node)
+        this->adopt_allocator_of(rhs);
+
+        if (!comparable_sizes(rhs))
         {
-            parent = node;
+            if (this->size() < rhs.size())
+                base_tree::swap(rhs);
 
-            if (this->comp_(key, static_cast<const_node_ptr>(node)->get_key()))
-                upper_bound = std::exchange(node, node->get_left());
-            else
-                node = node->get_right();
+            for (base_node_ptr list = rhs.unlink_list(); list; )
+            {
+                base_node_ptr node = pop_front(list);
+                if (!insert_node(node))
+                    this->destroy_node(node);
+            }
+
+            return;
         }
 
-        auto result = lookup_splay(upper_bound, parent);
+        const size_type united_size = this->size() + rhs.size();
+        const size_type min_run_length = std::bit_width(united_size);
+        Run_Balance balance;
+        size_type n_dropped = 0;
+        Splay_Tree_Base united{this->comp_, this->get_allocator()};
 
-        return result;
-    }
+        while (!this->empty() && !rhs.empty())
+        {
+            // the run ends before the least key of the other tree; equal keys go with our run
+            bool is_ours = !this->comp_(key_of(rhs.get_leftmost()), key_of(this->get_leftmost()));
+            Splay_Tree_Base &from = is_ours ? *this : rhs;
+            const key_type &bound_key = key_of((is_ours ? rhs : *this).get_leftmost());
+            const auto bound = is_ours ? Split_Bound::upper : Split_Bound::lower;
 
-    const_base_node_ptr lookup_splay(const_base_node_ptr node, const_base_node_ptr parent) const
-    {
-        if (node)
+            if (!balance.admit(is_short_run(from, bound_key, bound, min_run_length)))
+                break;
+
+            take_run(from, bound_key, bound, united);
+
+            if (is_ours && !this->comp_(key_of(united.get_rightmost()), bound_key))
+            {
+                rhs.erase(rhs.begin());
+                ++n_dropped;
+            }
+        }
+
+        if (this->empty())
+            base_tree::swap(rhs);
+        else if (!rhs.empty())
         {
-            splay(const_cast<base_node_ptr>(node));
-            return node;
+            const auto rhs_size = rhs.size();
+            n_dropped += rhs_size - merge_list(rhs.unlink_list());
         }
+
+        append_to(united);
+        this->size_ = united_size - n_dropped;
+    }
+
+    // keeps only keys that rhs contains
+    void intersect(const Splay_Tree_Base &rhs)
+    requires (!contains_key_count<node_type>)
+    {
+        if (this == &rhs)
+            return;
+
+        if (this->size() * batch_rebuild_ratio < rhs.size())
+            filter_nodes([&rhs](const key_type &key){ return rhs.contains(key); });
         else
         {
-            const_base_node_ptr end_node = &this->end_;
-            if (parent != end_node)
-                splay(const_cast<base_node_ptr>(parent));
+            // every node of the tree is either kept or freed, so only runs of rhs are skipped
+            const size_type min_run_length = std::bit_width(this->size() + rhs.size());
 
-            return end_node;
+            filter_nodes([this, &rhs, it = rhs.begin(), min_run_length](const key_type &key)
+                         mutable
+            {
+                return seek_not_less(rhs, it, key, min_run_length) &&
+                       !this->comp_(key, key_of(it));
+            });
         }
     }
 
-    size_type n_less_than_node(const_iterator it) const
-    requires contains_subtree_size<node_type>
+    // erases keys that rhs contains
+    void subtract(const Splay_Tree_Base &rhs)
+    requires (!contains_key_count<node_type>)
     {
-        if (it == this->end())
-            return this->size();
-        else
+        if (this == &rhs)
+            this->clear();
+        else if (rhs.size() * batch_rebuild_ratio < this->size())
         {
-            const_base_node_ptr node = base_tree::const_base_ptr(it);
-            return node_type::size(static_cast<const_node_ptr>(node->get_left()));
+            for (auto it = rhs.begin(), ite = rhs.end(); it != ite; ++it)
+                this->erase(key_of(it));
         }
+        else if (this->size() * batch_rebuild_ratio < rhs.size())
+            filter_nodes([&rhs](const key_type &key){ return !rhs.contains(key); });
+        else
+            subtract_runs(rhs);
     }
 
-    // Modifiers
+    /*
+     * The same operations for large trees with an always-equal allocator: nodes of both trees
+     * are gathered into arrays that are cut into key ranges merged by different threads.
+     * The result is linked by forking the recursive halves. Other trees are processed as above
+     */
 
-    base_node_ptr do_insert(const key_type &key, base_node_ptr parent) override
+    static constexpr size_type parallel_set_operation_threshold = 1 << 16;
+
+    void merge_union(Splay_Tree_Base &&rhs, Parallel_Tag)
+    requires (!contains_key_count<node_type>)
     {
-        assert(parent);
-        assert(!parent->get_left() || !parent->get_right());
+        if (!is_parallel_worthy(rhs))
+            merge_union(std::move(rhs));
+        else if (this != &rhs && !rhs.empty() && !join_disjoint(rhs))
+            parallel_merge<Set_Operation::unite>(rhs);
+    }
 
-        base_node_ptr new_node = new node_type{key, nullptr, nullptr, parent};
-        base_node_ptr end_node = &this->end_;
+    void intersect(const Splay_Tree_Base &rhs, Parallel_Tag)
+    requires (!contains_key_count<node_type>)
+    {
+        if (!is_parallel_worthy(rhs))
+            intersect(rhs);
+        else if (this != &rhs)
+            parallel_merge<Set_Operation::intersect>(rhs);
+    }
 
-        if (parent == end_node)
-        {
-            new_node->set_left_thread(end_node);
-            new_node->set_right_thread(end_node);
+    void subtract(const Splay_Tree_Base &rhs, Parallel_Tag)
+    requires (!contains_key_count<node_type>)
+    {
+        if (!is_parallel_worthy(rhs))
+            subtract(rhs);
+        else if (this == &rhs)
+            this->clear();
+        else
+            parallel_merge<Set_Operation::subtract>(rhs);
+    }
 
-            parent->set_left(new_node);
-        }
-        else if (this->comp_(key, static_cast<node_ptr>(parent)->get_key()))
-        {
-            base_node_ptr predecessor = parent->get_left_unsafe();
+    size_type n_less_than(const key_type &key) const
+    requires contains_subtree_size<node_type>
+    {
+        return n_preceding(key);
+    }
 
-            splay(parent);
+    template<typename K>
+    requires contains_subtree_size<node_type> && transparent_comparator<key_compare>
+    size_type n_less_than(const K &key) const { return n_preceding(key); }
 
-            if (predecessor == end_node) // parent is leftmost
-                new_node->set_left_thread(end_node);
-            else
-            {
-                base_node_ptr left = parent->get_left_unsafe();
-                left->set_parent(new_node);
-                predecessor->set_right_thread(new_node);
-                new_node->set_left(left);
-            }
+    /*
+     * Counts keys between lo and hi in O(log n) amortized with two splays: the range is made up of
+     * the root, the right child of the root and the left subtree of the latter
+     */
+    size_type count_in_range(const key_type &lo, const key_type &hi,
+                             Interval interval = Interval::right_open) const
+    requires contains_subtree_size<node_type>
+    {
+        return do_count_in_range(lo, hi, interval);
+    }
 
-            new_node->set_right_thread(parent);
-            parent->set_left(new_node);
-        }
-        else
-        {
-            base_node_ptr successor = parent->get_right_unsafe();
+    template<typename K>
+    requires contains_subtree_size<node_type> &&
+             transparent_range_comparator<key_compare, K, key_type>
+    size_type count_in_range(const K &lo, const K &hi,
+                             Interval interval = Interval::right_open) const
+    {
+        return do_count_in_range(lo, hi, interval);
+    }
 
-            splay(parent);
+    /*
+     * Folds keys between lo and hi in ascending order by the monoid of nodes in O(log n) amortized
+     * restructuring the tree like count_in_range()
+     */
+    auto aggregate(const key_type &lo, const key_type &hi,
+                   Interval interval = Interval::right_open) const
+    requires contains_subtree_aggregate<node_type>
+    {
+        return do_aggregate(lo, hi, interval);
+    }
 
-            if (successor == end_node) // parent is rightmost
-                new_node->set_right_thread(end_node);
-            else
-            {
-                base_node_ptr right = parent->get_right_unsafe();
-                right->set_parent(new_node);
-                successor->set_left_thread(new_node);
-                new_node->set_right(right);
-            }
+    template<typename K>
+    requires contains_subtree_aggregate<node_type> &&
+             transparent_range_comparator<key_compare, K, key_type>
+    auto aggregate(const K &lo, const K &hi, Interval interval = Interval::right_open) const
+    {
+        return do_aggregate(lo, hi, interval);
+    }
 
-            new_node->set_left_thread(parent);
-            parent->set_right(new_node);
-        }
+    // returns [lower_bound(key), upper_bound(key)) restructuring the tree the same way
+    std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const
+    {
+        return do_equal_range(key);
+    }
 
-        return new_node;
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    std::pair<const_iterator, const_iterator> equal_range(const K &key) const
+    {
+        return do_equal_range(key);
     }
 
-    void unlink_node(base_node_ptr node) override
+    /*
+     * Updates keys between lo and hi by tag in O(log n) amortized: the range is laid out like in
+     * count_in_range(), so that the tag is applied to the root of its subtree and to two more
+     * nodes at most. Updates reach the keys of other nodes when those are splayed. A frozen tree
+     * keeps its shape: the tag is applied to O(log n) subtrees hanging off the search paths of lo
+     * and hi, and then pushed down to the leaves eagerly in O(n)
+     */
+    template<contains_lazy_tags Node = node_type>
+    void range_apply(const key_type &lo, const key_type &hi, const typename Node::tag_type &tag,
+                     Interval interval = Interval::right_open)
     {
-        assert(node);
+        do_range_apply(lo, hi, tag, interval);
+    }
+
+    // both overloads are templates, so the one for key_type is not preferred by itself
+    template<typename K, contains_lazy_tags Node = node_type>
+    requires (!std::same_as<K, key_type>) && transparent_range_comparator<key_compare, K, key_type>
+    void range_apply(const K &lo, const K &hi, const typename Node::tag_type &tag,
+                     Interval interval = Interval::right_open)
+    {
+        do_range_apply(lo, hi, tag, interval);
+    }
+
+    /*
+     * Pushes all pending updates down to the leaves in O(n). Iterators, peek_* methods and
+     * comparisons of trees see updated keys only after that
+     */
+    void flush_updates() const noexcept { base_tree::push_all_tags(); }
+
+    // order statistics
+
+    // returns the k-th smallest key (counting from 0) or end() if k >= total_count()
+    const_iterator select(size_type k) const
+    requires contains_subtree_size<node_type>
+    {
+        if (is_frozen())
+            return peek_select(k);
+
+        auto node = select_node(k);
+        if (node)
+            splay(const_cast<base_node_ptr>(node));
+
+        return node ? const_iterator{node} : this->end();
+    }
+
+    // returns the number of keys less than *pos
+    size_type rank(const_iterator pos) const
+    requires contains_subtree_size<node_type>
+    {
+        if (pos == this->end())
+            return this->total_count();
+
+        auto node = const_cast<base_node_ptr>(base_tree::const_base_ptr(pos));
+
+        if (is_frozen())
+            return peek_rank(node);
 
         splay(node);
+        return n_less_than_node(pos);
+    }
 
-        base_node_ptr left = node->get_left();
-        base_node_ptr right = node->get_right();
+    /*
+     * Returns the key of rank floor(q * (total_count() - 1)) for q in [0, 1], i.e. the lower one
+     * of two candidates if q falls between keys; end() if the tree is empty
+     */
+    const_iterator quantile(double q) const
+    requires contains_subtree_size<node_type>
+    {
+        assert(0.0 <= q && q <= 1.0);
 
-        if (left)
-        {
-            if (right)
-            {
-                this->set_root(left);
-                left->set_parent(&this->end_);
+        if (this->empty())
+            return this->end();
 
-                base_node_ptr predecessor = left->maximum();
-                splay(predecessor);
-                predecessor->set_right(right);
-                right->set_parent(predecessor);
+        return select(static_cast<size_type>(q * static_cast<double>(this->total_count() - 1)));
+    }
 
-                base_node_ptr successor = right->minimum();
-                successor->set_left_thread(predecessor);
-            }
-            else
-            {
-                this->transplant(node, left);
-                base_node_ptr predecessor = left->maximum();
-                predecessor->set_right_thread(node->get_right_unsafe());
-            }
-        }
-        else if (right)
-        {
-            this->transplant(node, right);
-            base_node_ptr successor = right->minimum();
-            successor->set_left_thread(node->get_left_unsafe());
-        }
+    // the lower median if the size is even
+    const_iterator median() const
+    requires contains_subtree_size<node_type>
+    {
+        return this->empty() ? this->end() : select((this->total_count() - 1) / 2);
+    }
 
-        if (this->size() == 1)
-            this->set_root(nullptr);
+    /*
+     * peek_* methods do not restructure the tree: they may be called from several threads at once
+     * as long as no thread modifies the tree
+     */
+
+    const_iterator peek_find(const key_type &key) const
+    {
+        auto [node, parent] = this->find_with_parent(key);
+        return const_iterator{base_tree::lookup_result(node, parent)};
     }
 
-    void splay(base_node_ptr node) const
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    const_iterator peek_find(const K &key) const
     {
-        assert(node);
+        auto [node, parent] = this->find_with_parent(key);
+        return const_iterator{base_tree::lookup_result(node, parent)};
+    }
 
-        while (node != this->get_root())
-        {
-            if (base_node_ptr parent = node->get_parent(); parent == this->get_root())
-            {
-                if (node->is_left_child())
-                    parent->right_rotate();
-                else
-                    parent->left_rotate();
-            }
-            else
-            {
-                base_node_ptr grandparent = parent->get_parent();
+    bool peek_contains(const key_type &key) const { return peek_find(key) != this->end(); }
 
-                if (node->is_left_child())
-                {
-                    if (parent->is_left_child())
-                    {
-                        grandparent->right_rotate();
-                        parent->right_rotate();
-                    }
-                    else
-                    {
-                        parent->right_rotate();
-                        grandparent->left_rotate();
-                    }
-                }
-                else
-                {
-                    if (parent->is_left_child())
-                    {
-                        parent->left_rotate();
-                        grandparent->right_rotate();
-                    }
-                    else
-                    {
-                        grandparent->left_rotate();
-                        parent->left_rotate();
-                    }
-                }
-            }
-        }
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    bool peek_contains(const K &key) const { return peek_find(key) != this->end(); }
+
+    const_iterator peek_lower_bound(const key_type &key) const
+    {
+        auto [lower_bound, parent] = this->lower_bound_with_parent(key);
+        return const_iterator{base_tree::lookup_result(lower_bound, parent)};
+    }
+
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    const_iterator peek_lower_bound(const K &key) const
+    {
+        auto [lower_bound, parent] = this->lower_bound_with_parent(key);
+        return const_iterator{base_tree::lookup_result(lower_bound, parent)};
+    }
+
+    const_iterator peek_upper_bound(const key_type &key) const
+    {
+        auto [upper_bound, parent] = this->upper_bound_with_parent(key);
+        return const_iterator{base_tree::lookup_result(upper_bound, parent)};
+    }
+
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    const_iterator peek_upper_bound(const K &key) const
+    {
+        auto [upper_bound, parent] = this->upper_bound_with_parent(key);
+        return const_iterator{base_tree::lookup_result(upper_bound, parent)};
+    }
+
+    size_type peek_n_less_than(const key_type &key) const
+    requires contains_subtree_size<node_type>
+    {
+        return peek_n_preceding(key, Split_Bound::lower);
+    }
+
+    template<typename K>
+    requires contains_subtree_size<node_type> && transparent_comparator<key_compare>
+    size_type peek_n_less_than(const K &key) const
+    {
+        return peek_n_preceding(key, Split_Bound::lower);
     }
+
+    size_type peek_count_in_range(const key_type &lo, const key_type &hi,
+                                  Interval interval = Interval::right_open) const
+    requires contains_subtree_size<node_type>
+    {
+        return do_peek_count_in_range(lo, hi, interval);
+    }
+
+    template<typename K>
+    requires contains_subtree_size<node_type> &&
+             transparent_range_comparator<key_compare, K, key_type>
+    size_type peek_count_in_range(const K &lo, const K &hi,
+                                  Interval interval = Interval::right_open) const
+    {
+        return do_peek_count_in_range(lo, hi, interval);
+    }
+
+    auto peek_aggregate(const key_type &lo, const key_type &hi,
+                        Interval interval = Interval::right_open) const
+    requires contains_subtree_aggregate<node_type>
+    {
+        return do_peek_aggregate(lo, hi, interval);
+    }
+
+    template<typename K>
+    requires contains_subtree_aggregate<node_type> &&
+             transparent_range_comparator<key_compare, K, key_type>
+    auto peek_aggregate(const K &lo, const K &hi, Interval interval = Interval::right_open) const
+    {
+        return do_peek_aggregate(lo, hi, interval);
+    }
+
+    const_iterator peek_select(size_type k) const
+    requires contains_subtree_size<node_type>
+    {
+        auto node = select_node(k);
+        return node ? const_iterator{node} : this->end();
+    }
+
+    /*
+     * In frozen mode find(), contains(), lower_bound(), upper_bound(), equal_range(),
+     * n_less_than(), count_in_range(), aggregate(), select() and rank() do not restructure the
+     * tree. Modifiers still work but shall not run concurrently with any lookup. Switching the
+     * mode is not synchronized with lookups either
+     */
+
+    void freeze() noexcept
+    {
+        flush_updates();
+        frozen_ = true;
+    }
+    void thaw() noexcept { frozen_ = false; }
+    bool is_frozen() const noexcept { return frozen_; }
+
+    /*
+     * Keys greater than all keys of the tree are appended to the rightmost node without a descent
+     * from the root. The rightmost node is splayed then, unless splaying on append is turned off:
+     * an ascending stream is then linked by threads only. Trees keeping subtree data always splay,
+     * as the data on the path to the root would have to be recomputed otherwise
+     */
+
+    void set_splay_on_append(bool splay) noexcept
+    requires (!maintains_subtree_data<node_type>)
+    {
+        splay_on_append_ = splay;
+    }
+    bool splays_on_append() const noexcept { return splay_on_append_; }
+
+    /*
+     * Finger search. A cursor remembers a node, and seek() moves it to the lower bound of a key
+     * starting from that node. It first gallops along the list of nodes: it probes the nodes 1, 2,
+     * 4, ..., cursor_gallop_limit steps farther than the previous probe, and once a probe passes
+     * the key, scans the last stride. A key up to 2 * cursor_gallop_limit - 1 positions away is
+     * thus found with O(log d) probes and at most cursor_gallop_limit more comparisons, and no
+     * ancestor is climbed even if the two nodes lie in different subtrees of the root. A farther
+     * key makes the cursor climb by parent links from the last probe to the lowest ancestor which
+     * subtree spans the key and descend from there. seek() does not restructure the tree;
+     * splay_here() splays the node of the cursor, and seeks followed by it cost O(log d) amortized,
+     * where d is the rank distance between the keys, by the dynamic finger property of splay
+     * trees. A cursor is invalidated like an iterator
+     */
+    static constexpr size_type cursor_gallop_limit = 8;
+
+    class Cursor final
+    {
+    public:
+
+        // returns whether the key is found; the cursor is at its lower bound anyway
+        bool seek(const key_type &key)
+        {
+            const_base_node_ptr end_node = &tree_->end_;
+
+            if (tree_->empty())
+            {
+                node_ = end_node;
+                return false;
+            }
+
+            auto &comp = tree_->comp_;
+            const_base_node_ptr node = (node_ == end_node) ? tree_->get_rightmost() : node_;
+
+            if (comp(key_of(node), key))
+                node_ = seek_forward(node, key);
+            else if (comp(key, key_of(node)))
+                node_ = seek_backward(node, key);
+            else
+                node_ = node;
+
+            return node_ != end_node && !comp(key, key_of(node_));
+        }
+
+        const_iterator position() const noexcept { return const_iterator{node_}; }
+
+        // the cursor stays valid
+        void splay_here() const
+        {
+            if (node_ != &tree_->end_ && !tree_->is_frozen())
+                tree_->splay(const_cast<base_node_ptr>(node_));
+        }
+
+    private:
+
+        friend class Splay_Tree_Base;
+
+        Cursor(const Splay_Tree_Base &tree, const_base_node_ptr node) noexcept
+            : tree_{&tree}, node_{node} {}
+
+        // key of node is less than key
+        const_base_node_ptr seek_forward(const_base_node_ptr node, const key_type &key) const
+        {
+            auto &comp = tree_->comp_;
+            const_base_node_ptr end_node = &tree_->end_;
+
+            // keys of node and of the nodes before probe are less than key
+            for (size_type stride = 1; stride <= cursor_gallop_limit; stride *= 2)
+            {
+                const_base_node_ptr probe = node;
+                for (size_type i = 0; i != stride && probe != end_node; ++i)
+                    probe = probe->successor();
+
+                if (probe == end_node || !comp(key_of(probe), key))
+                {
+                    const_base_node_ptr first = node->successor();
+                    while (first != probe && comp(key_of(first), key))
+                        first = first->successor();
+
+                    return first;
+                }
+
+                node = probe;
+            }
+
+            // the keys of a left child are less than the one of its parent
+            const_base_node_ptr bound = end_node;
+            for (const_base_node_ptr parent; (parent = node->get_parent()) != end_node;
+                 node = parent)
+            {
+                if (node->is_left_child() && comp(key, key_of(parent)))
+                {
+                    bound = parent;
+                    break;
+                }
+            }
+
+            return lower_bound_in_subtree(node, key, bound);
+        }
+
+        // key is less than the key of node
+        const_base_node_ptr seek_backward(const_base_node_ptr node, const key_type &key) const
+        {
+            auto &comp = tree_->comp_;
+            const_base_node_ptr end_node = &tree_->end_;
+
+            // key is less than the keys of node and of the nodes after probe
+            for (size_type stride = 1; stride <= cursor_gallop_limit; stride *= 2)
+            {
+                const_base_node_ptr probe = node;
+                for (size_type i = 0; i != stride && probe != end_node; ++i)
+                    probe = probe->predecessor();
+
+                if (probe == end_node || !comp(key, key_of(probe)))
+                {
+                    if (probe != end_node && !comp(key_of(probe), key))
+                        return probe;
+
+                    for (const_base_node_ptr prev; (prev = node->predecessor()) != probe &&
+                                                   !comp(key_of(prev), key); )
+                        node = prev;
+
+                    return node;
+                }
+
+                node = probe;
+            }
+
+            // the keys of a right child are greater than the one of its parent
+            const_base_node_ptr bound = node;
+            for (const_base_node_ptr parent; (parent = node->get_parent()) != end_node;
+                 node = parent)
+            {
+                if (!node->is_left_child() && comp(key_of(parent), key))
+                    break;
+            }
+
+            return lower_bound_in_subtree(node, key, bound);
+        }
+
+        // bound is the lower bound of key if the subtree of node has none
+        const_base_node_ptr lower_bound_in_subtree(const_base_node_ptr node, const key_type &key,
+                                                   const_base_node_ptr bound) const
+        {
+            while (node)
+            {
+                if (!tree_->comp_(key_of(node), key))
+                    bound = std::exchange(node, node->get_left());
+                else
+                    node = node->get_right();
+            }
+
+            return bound;
+        }
+
+        const Splay_Tree_Base *tree_;
+        const_base_node_ptr node_;
+    };
+
+    Cursor cursor() const
+    requires (!contains_lazy_tags<node_type>)
+    {
+        return Cursor{*this, this->get_leftmost()};
+    }
+
+    Cursor cursor(const_iterator pos) const
+    requires (!contains_lazy_tags<node_type>)
+    {
+        return Cursor{*this, base_tree::const_base_ptr(pos)};
+    }
+
+    /*
+     * Batched queries sort their keys once and answer all of them in one sweep over the threaded
+     * list of nodes without restructuring the tree, so frozen trees run them too. The sweep steps
+     * from node to node while the next key is near and leaps to a farther one by a finger search
+     * that counts the keys it passes by subtree sizes. Trees without subtree sizes step through
+     * every gap.
+     *
+     * A leap over d nodes climbs and descends about log2(d) levels each way, so it visits about
+     * 2 * log2(d) + 2 nodes, which is not less than d up to d = sweep_walk_gap = 8. If the average
+     * gap between consecutive queries, size() divided by their number, is within sweep_walk_gap,
+     * the sweep walks up to sweep_walk_gap nodes before it leaps, so that dense batches are
+     * answered by steps and only an unusually long gap is leapt over. Sparser batches leap unless
+     * the next query is answered by the very next node. Once the gap exceeds sqrt(size()), the
+     * 2 * log2(d) nodes of a leap outnumber the log2(size()) ones of a descent from the root, so
+     * such batches descend from the root right away. Otherwise a climb stops after
+     * sweep_climb_limit levels, i.e. past a subtree of 2^16 nodes if it is balanced, which bounds
+     * the climbs from deep nodes of a skewed tree
+     */
+    static constexpr size_type sweep_walk_gap = 8;
+    static constexpr size_type sweep_climb_limit = 16;
+
+    // ranks[i] is the number of keys less than keys[i] like the one n_less_than() returns
+    void rank_batch(std::span<const key_type> keys, std::span<size_type> ranks) const
+    requires (!contains_lazy_tags<node_type>)
+    {
+        assert(keys.size() == ranks.size());
+
+        std::vector<Rank_Query> queries;
+        queries.reserve(keys.size());
+
+        for (const key_type &key : keys)
+            queries.push_back(Rank_Query{&key, Split_Bound::lower, 0});
+
+        sweep_ranks(queries);
+        std::ranges::transform(queries, ranks.begin(), &Rank_Query::rank);
+    }
+
+    // the same as count_in_range() for every range
+    std::vector<size_type> count_ranges_batch(
+        std::span<const std::pair<key_type, key_type>> ranges,
+        Interval interval = Interval::right_open) const
+    requires (!contains_lazy_tags<node_type>)
+    {
+        auto [lo_bound, hi_bound] = range_bounds(interval);
+
+        std::vector<Rank_Query> queries;
+        queries.reserve(2 * ranges.size());
+
+        for (const auto &[lo, hi] : ranges)
+        {
+            queries.push_back(Rank_Query{&lo, lo_bound, 0});
+            queries.push_back(Rank_Query{&hi, hi_bound, 0});
+        }
+
+        sweep_ranks(queries, true);
+
+        std::vector<size_type> counts(ranges.size());
+        for (auto i = 0uz; i != ranges.size(); ++i)
+        {
+            if (!is_empty_range(ranges[i].first, ranges[i].second, interval))
+                counts[i] = queries[2 * i + 1].rank - queries[2 * i].rank;
+        }
+
+        return counts;
+    }
+
+private:
+
+    // Lookup
+
+    const_base_node_ptr lookup_result(const_base_node_ptr node,
+                                      const_base_node_ptr parent) const override
+    {
+        if (is_frozen())
+            return base_tree::lookup_result(node, parent);
+
+        return lookup_splay(node, parent);
+    }
+
+    // keys of nodes are up to date only after pending updates of all their ancestors are pushed
+    using lookup_strategy =
+        std::conditional_t<contains_lazy_tags<Node_T>, Full_Splay, Splay_Strategy>;
+
+    template<typename Strategy = lookup_strategy>
+    const_base_node_ptr lookup_splay(const_base_node_ptr node, const_base_node_ptr parent) const
+    {
+        const_base_node_ptr end_node = &this->end_;
+
+        if (node)
+        {
+            Strategy::template splay<node_type>(const_cast<base_node_ptr>(node), end_node);
+            return node;
+        }
+        else
+        {
+            if (parent != end_node)
+                Strategy::template splay<node_type>(const_cast<base_node_ptr>(parent), end_node);
+
+            return end_node;
+        }
+    }
+
+    // counts keys less than key splaying the lower bound or the last node on the search path
+    template<typename K>
+    size_type n_preceding(const K &key) const
+    requires contains_subtree_size<node_type>
+    {
+        if (this->empty())
+            return 0;
+
+        if (is_frozen())
+            return peek_n_preceding(key, Split_Bound::lower);
+
+        auto [lower_bound, parent] = this->lower_bound_with_parent(key);
+        return n_less_than_node(const_iterator{lookup_splay<Full_Splay>(lower_bound, parent)});
+    }
+
+    // counts keys preceding the bound of key
+    template<typename K>
+    size_type peek_n_preceding(const K &key, Split_Bound bound) const
+    requires contains_subtree_size<node_type>
+    {
+        size_type n_less = 0;
+
+        for (const_base_node_ptr node = this->get_root(); node; )
+        {
+            auto left = static_cast<const_node_ptr>(node->get_left());
+
+            const key_type &node_key = key_of(node);
+            bool follows = (bound == Split_Bound::lower) ? !this->comp_(node_key, key)
+                                                         : this->comp_(key, node_key);
+            if (follows)
+                node = left;
+            else
+            {
+                n_less += node_type::size(left) + weight(node);
+                node = node->get_right();
+            }
+        }
+
+        return n_less;
+    }
+
+    // Ranges
+
+    /*
+     * Keys of the range are the key of low, keys of the subtree rooted at middle and the key of
+     * high in ascending order; each of the three may be nullptr
+     */
+    struct Range final
+    {
+        const_base_node_ptr first; // equals last if the range is empty
+        const_base_node_ptr last;  // the end node if no key follows the range
+        const_node_ptr low = nullptr;
+        const_node_ptr middle = nullptr;
+        const_node_ptr high = nullptr;
+    };
+
+    template<typename K>
+    bool is_empty_range(const K &lo, const K &hi, Interval interval) const
+    {
+        return this->comp_(hi, lo) || (interval == Interval::open && !this->comp_(lo, hi));
+    }
+
+    // whether key of node follows key with respect to bound
+    template<typename K>
+    bool follows(const_base_node_ptr node, const K &key, Split_Bound bound) const
+    {
+        const key_type &node_key = key_of(node);
+        return (bound == Split_Bound::lower) ? !this->comp_(node_key, key)
+                                             : this->comp_(key, node_key);
+    }
+
+    // bounds that lo and hi are to be split at
+    static std::pair<Split_Bound, Split_Bound> range_bounds(Interval interval) noexcept
+    {
+        bool has_lo = (interval == Interval::closed || interval == Interval::right_open);
+        bool has_hi = (interval == Interval::closed || interval == Interval::left_open);
+
+        return std::pair{has_lo ? Split_Bound::lower : Split_Bound::upper,
+                         has_hi ? Split_Bound::upper : Split_Bound::lower};
+    }
+
+    /*
+     * The search path of lo ends at the last node preceding the range or at the first node of it;
+     * this node is splayed to the root. The search path of hi ends at the last node of the range
+     * or at the first node following it; this node is splayed to the right child of the root, so
+     * that the rest of the range makes up its left subtree
+     */
+    template<typename K>
+    Range splay_range(const K &lo, const K &hi, Interval interval) const
+    {
+        if (is_empty_range(lo, hi, interval))
+        {
+            auto end_node = const_cast<base_node_ptr>(&this->end_);
+            return Range{end_node, end_node};
+        }
+
+        return splay_nonempty_range(lo, hi, interval);
+    }
+
+    // splay_range() for lo and hi known to make up a non-empty interval
+    template<typename K>
+    Range splay_nonempty_range(const K &lo, const K &hi, Interval interval) const
+    {
+        auto end_node = const_cast<base_node_ptr>(&this->end_);
+
+        if (this->empty())
+            return Range{end_node, end_node};
+
+        auto [lo_bound, hi_bound] = range_bounds(interval);
+
+        auto lower = find_boundary(lo, lo_bound);
+        base_node_ptr top = lower.last_visited;
+        splay(top);
+
+        auto upper = find_boundary(hi, hi_bound);
+        base_node_ptr first = lower.first_right;
+        base_node_ptr following = upper.first_right;
+
+        if (first == following)
+            return Range{following, following};
+
+        Range range{first, following};
+
+        if (top == first)
+            range.low = static_cast<const_node_ptr>(top);
+
+        if (base_node_ptr bottom = upper.last_visited; bottom != top)
+        {
+            Full_Splay::splay<node_type>(bottom, top);
+            base_tree::push_node(bottom);
+
+            range.middle = static_cast<const_node_ptr>(bottom->get_left());
+            if (bottom == upper.last_left)
+                range.high = static_cast<const_node_ptr>(bottom);
+        }
+
+        return range;
+    }
+
+    // range queries shared by the overloads for key_type and for keys of a transparent comparator
+
+    template<typename K>
+    size_type do_count_in_range(const K &lo, const K &hi, Interval interval) const
+    {
+        if (is_frozen())
+            return do_peek_count_in_range(lo, hi, interval);
+
+        auto range = splay_range(lo, hi, interval);
+        return (range.low ? weight(range.low) : 0) + node_type::size(range.middle) +
+               (range.high ? weight(range.high) : 0);
+    }
+
+    template<typename K>
+    auto do_aggregate(const K &lo, const K &hi, Interval interval) const
+    {
+        if (is_frozen())
+            return do_peek_aggregate(lo, hi, interval);
+
+        using monoid = typename node_type::monoid_type;
+
+        auto range = splay_range(lo, hi, interval);
+        auto result = node_type::aggregate(range.middle);
+
+        if (range.low)
+            result = monoid::combine(monoid::lift(range.low->get_key()), result);
+        if (range.high)
+            result = monoid::combine(result, monoid::lift(range.high->get_key()));
+
+        return result;
+    }
+
+    template<typename K>
+    std::pair<const_iterator, const_iterator> do_equal_range(const K &key) const
+    {
+        if (is_frozen())
+            return std::pair{peek_lower_bound(key), peek_upper_bound(key)};
+
+        // no comparison of key with itself, which a transparent comparator may lack
+        auto range = splay_nonempty_range(key, key, Interval::closed);
+        return std::pair{const_iterator{range.first}, const_iterator{range.last}};
+    }
+
+    template<typename K, typename Tag>
+    void do_range_apply(const K &lo, const K &hi, const Tag &tag, Interval interval)
+    {
+        if (is_frozen())
+        {
+            peek_range_apply(lo, hi, tag, interval);
+            flush_updates();
+            return;
+        }
+
+        auto range = splay_range(lo, hi, interval);
+        base_node_ptr bottom = nullptr;
+
+        if (range.middle)
+        {
+            auto middle = const_cast<node_ptr>(range.middle);
+            middle->apply(tag);
+            bottom = middle->get_parent();
+        }
+
+        if (range.high)
+        {
+            const_cast<node_ptr>(range.high)->apply_to_key(tag);
+            bottom = const_cast<node_ptr>(range.high);
+        }
+
+        if (range.low)
+            const_cast<node_ptr>(range.low)->apply_to_key(tag);
+
+        if (bottom)
+            this->update_path(bottom);
+        else if (range.low)
+            this->update_node(const_cast<node_ptr>(range.low));
+    }
+
+    template<typename K>
+    size_type do_peek_count_in_range(const K &lo, const K &hi, Interval interval) const
+    {
+        if (is_empty_range(lo, hi, interval))
+            return 0;
+
+        auto [lo_bound, hi_bound] = range_bounds(interval);
+        return peek_n_preceding(hi, hi_bound) - peek_n_preceding(lo, lo_bound);
+    }
+
+    template<typename K>
+    auto do_peek_aggregate(const K &lo, const K &hi, Interval interval) const
+    {
+        using monoid = typename node_type::monoid_type;
+
+        auto result = monoid::identity();
+
+        if (is_empty_range(lo, hi, interval))
+            return result;
+
+        auto [lo_bound, hi_bound] = range_bounds(interval);
+
+        // descends to the highest node of the range
+        auto node = static_cast<const_node_ptr>(this->get_root());
+        while (node)
+        {
+            if (!follows(node, lo, lo_bound))
+                node = static_cast<const_node_ptr>(node->get_right());
+            else if (follows(node, hi, hi_bound))
+                node = static_cast<const_node_ptr>(node->get_left());
+            else
+                break;
+        }
+
+        if (!node)
+            return result;
+
+        // keys of the left subtree following lo are folded from right to left
+        for (auto left = static_cast<const_node_ptr>(node->get_left()); left; )
+        {
+            if (follows(left, lo, lo_bound))
+            {
+                auto suffix = node_type::aggregate(static_cast<const_node_ptr>(left->get_right()));
+                suffix = monoid::combine(monoid::lift(left->get_key()), suffix);
+                result = monoid::combine(suffix, result);
+                left = static_cast<const_node_ptr>(left->get_left());
+            }
+            else
+                left = static_cast<const_node_ptr>(left->get_right());
+        }
+
+        result = monoid::combine(result, monoid::lift(node->get_key()));
+
+        // keys of the right subtree preceding hi are folded from left to right
+        for (auto right = static_cast<const_node_ptr>(node->get_right()); right; )
+        {
+            if (!follows(right, hi, hi_bound))
+            {
+                auto prefix = node_type::aggregate(static_cast<const_node_ptr>(right->get_left()));
+                prefix = monoid::combine(prefix, monoid::lift(right->get_key()));
+                result = monoid::combine(result, prefix);
+                right = static_cast<const_node_ptr>(right->get_right());
+            }
+            else
+                right = static_cast<const_node_ptr>(right->get_left());
+        }
+
+        return result;
+    }
+
+    /*
+     * Tags the keys between lo and hi without restructuring the tree. The nodes tagged are those
+     * peek_aggregate() folds: the highest node of the range and the nodes of the range on the
+     * search paths of lo and hi with their inner subtrees. Pending tags are not pushed on the way
+     * down, so the tree shall have none
+     */
+    template<typename K, typename Tag>
+    void peek_range_apply(const K &lo, const K &hi, const Tag &tag, Interval interval)
+    {
+        if (is_empty_range(lo, hi, interval))
+            return;
+
+        auto [lo_bound, hi_bound] = range_bounds(interval);
+
+        auto node = static_cast<node_ptr>(this->get_root());
+        while (node)
+        {
+            if (!follows(node, lo, lo_bound))
+                node = static_cast<node_ptr>(node->get_right());
+            else if (follows(node, hi, hi_bound))
+                node = static_cast<node_ptr>(node->get_left());
+            else
+                break;
+        }
+
+        if (!node)
+            return;
+
+        node->apply_to_key(tag);
+        node_ptr left_bottom = node, right_bottom = node;
+
+        for (auto left = static_cast<node_ptr>(node->get_left()); left; )
+        {
+            left_bottom = left;
+
+            if (follows(left, lo, lo_bound))
+            {
+                left->apply_to_key(tag);
+                if (auto right = static_cast<node_ptr>(left->get_right()))
+                    right->apply(tag);
+                left = static_cast<node_ptr>(left->get_left());
+            }
+            else
+                left = static_cast<node_ptr>(left->get_right());
+        }
+
+        for (auto right = static_cast<node_ptr>(node->get_right()); right; )
+        {
+            right_bottom = right;
+
+            if (!follows(right, hi, hi_bound))
+            {
+                right->apply_to_key(tag);
+                if (auto left = static_cast<node_ptr>(right->get_left()))
+                    left->apply(tag);
+                right = static_cast<node_ptr>(right->get_right());
+            }
+            else
+                right = static_cast<node_ptr>(right->get_left());
+        }
+
+        this->update_path(left_bottom);
+        this->update_path(right_bottom);
+    }
+
+    // descends to the node of rank k; returns nullptr if there is none
+    const_base_node_ptr select_node(size_type k) const
+    requires contains_subtree_size<node_type>
+    {
+        const_base_node_ptr node = this->get_root();
+
+        while (node)
+        {
+            auto left_size = node_type::size(static_cast<const_node_ptr>(node->get_left()));
+
+            if (k < left_size)
+                node = node->get_left();
+            else if (k - left_size < weight(node))
+                break;
+            else
+            {
+                k -= left_size + weight(node);
+                node = node->get_right();
+            }
+        }
+
+        return node;
+    }
+
+    // the number of keys preceding key with respect to bound, found by sweep_ranks()
+    struct Rank_Query final
+    {
+        const key_type *key;
+        Split_Bound bound;
+        size_type rank;
+    };
+
+    // relative ranks are only valid relative to each other
+    void sweep_ranks(std::span<Rank_Query> queries, bool relative = false) const
+    {
+        std::vector<size_type> order(queries.size());
+        std::iota(order.begin(), order.end(), 0uz);
+
+        // queries of one key are answered in the order of their bounds, i.e. lower ones first
+        std::ranges::sort(order, [this, queries](size_type lhs, size_type rhs)
+        {
+            const Rank_Query &l = queries[lhs];
+            const Rank_Query &r = queries[rhs];
+
+            if (this->comp_(*l.key, *r.key))
+                return true;
+            if (this->comp_(*r.key, *l.key))
+                return false;
+            return l.bound == Split_Bound::lower && r.bound == Split_Bound::upper;
+        });
+
+        const_base_node_ptr end_node = &this->end_;
+        const_base_node_ptr node = this->get_leftmost();
+        size_type rank = 0;
+
+        const auto [step_limit, climb_limit] = sweep_limits(queries.size());
+
+        // without subtree sizes the sweep of relative ranks starts at the first query
+        if constexpr (!contains_subtree_size<node_type>)
+        {
+            if (relative && !order.empty())
+            {
+                const Rank_Query &first = queries[order.front()];
+                auto [found, parent] = (first.bound == Split_Bound::lower)
+                                     ? this->lower_bound_with_parent(*first.key)
+                                     : this->upper_bound_with_parent(*first.key);
+                node = found ? found : end_node;
+            }
+        }
+
+        for (auto i : order)
+        {
+            Rank_Query &query = queries[i];
+
+            for (size_type step = 0; node != end_node && precedes(node, query); ++step)
+            {
+                if constexpr (contains_subtree_size<node_type>)
+                {
+                    if (step == step_limit)
+                    {
+                        std::tie(node, rank) = leap(node, rank, query, climb_limit);
+                        break;
+                    }
+                }
+
+                rank += weight(node);
+                node = node->successor();
+            }
+
+            query.rank = rank;
+        }
+    }
+
+    /*
+     * The number of nodes the sweep steps over before it leaps and the number of levels a leap
+     * climbs before it descends from the root, chosen as explained at sweep_walk_gap
+     */
+    struct Sweep_Limits final
+    {
+        size_type n_steps;
+        size_type n_levels;
+    };
+
+    Sweep_Limits sweep_limits(size_type n_queries) const noexcept
+    {
+        size_type gap = this->size() / std::max(n_queries, 1uz);
+
+        if (gap <= sweep_walk_gap)
+            return Sweep_Limits{sweep_walk_gap, sweep_climb_limit};
+
+        bool is_sparse = gap > this->size() / gap;
+        return Sweep_Limits{1, is_sparse ? 0 : sweep_climb_limit};
+    }
+
+    bool precedes(const_base_node_ptr node, const Rank_Query &query) const
+    {
+        return (query.bound == Split_Bound::lower) ? this->comp_(key_of(node), *query.key)
+                                                   : !this->comp_(*query.key, key_of(node));
+    }
+
+    /*
+     * Finger search from node of the given rank preceding the query: climbs to the lowest ancestor
+     * which subtree spans the query and descends from there counting the keys passed by. A climb
+     * longer than climb_limit levels gives way to a descent from the root. Returns the first node
+     * following the query and the number of keys preceding it
+     */
+    std::pair<const_base_node_ptr, size_type> leap(const_base_node_ptr node, size_type rank,
+                                                   const Rank_Query &query,
+                                                   size_type climb_limit) const
+    requires contains_subtree_size<node_type>
+    {
+        auto left_size = [](const_base_node_ptr node)
+        {
+            return node_type::size(static_cast<const_node_ptr>(node->get_left()));
+        };
+
+        const_base_node_ptr end_node = &this->end_;
+        const_base_node_ptr bound = end_node;
+
+        // the number of keys preceding the subtree of node
+        size_type n_before = rank - left_size(node);
+
+        size_type height = 0;
+        for (const_base_node_ptr parent; (parent = node->get_parent()) != end_node; node = parent)
+        {
+            if (++height > climb_limit)
+            {
+                node = this->get_root();
+                n_before = 0;
+                break;
+            }
+
+            if (!node->is_left_child())
+                n_before -= left_size(parent) + weight(parent);
+            else if (!precedes(parent, query))
+            {
+                bound = parent;
+                break;
+            }
+        }
+
+        while (node)
+        {
+            if (!precedes(node, query))
+                bound = std::exchange(node, node->get_left());
+            else
+            {
+                n_before += left_size(node) + weight(node);
+                node = node->get_right();
+            }
+        }
+
+        return std::pair{bound, n_before};
+    }
+
+    // counts keys less than the key of node walking up to the root
+    size_type peek_rank(const_base_node_ptr node) const
+    requires contains_subtree_size<node_type>
+    {
+        size_type n_less = node_type::size(static_cast<const_node_ptr>(node->get_left()));
+
+        for (const_base_node_ptr end_node = &this->end_; node->get_parent() != end_node; )
+        {
+            const_base_node_ptr parent = node->get_parent();
+
+            if (!node->is_left_child())
+                n_less += node_type::size(static_cast<const_node_ptr>(parent->get_left())) +
+                          weight(parent);
+
+            node = parent;
+        }
+
+        return n_less;
+    }
+
+    size_type n_less_than_node(const_iterator it) const
+    requires contains_subtree_size<node_type>
+    {
+        if (it == this->end())
+            return this->total_count();
+        else
+        {
+            const_base_node_ptr node = base_tree::const_base_ptr(it);
+            return node_type::size(static_cast<const_node_ptr>(node->get_left()));
+        }
+    }
+
+    // Modifiers
+
+    void do_insert(base_node_ptr new_node, base_node_ptr parent) override
+    {
+        if (!splay_on_append_ && parent == this->get_rightmost() && parent != &this->end_ &&
+            this->comp_(key_of(parent), key_of(new_node)))
+            base_tree::do_insert(new_node, parent);
+        else
+            link_node(new_node, parent);
+    }
+
+    // makes new_node a child of parent and splays parent
+    void link_node(base_node_ptr new_node, base_node_ptr parent)
+    {
+        assert(parent);
+        assert(!parent->get_left() || !parent->get_right());
+
+        const key_type &key = key_of(new_node);
+        base_node_ptr end_node = &this->end_;
+
+        if (parent == end_node)
+        {
+            new_node->set_left_thread(end_node);
+            new_node->set_right_thread(end_node);
+
+            parent->set_left(new_node);
+        }
+        else if (this->comp_(key, static_cast<node_ptr>(parent)->get_key()))
+        {
+            base_node_ptr predecessor = parent->get_left_unsafe();
+
+            splay(parent);
+
+            if (predecessor == end_node) // parent is leftmost
+                new_node->set_left_thread(end_node);
+            else
+            {
+                base_node_ptr left = parent->get_left_unsafe();
+                left->set_parent(new_node);
+                predecessor->set_right_thread(new_node);
+                new_node->set_left(left);
+            }
+
+            new_node->set_right_thread(parent);
+            parent->set_left(new_node);
+
+            this->update_node(new_node);
+            this->update_node(parent);
+        }
+        else
+        {
+            base_node_ptr successor = parent->get_right_unsafe();
+
+            splay(parent);
+
+            if (successor == end_node) // parent is rightmost
+                new_node->set_right_thread(end_node);
+            else
+            {
+                base_node_ptr right = parent->get_right_unsafe();
+                right->set_parent(new_node);
+                successor->set_left_thread(new_node);
+                new_node->set_right(right);
+            }
+
+            new_node->set_left_thread(parent);
+            parent->set_right(new_node);
+
+            this->update_node(new_node);
+            this->update_node(parent);
+        }
+    }
+
+    // inserts a node detached from some tree; returns false if its key is already in the tree
+    bool insert_node(base_node_ptr node)
+    {
+        const key_type &key = key_of(node);
+        auto [found, parent] = this->find_with_parent(key);
+
+        if (found)
+        {
+            lookup_splay<Full_Splay>(found, parent);
+            return false;
+        }
+
+        auto new_parent = const_cast<base_node_ptr>(parent);
+        node->set_parent(new_parent);
+        link_node(node, new_parent);
+
+        if (this->get_leftmost() == &this->end_)
+        {
+            this->set_leftmost(node);
+            this->set_rightmost(node);
+        }
+        else if (this->comp_(key, key_of(this->get_leftmost())))
+            this->set_leftmost(node);
+        else if (this->comp_(key_of(this->get_rightmost()), key))
+            this->set_rightmost(node);
+
+        if (this->size_ != base_tree::unknown_size)
+            this->size_++;
+
+        return true;
+    }
+
+    void unlink_node(base_node_ptr node) override
+    {
+        assert(node);
+
+        splay(node);
+
+        base_node_ptr left = node->get_left();
+        base_node_ptr right = node->get_right();
+
+        if (left)
+        {
+            if (right)
+            {
+                this->set_root(left);
+                left->set_parent(&this->end_);
+
+                base_node_ptr predecessor = left->maximum();
+                splay(predecessor);
+                predecessor->set_right(right);
+                right->set_parent(predecessor);
+                this->update_node(predecessor);
+
+                base_node_ptr successor = right->minimum();
+                successor->set_left_thread(predecessor);
+            }
+            else
+            {
+                this->transplant(node, left);
+                base_node_ptr predecessor = left->maximum();
+                predecessor->set_right_thread(node->get_right_unsafe());
+            }
+        }
+        else if (right)
+        {
+            this->transplant(node, right);
+            base_node_ptr successor = right->minimum();
+            successor->set_left_thread(node->get_left_unsafe());
+        }
+        else // node is the only one
+            this->set_root(nullptr);
+    }
+
+    // Split
+
+    struct Boundary final
+    {
+        base_node_ptr last_left;   // the end node if there is none
+        base_node_ptr first_right; // the end node if there is none
+        base_node_ptr last_visited;
+    };
+
+    /*
+     * Finds the last node preceding the bound and the first node following it. Both are on the
+     * search path, so one of them is its last node
+     */
+    template<typename K>
+    Boundary find_boundary(const K &key, Split_Bound bound) const
+    {
+        auto end_node = const_cast<base_node_ptr>(&this->end_);
+        Boundary boundary{end_node, end_node, end_node};
+
+        for (auto node = const_cast<base_node_ptr>(this->get_root()); node; )
+        {
+            boundary.last_visited = node;
+
+            const key_type &node_key = key_of(node);
+            bool follows = (bound == Split_Bound::lower) ? !this->comp_(node_key, key)
+                                                         : this->comp_(key, node_key);
+            if (follows)
+                boundary.first_right = std::exchange(node, node->get_left());
+            else
+                boundary.last_left = std::exchange(node, node->get_right());
+        }
+
+        return boundary;
+    }
+
+    // leaves keys preceding the bound in this tree and returns the rest
+    template<typename K>
+    Splay_Tree_Base cut(const K &key, Split_Bound bound)
+    {
+        // both trees share the allocator as nodes of one of them may be freed by the other
+        Splay_Tree_Base right_tree{this->comp_, this->get_allocator()};
+
+        if (this->empty())
+            return right_tree;
+
+        base_node_ptr end_node = &this->end_;
+        auto [last_left, first_right, parent] = find_boundary(key, bound);
+
+        splay(parent);
+
+        if (first_right == end_node)
+            return right_tree;
+
+        if (last_left == end_node)
+        {
+            base_tree::swap(right_tree);
+            return right_tree;
+        }
+
+        // the search ends at a leaf child of one of the boundary nodes, so one of them is the root
+        base_node_ptr right_root;
+
+        if (parent == last_left)
+        {
+            right_root = last_left->get_right();
+            last_left->set_right_thread(end_node);
+            this->update_node(last_left);
+        }
+        else
+        {
+            right_root = first_right;
+
+            base_node_ptr left_root = first_right->get_left();
+            first_right->set_left_thread(end_node);
+            this->update_node(first_right);
+
+            this->set_root(left_root);
+            left_root->set_parent(end_node);
+        }
+
+        right_tree.set_root(right_root);
+        right_tree.set_leftmost(first_right);
+        right_tree.set_rightmost(this->get_rightmost());
+        // the boundary threads still lead to our end node
+        right_tree.adjust_tree_to_end_node_of(right_tree);
+        this->set_rightmost(last_left);
+        last_left->set_right_thread(end_node);
+
+        // sizes of subtrees of multisets count occurrences rather than nodes
+        if constexpr (contains_subtree_size<node_type> && !contains_key_count<node_type>)
+        {
+            const auto right_size = node_type::size(static_cast<node_ptr>(right_root));
+            right_tree.size_ = right_size;
+            this->size_ -= right_size;
+        }
+        else
+        {
+            right_tree.size_ = base_tree::unknown_size;
+            this->size_ = base_tree::unknown_size;
+        }
+
+        return right_tree;
+    }
+
+    // Batches
+
+    std::vector<key_type> sorted_batch(std::span<const key_type> keys) const
+    {
+        std::vector<key_type> batch(keys.begin(), keys.end());
+        std::ranges::sort(batch, this->comp_);
+
+        auto duplicates = std::ranges::unique(batch, [this](const key_type &lhs,
+                                                             const key_type &rhs)
+                                                      { return !this->comp_(lhs, rhs); });
+        batch.erase(duplicates.begin(), duplicates.end());
+
+        return batch;
+    }
+
+    // whether batch makes up at least 1 / batch_rebuild_ratio of the slice of the tree it spans
+    bool is_dense_in_slice(std::span<const key_type> batch) const
+    {
+        if (batch.empty())
+            return false;
+
+        const size_type max_slice_size = batch.size() * batch_rebuild_ratio;
+
+        if constexpr (contains_subtree_size<node_type>)
+            return count_in_range(batch.front(), batch.back(), Interval::closed) <= max_slice_size;
+        else
+        {
+            // the walk along the slice stops as soon as it turns out too large
+            size_type slice_size = 0;
+            for (auto it = this->lower_bound(batch.front()), ite = this->end();
+                 it != ite && !this->comp_(batch.back(), key_of(it)); ++it)
+            {
+                if (++slice_size > max_slice_size)
+                    return false;
+            }
+
+            return true;
+        }
+    }
+
+    /*
+     * Splits off the slice of the tree between the least and the greatest keys of batch, lets
+     * rebuild change it and joins the three parts back. rebuild shall not allocate
+     */
+    template<typename Rebuild>
+    size_type in_slice(std::span<const key_type> batch, Rebuild rebuild)
+    {
+        const auto old_size = this->size();
+
+        auto [left, rest] = std::move(*this).split(batch.front(), Split_Bound::lower);
+        auto [slice, right] = std::move(rest).split(batch.back(), Split_Bound::upper);
+
+        // halves of a tree without subtree sizes lose their sizes, but the slice counts its own
+        const auto old_slice_size = slice.size();
+        size_type n_changed = rebuild(slice);
+        const auto new_size = old_size - old_slice_size + slice.size();
+
+        [[maybe_unused]] bool is_joined = left.join(std::move(slice)) &&
+                                          left.join(std::move(right));
+        assert(is_joined);
+
+        base_tree::swap(left);
+        this->size_ = new_size;
+
+        return n_changed;
+    }
+
+    // merges a sorted list of fresh nodes into the tree; returns the number of keys it adds
+    size_type merge_list(base_node_ptr fresh)
+    {
+        const auto old_size = this->size();
+        base_node_ptr old = this->unlink_list();
+        Node_List merged;
+
+        while (old && fresh)
+        {
+            if (this->comp_(key_of(old), key_of(fresh)))
+                merged.append(pop_front(old));
+            else if (this->comp_(key_of(fresh), key_of(old)))
+                merged.append(pop_front(fresh));
+            else
+                this->destroy_node(pop_front(fresh));
+        }
+
+        merged.append_list(old ? old : fresh);
+        this->link_list(merged.head, merged.size);
+
+        return this->size() - old_size;
+    }
+
+    // erases keys of sorted batch rebuilding the tree; returns the number of erased keys
+    size_type filter_out(std::span<const key_type> batch)
+    {
+        const auto old_size = this->size();
+        base_node_ptr old = this->unlink_list();
+        Node_List kept;
+
+        for (auto key = batch.begin(), last_key = batch.end(); old; )
+        {
+            while (key != last_key && this->comp_(*key, key_of(old)))
+                ++key;
+
+            if (key != last_key && !this->comp_(key_of(old), *key))
+                this->destroy_node(pop_front(old));
+            else
+                kept.append(pop_front(old));
+        }
+
+        kept.append_list(nullptr);
+        this->link_list(kept.head, kept.size);
+
+        return old_size - this->size();
+    }
+
+    // Set operations
+
+    enum class Set_Operation { unite, intersect, subtract };
+
+    // joins rhs if key ranges of the trees do not overlap; rhs shall not be empty
+    bool join_disjoint(Splay_Tree_Base &rhs)
+    {
+        // nodes of rhs may end up in this tree whatever its size
+        if (is_frozen())
+            rhs.flush_updates();
+
+        if (this->empty() ||
+            this->comp_(key_of(this->get_rightmost()), key_of(rhs.get_leftmost())))
+            return join(std::move(rhs));
+
+        if (this->comp_(key_of(rhs.get_rightmost()), key_of(this->get_leftmost())))
+        {
+            rhs.join(std::move(*this));
+            base_tree::swap(rhs);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool comparable_sizes(const Splay_Tree_Base &rhs) const noexcept
+    {
+        const auto [min, max] = std::minmax({this->size(), rhs.size()});
+        return min * batch_rebuild_ratio >= max;
+    }
+
+    // runs are taken as a whole while every long run pays for two short ones (and two more)
+    struct Run_Balance
+    {
+        size_type n_short = 0;
+        size_type n_long = 0;
+
+        bool admit(bool is_short) noexcept
+        {
+            ++(is_short ? n_short : n_long);
+            return n_short <= 2 * (n_long + 1);
+        }
+    };
+
+    // whether fewer than min_length keys of tree precede the bound; walks along threads
+    bool is_short_run(const Splay_Tree_Base &tree, const key_type &key, Split_Bound bound,
+                      size_type min_length) const
+    {
+        auto it = tree.begin();
+
+        for (size_type length = 0; length != min_length; ++length, ++it)
+        {
+            if (it == tree.end() || follows(base_tree::base_ptr(it), key, bound))
+                return true;
+        }
+
+        return false;
+    }
+
+    // moves keys of from that precede the bound to the end of to
+    static void take_run(Splay_Tree_Base &from, const key_type &key, Split_Bound bound,
+                         Splay_Tree_Base &to)
+    {
+        auto [run, rest] = std::move(from).split(key, bound);
+        from.base_tree::swap(rest);
+
+        [[maybe_unused]] bool is_joined = to.join(std::move(run));
+        assert(is_joined);
+    }
+
+    // joins the tree to head, which keys precede ours, and takes the result
+    void append_to(Splay_Tree_Base &head)
+    {
+        [[maybe_unused]] bool is_joined = head.join(std::move(*this));
+        assert(is_joined);
+
+        base_tree::swap(head);
+    }
+
+    /*
+     * Moves it to the first key of tree not less than key; returns false if there is no such key.
+     * Walks walk_limit steps along threads before it resorts to lower_bound()
+     */
+    bool seek_not_less(const Splay_Tree_Base &tree, const_iterator &it, const key_type &key,
+                       size_type walk_limit) const
+    {
+        for (size_type step = 0; step != walk_limit; ++step, ++it)
+        {
+            if (it == tree.end() || !this->comp_(key_of(it), key))
+                return it != tree.end();
+        }
+
+        it = tree.lower_bound(key);
+        return it != tree.end();
+    }
+
+    void subtract_runs(const Splay_Tree_Base &rhs)
+    {
+        const size_type old_size = this->size();
+        const size_type min_run_length = std::bit_width(old_size + rhs.size());
+        Run_Balance balance;
+        size_type n_erased = 0;
+        Splay_Tree_Base kept{this->comp_, this->get_allocator()};
+        auto it = rhs.begin();
+
+        while (!this->empty() &&
+               seek_not_less(rhs, it, key_of(this->get_leftmost()), min_run_length))
+        {
+            const key_type &bound_key = key_of(it);
+            bool is_erased = !this->comp_(key_of(this->get_leftmost()), bound_key);
+
+            if (!balance.admit(is_erased || is_short_run(*this, bound_key, Split_Bound::lower,
+                                                         min_run_length)))
+                break;
+
+            if (is_erased)
+            {
+                this->erase(this->begin());
+                ++n_erased;
+            }
+            else
+                take_run(*this, bound_key, Split_Bound::lower, kept);
+        }
+
+        // the loop stops early only if rhs has keys left
+        if (!this->empty() && it != rhs.end())
+        {
+            n_erased += filter_nodes([this, &rhs, &it, min_run_length](const key_type &key)
+            {
+                return !seek_not_less(rhs, it, key, min_run_length) ||
+                       this->comp_(key, key_of(it));
+            });
+        }
+
+        append_to(kept);
+        this->size_ = old_size - n_erased;
+    }
+
+    // keeps nodes which keys satisfy pred; pred is called for keys in ascending order
+    template<typename Pred>
+    size_type filter_nodes(Pred pred)
+    {
+        Node_List kept;
+        size_type n_dropped = 0;
+
+        for (base_node_ptr list = this->unlink_list(); list; )
+        {
+            if (pred(key_of(list)))
+                kept.append(pop_front(list));
+            else
+            {
+                this->destroy_node(pop_front(list));
+                ++n_dropped;
+            }
+        }
+
+        kept.append_list(nullptr);
+        this->link_list(kept.head, kept.size);
+
+        return n_dropped;
+    }
+
+    bool is_parallel_worthy(const Splay_Tree_Base &rhs) const noexcept
+    {
+        return base_tree::node_alloc_traits::is_always_equal::value &&
+               this->size() + rhs.size() >= parallel_set_operation_threshold;
+    }
+
+    std::vector<base_node_ptr> gather_nodes() const
+    {
+        base_tree::push_all_tags();
+
+        std::vector<base_node_ptr> nodes;
+        nodes.reserve(this->size());
+
+        for (auto it = this->begin(), ite = this->end(); it != ite; ++it)
+            nodes.push_back(base_tree::base_ptr(it));
+
+        return nodes;
+    }
+
+    // Rhs_Tree is const for the operations that do not steal nodes of rhs
+    template<Set_Operation Op, typename Rhs_Tree>
+    void parallel_merge(Rhs_Tree &rhs)
+    {
+        // all memory is allocated before any node is unlinked
+        auto lhs_nodes = gather_nodes();
+        auto rhs_nodes = rhs.gather_nodes();
+
+        const auto n_chunks =
+            std::min<size_type>(std::max(1u, std::thread::hardware_concurrency()),
+                                std::max(lhs_nodes.size(), rhs_nodes.size()));
+        const auto &pivots = (lhs_nodes.size() < rhs_nodes.size()) ? rhs_nodes : lhs_nodes;
+
+        // chunk i covers keys in [pivot i, pivot i + 1)
+        std::vector<std::pair<size_type, size_type>> bounds{{0, 0}};
+        bounds.reserve(n_chunks + 1);
+
+        auto by_key = [this](const_base_node_ptr lhs, const key_type &key)
+                      { return this->comp_(key_of(lhs), key); };
+
+        for (size_type i = 1; i != n_chunks; ++i)
+        {
+            const key_type &pivot = key_of(pivots[i * pivots.size() / n_chunks]);
+            bounds.emplace_back(
+                std::lower_bound(lhs_nodes.begin(), lhs_nodes.end(), pivot, by_key) -
+                    lhs_nodes.begin(),
+                std::lower_bound(rhs_nodes.begin(), rhs_nodes.end(), pivot, by_key) -
+                    rhs_nodes.begin());
+        }
+
+        bounds.emplace_back(lhs_nodes.size(), rhs_nodes.size());
+
+        // chunk i writes its result from position lhs bound + rhs bound onwards
+        std::vector<base_node_ptr> result(lhs_nodes.size() +
+                                          (Op == Set_Operation::unite ? rhs_nodes.size() : 0));
+        std::vector<size_type> n_results(n_chunks);
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(n_chunks);
+
+        this->reset();
+        this->size_ = 0;
+
+        if constexpr (Op == Set_Operation::unite)
+        {
+            this->adopt_allocator_of(rhs);
+            rhs.reset();
+            rhs.size_ = 0;
+        }
+
+        auto merge_chunk = [&, this](size_type i)
+        {
+            auto [lhs_first, rhs_first] = bounds[i];
+            auto [lhs_last, rhs_last] = bounds[i + 1];
+            auto offset = lhs_first + (Op == Set_Operation::unite ? rhs_first : 0);
+
+            n_results[i] = merge_ranges<Op>(
+                std::span{lhs_nodes}.subspan(lhs_first, lhs_last - lhs_first),
+                std::span{rhs_nodes}.subspan(rhs_first, rhs_last - rhs_first),
+                result.begin() + offset);
+        };
+
+        for (size_type i = 1; i < n_chunks; ++i)
+            tasks.push_back(std::async(merge_chunk, i));
+
+        merge_chunk(0);
+
+        for (auto &task : tasks)
+            task.get();
+
+        // closes gaps between the results of chunks
+        auto last = result.begin() + n_results[0];
+        for (size_type i = 1; i != n_chunks; ++i)
+        {
+            auto first = result.begin() + bounds[i].first +
+                         (Op == Set_Operation::unite ? bounds[i].second : 0);
+            last = std::copy(first, first + n_results[i], last);
+        }
+
+        result.erase(last, result.end());
+        this->link_array(result, base_tree::parallel_depth());
+    }
+
+    // merges sorted ranges of nodes into out according to Op; returns the number of nodes kept
+    template<Set_Operation Op, typename Out>
+    size_type merge_ranges(std::span<const base_node_ptr> lhs, std::span<const base_node_ptr> rhs,
+                           Out out)
+    {
+        size_type n_kept = 0;
+        auto keep = [&out, &n_kept](base_node_ptr node) { *out++ = node; n_kept++; };
+
+        auto l = lhs.begin();
+        auto r = rhs.begin();
+
+        while (l != lhs.end() && r != rhs.end())
+        {
+            if (this->comp_(key_of(*l), key_of(*r)))
+            {
+                if constexpr (Op == Set_Operation::intersect)
+                    this->destroy_node(*l++);
+                else
+                    keep(*l++);
+            }
+            else if (this->comp_(key_of(*r), key_of(*l)))
+            {
+                if constexpr (Op == Set_Operation::unite)
+                    keep(*r);
+                ++r;
+            }
+            else
+            {
+                if constexpr (Op == Set_Operation::subtract)
+                    this->destroy_node(*l++);
+                else
+                    keep(*l++);
+
+                if constexpr (Op == Set_Operation::unite)
+                    this->destroy_node(*r);
+                ++r;
+            }
+        }
+
+        for (; l != lhs.end(); ++l)
+        {
+            if constexpr (Op == Set_Operation::intersect)
+                this->destroy_node(*l);
+            else
+                keep(*l);
+        }
+
+        if constexpr (Op == Set_Operation::unite)
+        {
+            for (; r != rhs.end(); ++r)
+                keep(*r);
+        }
+
+        return n_kept;
+    }
+
+    // list of nodes chained by right links
+    struct Node_List final
+    {
+        void append(base_node_ptr node) noexcept
+        {
+            if (tail)
+                tail->set_right(node);
+            else
+                head = node;
+
+            tail = node;
+            size++;
+        }
+
+        // appends all nodes of list and terminates the result
+        void append_list(base_node_ptr list) noexcept
+        {
+            for (; list; list = list->get_right_unsafe())
+                append(list);
+
+            if (tail)
+                tail->set_right(nullptr);
+        }
+
+        base_node_ptr head = nullptr;
+        base_node_ptr tail = nullptr;
+        size_type size = 0;
+    };
+
+    static base_node_ptr pop_front(base_node_ptr &list) noexcept
+    {
+        return std::exchange(list, list->get_right_unsafe());
+    }
+
+    // the root is left without pending updates, so that its children may be relinked
+    void splay(base_node_ptr node) const
+    {
+        Full_Splay::splay<node_type>(node, &this->end_);
+        base_tree::push_node(node);
+    }
+
+    bool frozen_ = false;
+    bool splay_on_append_ = true;
 };
 
 } // namespace yLab
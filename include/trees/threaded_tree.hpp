@@ -0,0 +1,435 @@
+#ifndef INCLUDE_TREES_THREADED_TREE_HPP
+#define INCLUDE_TREES_THREADED_TREE_HPP
+
+#include <utility>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <ostream>
+#include <algorithm>
+#include <compare>
+#include <memory>
+#include <atomic>
+#include <limits>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "nodes/node_base.hpp"
+#include "nodes/node_concepts.hpp"
+#include "trees/threaded_tree_base.hpp"
+#include "tree_iterator.hpp"
+
+namespace yLab
+{
+
+/*
+ * Comparators like std::less<> that compare keys with objects of other types. Trees ordered by
+ * them look such objects up directly instead of converting them to keys first
+ */
+template<typename Compare>
+concept transparent_comparator = requires { typename Compare::is_transparent; };
+
+// range queries compare their bounds with each other as well as with keys
+template<typename Compare, typename K, typename Key>
+concept transparent_range_comparator = transparent_comparator<Compare> &&
+                                       std::relation<const Compare &, const K &, const Key &>;
+
+// the part of a split the splitting key goes to: the right one for lower, the left one for upper
+enum class Split_Bound { lower, upper };
+
+// orders values of maps by their keys
+template<typename Value_T, typename Compare>
+class Value_Compare
+{
+public:
+
+    explicit Value_Compare(const Compare &comp) : comp_(comp) {}
+
+    bool operator()(const Value_T &lhs, const Value_T &rhs) const
+    {
+        return comp_(lhs.first, rhs.first);
+    }
+
+protected:
+
+    Compare comp_;
+};
+
+/*
+ * The part of threaded search trees that does not depend on how they are searched and
+ * restructured: keys, sizes, iteration and dumps. The end node and the lifetime of nodes come
+ * from Threaded_Tree_Base
+ */
+template<typename Node_T, typename Compare, typename Allocator>
+class Threaded_Tree : public Threaded_Tree_Base<Node_T, Allocator>
+{
+    using tree_base = Threaded_Tree_Base<Node_T, Allocator>;
+
+protected:
+
+    using typename tree_base::base_node_type;
+    using typename tree_base::base_node_ptr;
+    using typename tree_base::const_base_node_ptr;
+    using typename tree_base::node_ptr;
+    using typename tree_base::const_node_ptr;
+    using typename tree_base::node_type;
+    using typename tree_base::node_allocator_type;
+    using typename tree_base::node_alloc_traits;
+    using tree_base::has_parent_links;
+
+public:
+
+    using key_type = typename node_type::key_type;
+    using key_compare = Compare;
+    using value_type = typename node_type::value_type;
+    using value_compare = std::conditional_t<std::same_as<key_type, value_type>, key_compare,
+                                             Value_Compare<value_type, key_compare>>;
+    using pointer = value_type *;
+    using const_pointer = const value_type *;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using typename tree_base::size_type;
+    using difference_type = std::ptrdiff_t;
+    using iterator = tree_iterator<node_type>;
+    using const_iterator = iterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = reverse_iterator;
+    using typename tree_base::allocator_type;
+
+    Threaded_Tree(const Threaded_Tree &rhs) = delete;
+    Threaded_Tree &operator=(const Threaded_Tree &rhs) = delete;
+    Threaded_Tree &operator=(Threaded_Tree &&rhs) = delete;
+
+    // observers
+
+    key_compare key_comp() const { return comp_; }
+    value_compare value_comp() const { return value_compare(key_comp()); }
+    using tree_base::get_allocator;
+
+    // capacity
+
+    /*
+     * A tree split without subtree sizes does not know its size: it is counted in O(n) by the
+     * first call and cached. Concurrent calls on a tree that is not modified are safe
+     */
+    size_type size() const noexcept
+    {
+        std::atomic_ref size{size_};
+
+        if (auto n = size.load(std::memory_order_relaxed); n != unknown_size)
+            return n;
+
+        auto n = static_cast<size_type>(std::distance(begin(), end()));
+        size.store(n, std::memory_order_relaxed);
+
+        return n;
+    }
+
+    using tree_base::empty;
+
+    // iterators
+
+    const_iterator begin() const noexcept { return const_iterator{get_leftmost()}; }
+    const_iterator end() const noexcept { return const_iterator{&end_}; }
+
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
+
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    // Modifiers
+
+    void swap(Threaded_Tree &rhs) noexcept (std::is_nothrow_swappable_v<key_compare> &&
+                                            std::is_nothrow_swappable_v<node_allocator_type>)
+    {
+        tree_base::swap(rhs);
+
+        std::swap(size_, rhs.size_);
+        std::swap(comp_, rhs.comp_);
+    }
+
+    void clear() noexcept
+    {
+        clean_up();
+        reset();
+        size_ = 0;
+    }
+
+    void graphic_dump(std::ostream &os) const
+    {
+        os << "digraph Tree\n"
+              "{\n"
+              "    rankdir = TB;\n"
+              "    node [shape = record];\n\n";
+
+        const_base_node_ptr end_node = &end_;
+
+        dot_dump(os, *end_node);
+        if (!empty())
+            dump_subtree(os, static_cast<const_node_ptr>(get_root()));
+
+        os << '\n';
+
+        for (auto node = get_leftmost(); node != end_node; node = node->successor())
+            arrow_dump(os, node);
+
+        if (!empty())
+            fmt::print(os, "    node_{} -> node_{} [color = \"blue\"];\n",
+                       fmt::ptr(end_node), fmt::ptr(end_node->get_left_unsafe()));
+
+        os << '}' << std::endl;
+    }
+
+    bool subtree_sizes_verifier() const
+    requires contains_subtree_size<node_type>
+    {
+        for (auto it = begin(), ite = end(); it != ite; ++it)
+        {
+            const_node_ptr node = const_ptr(it);
+
+            auto expected_size = weight(node)
+                               + node_type::size(static_cast<const_node_ptr>(node->get_left()))
+                               + node_type::size(static_cast<const_node_ptr>(node->get_right()));
+
+            if (expected_size != node_type::size(node))
+                return false;
+        }
+
+        return true;
+    }
+
+protected:
+
+    static constexpr size_type unknown_size = std::numeric_limits<size_type>::max();
+
+    explicit Threaded_Tree(const key_compare &comp, const allocator_type &alloc)
+        : tree_base(alloc), comp_(comp) {}
+
+    Threaded_Tree(Threaded_Tree &&rhs)
+        noexcept (std::is_nothrow_move_constructible_v<key_compare> &&
+                  std::is_nothrow_move_constructible_v<node_allocator_type>)
+        : tree_base(std::move(rhs)), size_{std::exchange(rhs.size_, 0)},
+          comp_(std::move(rhs.comp_)) {}
+
+    ~Threaded_Tree() = default;
+
+    // access to underlying pointer of iterators
+
+    static const_base_node_ptr const_base_ptr(iterator it) noexcept { return it.node_; }
+
+    static base_node_ptr base_ptr(iterator it) noexcept
+    {
+        return const_cast<base_node_ptr>(const_base_ptr(it));
+    }
+
+    static const_node_ptr const_ptr(iterator it) noexcept
+    {
+        return static_cast<const_node_ptr>(const_base_ptr(it));
+    }
+
+    static node_ptr ptr(iterator it) noexcept { return const_cast<node_ptr>(const_ptr(it)); }
+
+    static const key_type &key_of(const_base_node_ptr node)
+    {
+        return static_cast<const_node_ptr>(node)->get_key();
+    }
+
+    static const key_type &key_of(iterator it) { return key_of(const_base_ptr(it)); }
+
+    // the number of occurrences of the key of node
+    static size_type weight(const_base_node_ptr node) noexcept
+    {
+        if constexpr (contains_key_count<node_type>)
+            return static_cast<const_node_ptr>(node)->count();
+        else
+            return 1;
+    }
+
+    using tree_base::get_root;
+    using tree_base::set_root;
+    using tree_base::get_leftmost;
+    using tree_base::set_leftmost;
+    using tree_base::get_rightmost;
+    using tree_base::set_rightmost;
+    using tree_base::create_node;
+    using tree_base::destroy_node;
+    using tree_base::adopt_allocator_of;
+    using tree_base::adopt_allocator;
+    using tree_base::clean_up;
+    using tree_base::reset;
+    using tree_base::take_ownership_of_tree_of;
+    using tree_base::adjust_tree_to_end_node_of;
+    using tree_base::update_node;
+
+    /*
+     * Links the longest strictly increasing prefix of [first, last) into a perfectly balanced tree
+     * in O(n) and returns the iterator past the prefix. The tree shall be empty
+     */
+    template<std::input_iterator It>
+    It load_sorted_prefix(It first, It last)
+    {
+        assert(empty());
+
+        // nodes are chained by right links until their number is known
+        base_node_ptr head = nullptr;
+        base_node_ptr tail = nullptr;
+        size_type n_nodes = 0;
+
+        try
+        {
+            for (; first != last; ++first, ++n_nodes)
+            {
+                // values are moved out of the range if it is made of move iterators
+                auto &&value = *first;
+
+                if (tail && !comp_(key_of(tail), node_type::key_of_value(value)))
+                    break;
+
+                base_node_ptr node = create_node(std::forward<decltype(value)>(value));
+
+                if (tail)
+                    tail->set_right(node);
+                else
+                    head = node;
+
+                tail = node;
+            }
+        }
+        catch (...)
+        {
+            while (head)
+                destroy_node(std::exchange(head, head->get_right_unsafe()));
+            throw;
+        }
+
+        link_list(head, n_nodes);
+
+        return first;
+    }
+
+    // makes this empty tree a perfectly balanced one of n_nodes nodes of list in ascending order
+    void link_list(base_node_ptr list, size_type n_nodes) noexcept
+    {
+        assert(get_root() == nullptr);
+
+        if (!list)
+            return;
+
+        base_node_ptr prev = &end_;
+        base_node_ptr leftmost = list;
+        base_node_ptr root = link_balanced(n_nodes, list, prev);
+
+        set_root(root);
+        if constexpr (has_parent_links)
+            root->set_parent(&end_);
+
+        set_leftmost(leftmost);
+        set_rightmost(prev);
+        size_ = n_nodes;
+    }
+
+    /*
+     * Makes a perfectly balanced subtree of n nodes taken from the front of list. prev is the
+     * in-order predecessor of the first of them; on return it is the last of them
+     */
+    base_node_ptr link_balanced(size_type n, base_node_ptr &list, base_node_ptr &prev) noexcept
+    {
+        if (n == 0)
+            return nullptr;
+
+        const auto n_left = n / 2;
+        base_node_ptr left = link_balanced(n_left, list, prev);
+
+        base_node_ptr root = std::exchange(list, list->get_right_unsafe());
+
+        if (left)
+        {
+            root->set_left(left);
+            if constexpr (has_parent_links)
+                left->set_parent(root);
+        }
+        else
+            root->set_left_thread(prev);
+
+        prev = root;
+
+        if (base_node_ptr right = link_balanced(n - n_left - 1, list, prev))
+        {
+            root->set_right(right);
+            if constexpr (has_parent_links)
+                right->set_parent(root);
+        }
+        else
+            root->set_right_thread(list ? list : &end_);
+
+        update_node(root);
+
+        return root;
+    }
+
+    void dump_subtree(std::ostream &os, const_node_ptr node) const
+    {
+        dot_dump(os, *node);
+
+        if (auto left = node->get_left())
+            dump_subtree(os, static_cast<const_node_ptr>(left));
+
+        if (auto right = node->get_right())
+            dump_subtree(os, static_cast<const_node_ptr>(right));
+    }
+
+    static void arrow_dump(std::ostream &os, const_base_node_ptr node)
+    {
+        assert(node);
+
+        auto self = fmt::ptr(node);
+
+        if (node->has_left_thread())
+            fmt::print(os, "    node_{}:w -> node_{} [style = dotted, color = \"blue\"];\n",
+                       self, fmt::ptr(node->get_left_unsafe()));
+        else
+            fmt::print(os, "    node_{} -> node_{} [color = \"blue\"];\n",
+                       self, fmt::ptr(node->get_left_unsafe()));
+
+        if (node->has_right_thread())
+            fmt::print(os, "    node_{}:e -> node_{} [style = dotted, color = \"red\"];\n",
+                       self, fmt::ptr(node->get_right_unsafe()));
+        else
+            fmt::print(os, "    node_{} -> node_{} [color = \"red\"];\n",
+                       self, fmt::ptr(node->get_right_unsafe()));
+    }
+
+    using tree_base::end_;
+    using tree_base::rightmost_;
+    using tree_base::alloc_;
+
+    mutable size_type size_ = 0; // unknown_size if the size is to be counted
+    [[no_unique_address]] key_compare comp_;
+};
+
+template<typename Node_T, typename Compare, typename Allocator>
+bool operator==(const Threaded_Tree<Node_T, Compare, Allocator> &lhs,
+                const Threaded_Tree<Node_T, Compare, Allocator> &rhs)
+{
+    return (lhs.size() == rhs.size()) &&
+           (std::equal(lhs.begin(), lhs.end(), rhs.begin()));
+}
+
+template<typename Node_T, typename Compare, typename Allocator>
+auto operator<=>(const Threaded_Tree<Node_T, Compare, Allocator> &lhs,
+                 const Threaded_Tree<Node_T, Compare, Allocator> &rhs)
+-> decltype(std::compare_three_way{}(*lhs.begin(), *rhs.begin()))
+{
+    return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+} // namespace yLab
+
+#endif // INCLUDE_TREES_THREADED_TREE_HPP
@@ -0,0 +1,266 @@
+#ifndef INCLUDE_TREES_THREADED_TREE_BASE_HPP
+#define INCLUDE_TREES_THREADED_TREE_BASE_HPP
+
+#include <utility>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <memory>
+
+#include "nodes/node_base.hpp"
+#include "nodes/node_concepts.hpp"
+#include "allocators/allocator_concepts.hpp"
+
+namespace yLab
+{
+
+/*
+ * The part of threaded trees that does not depend on what orders their nodes: the end node, the
+ * allocator and the lifetime of nodes. Both search trees and implicit sequences derive from it.
+ * Node_T::base_node_type is either Node_Base or Parentless_Node_Base; links to parents are
+ * maintained only in the former
+ */
+template<typename Node_T, typename Allocator>
+class Threaded_Tree_Base
+{
+protected:
+
+    using base_node_type = typename Node_T::base_node_type;
+    using base_node_ptr = base_node_type *;
+    using const_base_node_ptr = const base_node_type *;
+    using node_ptr = Node_T *;
+    using const_node_ptr = const Node_T *;
+    using node_type = Node_T;
+    using node_allocator_type =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<node_type>;
+    using node_alloc_traits = std::allocator_traits<node_allocator_type>;
+
+    static constexpr bool has_parent_links = std::derived_from<base_node_type, Node_Base>;
+
+public:
+
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+    Threaded_Tree_Base(const Threaded_Tree_Base &rhs) = delete;
+    Threaded_Tree_Base &operator=(const Threaded_Tree_Base &rhs) = delete;
+    Threaded_Tree_Base &operator=(Threaded_Tree_Base &&rhs) = delete;
+
+    allocator_type get_allocator() const { return allocator_type(alloc_); }
+
+    bool empty() const noexcept { return get_root() == nullptr; }
+
+protected:
+
+    explicit Threaded_Tree_Base(const allocator_type &alloc) : alloc_(alloc) {}
+
+    Threaded_Tree_Base(Threaded_Tree_Base &&rhs)
+        noexcept (std::is_nothrow_move_constructible_v<node_allocator_type>)
+        : alloc_(std::move(rhs.alloc_))
+    {
+        if (rhs.get_root())
+            take_ownership_of_tree_of(rhs);
+    }
+
+    ~Threaded_Tree_Base() { clean_up(); }
+
+    // swaps the nodes and the allocators of the trees
+    void swap(Threaded_Tree_Base &rhs)
+        noexcept (std::is_nothrow_swappable_v<node_allocator_type>)
+    {
+        if (get_root())
+        {
+            if (rhs.get_root())
+            {
+                adjust_tree_to_end_node_of(rhs);
+                rhs.adjust_tree_to_end_node_of(*this);
+                std::swap(end_, rhs.end_);
+                std::swap(rightmost_, rhs.rightmost_);
+            }
+            else
+                rhs.take_ownership_of_tree_of(*this);
+        }
+        else if (rhs.get_root())
+            take_ownership_of_tree_of(rhs);
+
+        if constexpr (node_alloc_traits::propagate_on_container_swap::value)
+            std::swap(alloc_, rhs.alloc_);
+        else
+            assert(alloc_ == rhs.alloc_);
+    }
+
+    // end-node routines
+
+    base_node_ptr get_root() noexcept { return end_.get_left(); }
+    const_base_node_ptr get_root() const noexcept { return end_.get_left(); }
+    void set_root(base_node_ptr root) noexcept { end_.set_left(root); }
+
+    base_node_ptr get_leftmost() noexcept { return end_.get_right(); }
+    const_base_node_ptr get_leftmost() const noexcept { return end_.get_right(); }
+    void set_leftmost(base_node_ptr leftmost) noexcept { end_.set_right(leftmost); }
+
+    base_node_ptr get_rightmost() noexcept { return rightmost_; }
+    const_base_node_ptr get_rightmost() const noexcept { return rightmost_; }
+    void set_rightmost(base_node_ptr rightmost) noexcept { rightmost_ = rightmost; }
+
+    template<typename... Args>
+    node_ptr create_node(Args &&... args)
+    {
+        node_ptr node = node_alloc_traits::allocate(alloc_, 1);
+
+        try
+        {
+            node_alloc_traits::construct(alloc_, node, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            node_alloc_traits::deallocate(alloc_, node, 1);
+            throw;
+        }
+
+        return node;
+    }
+
+    void destroy_node(base_node_ptr node) noexcept
+    {
+        assert(node);
+
+        auto victim = static_cast<node_ptr>(node);
+        node_alloc_traits::destroy(alloc_, victim);
+        node_alloc_traits::deallocate(alloc_, victim, 1);
+    }
+
+    // makes nodes allocated by rhs deallocatable by this tree, e.g. before stealing them
+    void adopt_allocator_of(Threaded_Tree_Base &rhs) { adopt_allocator(rhs.alloc_); }
+
+    void adopt_allocator(const node_allocator_type &alloc)
+    {
+        if constexpr (!node_alloc_traits::is_always_equal::value)
+        {
+            if constexpr (adoptable_allocator<node_allocator_type>)
+            {
+                if (alloc_ != alloc)
+                    alloc_.adopt(alloc);
+            }
+            else
+                assert(alloc_ == alloc);
+        }
+    }
+
+    // links and thread flags tell children from threads regardless of pending updates of nodes
+    void clean_up() noexcept
+    {
+        // trivially destructible nodes need no destruction: drop all memory at once
+        if constexpr (releasable_allocator<node_allocator_type> &&
+                      std::is_trivially_destructible_v<node_type>)
+        {
+            if (get_root() && alloc_.release())
+                return;
+        }
+
+        for (base_node_ptr node = get_root(), save; node != nullptr; node = save)
+        {
+            if (base_node_ptr left = node->get_left())
+            {
+                save = left;
+                node->set_left(save->get_right());
+                save->set_right(node);
+            }
+            else
+            {
+                save = node->get_right();
+                destroy_node(node);
+            }
+        }
+    }
+
+    void reset() noexcept
+    {
+        set_root(nullptr);
+        set_leftmost(&end_);
+        set_rightmost(&end_);
+    }
+
+    void take_ownership_of_tree_of(Threaded_Tree_Base &rhs) noexcept
+    {
+        assert(get_root() == nullptr);
+
+        rhs.adjust_tree_to_end_node_of(*this);
+
+        set_root(rhs.get_root());
+        set_leftmost(rhs.get_leftmost());
+        set_rightmost(rhs.get_rightmost());
+        rhs.reset();
+    }
+
+    void adjust_tree_to_end_node_of(Threaded_Tree_Base &rhs) noexcept
+    {
+        assert(get_root());
+
+        base_node_ptr right_end = &rhs.end_;
+
+        if constexpr (has_parent_links)
+            get_root()->set_parent(right_end);
+
+        adjust_tree_to_end_nodes(right_end, right_end);
+    }
+
+    /*
+     * Redirects the threads leading out of the tree to before and after. Pending reversals may
+     * have swapped the links of the leftmost and the rightmost nodes, so then the threads are told
+     * by their targets, which shall be the end node of this tree. Only the root may have both of
+     * them, and the links of the root are never pending. Other trees may call it while the threads
+     * still lead to the end node of another tree, e.g. one that they were split off
+     */
+    void adjust_tree_to_end_nodes(base_node_ptr before, base_node_ptr after) noexcept
+    {
+        base_node_ptr leftmost = get_leftmost();
+        base_node_ptr rightmost = get_rightmost();
+
+        if constexpr (contains_pending_reversals<node_type>)
+        {
+            if (leftmost != rightmost)
+            {
+                redirect_thread(leftmost, &end_, before);
+                redirect_thread(rightmost, &end_, after);
+
+                return;
+            }
+        }
+
+        leftmost->set_left_thread(before);
+        rightmost->set_right_thread(after);
+    }
+
+    static void redirect_thread(base_node_ptr node, const_base_node_ptr from,
+                                base_node_ptr to) noexcept
+    {
+        if (node->has_left_thread() && node->get_left_unsafe() == from)
+            node->set_left_thread(to);
+        else
+        {
+            assert(node->has_right_thread() && node->get_right_unsafe() == from);
+            node->set_right_thread(to);
+        }
+    }
+
+    // setters of nodes do not maintain subtree sizes: they are recomputed explicitly
+
+    // recomputes augmented data of a node after a change of its children
+    static void update_node(base_node_ptr node) noexcept
+    {
+        if constexpr (maintains_subtree_data<node_type>)
+            static_cast<node_ptr>(node)->update();
+    }
+
+    // left child of end_ is the root of the tree
+    // right child of end_ is the leftmost element of the tree
+    base_node_type end_{nullptr, &end_};
+    base_node_ptr rightmost_ = &end_;
+    [[no_unique_address]] node_allocator_type alloc_;
+};
+
+} // namespace yLab
+
+#endif // INCLUDE_TREES_THREADED_TREE_BASE_HPP
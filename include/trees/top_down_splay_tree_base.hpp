@@ -0,0 +1,739 @@
+#ifndef INCLUDE_TREES_TOP_DOWN_SPLAY_TREE_BASE_HPP
+#define INCLUDE_TREES_TOP_DOWN_SPLAY_TREE_BASE_HPP
+
+#include <utility>
+#include <cassert>
+#include <functional>
+#include <concepts>
+#include <iterator>
+#include <initializer_list>
+#include <memory>
+
+#include "nodes/parentless_node_base.hpp"
+#include "nodes/node_concepts.hpp"
+#include "trees/threaded_tree.hpp"
+
+namespace yLab
+{
+
+/*
+ * Threaded splay tree that is restructured top-down (D. D. Sleator, R. E. Tarjan, "Self-Adjusting
+ * Binary Search Trees", 1985): the search and the splaying of the access path are done in one
+ * pass, so nodes need no pointers to their parents.
+ *
+ * While descending, the tree is split into three: the left tree of nodes less than the key,
+ * the middle tree rooted at the current node and the right tree of nodes greater than the key.
+ * Augmented data of the left and the right trees is fixed by one more pass along their spines
+ * when the three trees are assembled
+ */
+template<typename Node_T, typename Compare = std::less<typename Node_T::key_type>,
+         typename Allocator = std::allocator<typename Node_T::key_type>>
+requires std::derived_from<Node_T, Parentless_Node_Base> && (!contains_lazy_tags<Node_T>)
+class Top_Down_Splay_Tree_Base final : public Threaded_Tree<Node_T, Compare, Allocator>
+{
+    using tree_base = Threaded_Tree<Node_T, Compare, Allocator>;
+
+    using typename tree_base::base_node_type;
+    using typename tree_base::base_node_ptr;
+    using typename tree_base::const_base_node_ptr;
+    using typename tree_base::node_ptr;
+    using typename tree_base::const_node_ptr;
+    using typename tree_base::node_alloc_traits;
+
+    using tree_base::base_ptr;
+    using tree_base::key_of;
+    using tree_base::get_root;
+    using tree_base::set_root;
+    using tree_base::get_leftmost;
+    using tree_base::set_leftmost;
+    using tree_base::get_rightmost;
+    using tree_base::set_rightmost;
+    using tree_base::create_node;
+    using tree_base::destroy_node;
+    using tree_base::adopt_allocator_of;
+    using tree_base::reset;
+    using tree_base::update_node;
+    using tree_base::load_sorted_prefix;
+    using tree_base::end_;
+    using tree_base::size_;
+    using tree_base::comp_;
+
+public:
+
+    using typename tree_base::node_type;
+    using typename tree_base::key_type;
+    using typename tree_base::key_compare;
+    using typename tree_base::value_type;
+    using typename tree_base::size_type;
+    using typename tree_base::iterator;
+    using typename tree_base::const_iterator;
+    using typename tree_base::allocator_type;
+
+    using tree_base::begin;
+    using tree_base::end;
+    using tree_base::empty;
+    using tree_base::swap;
+    using tree_base::clear;
+    using tree_base::get_allocator;
+
+    Top_Down_Splay_Tree_Base() : Top_Down_Splay_Tree_Base(key_compare()) {}
+
+    explicit Top_Down_Splay_Tree_Base(const key_compare &comp,
+                                      const allocator_type &alloc = allocator_type())
+        : tree_base(comp, alloc) {}
+
+    explicit Top_Down_Splay_Tree_Base(const allocator_type &alloc)
+        : Top_Down_Splay_Tree_Base(key_compare(), alloc) {}
+
+    template<std::input_iterator It>
+    Top_Down_Splay_Tree_Base(It first, It last, const key_compare &comp = key_compare(),
+                             const allocator_type &alloc = allocator_type())
+        : Top_Down_Splay_Tree_Base(comp, alloc)
+    {
+        insert(first, last);
+    }
+
+    Top_Down_Splay_Tree_Base(std::initializer_list<value_type> ilist,
+                             const key_compare &comp = key_compare(),
+                             const allocator_type &alloc = allocator_type())
+        : Top_Down_Splay_Tree_Base(ilist.begin(), ilist.end(), comp, alloc) {}
+
+    Top_Down_Splay_Tree_Base(const Top_Down_Splay_Tree_Base &rhs)
+        : Top_Down_Splay_Tree_Base(rhs.begin(), rhs.end(), rhs.comp_,
+                                   node_alloc_traits::select_on_container_copy_construction(
+                                       rhs.alloc_)) {}
+
+    Top_Down_Splay_Tree_Base &operator=(const Top_Down_Splay_Tree_Base &rhs)
+    {
+        auto tmp_tree{rhs};
+        swap(tmp_tree);
+
+        return *this;
+    }
+
+    Top_Down_Splay_Tree_Base(Top_Down_Splay_Tree_Base &&rhs) = default;
+
+    Top_Down_Splay_Tree_Base &operator=(Top_Down_Splay_Tree_Base &&rhs)
+        noexcept (noexcept(swap(rhs)))
+    {
+        swap(rhs);
+        return *this;
+    }
+
+    // lookup
+
+    const_iterator find(const key_type &key) const { return do_find(key); }
+
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    const_iterator find(const K &key) const { return do_find(key); }
+
+    bool contains(const key_type &key) const { return find(key) != end(); }
+
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    bool contains(const K &key) const { return find(key) != end(); }
+
+    // Finds first element that is not less than key
+    const_iterator lower_bound(const key_type &key) const { return do_lower_bound(key); }
+
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    const_iterator lower_bound(const K &key) const { return do_lower_bound(key); }
+
+    // Finds first element that is greater than key
+    const_iterator upper_bound(const key_type &key) const { return do_upper_bound(key); }
+
+    template<typename K>
+    requires transparent_comparator<key_compare>
+    const_iterator upper_bound(const K &key) const { return do_upper_bound(key); }
+
+    size_type n_less_than(const key_type &key) const
+    requires contains_subtree_size<node_type>
+    {
+        return do_n_less_than(key);
+    }
+
+    template<typename K>
+    requires contains_subtree_size<node_type> && transparent_comparator<key_compare>
+    size_type n_less_than(const K &key) const { return do_n_less_than(key); }
+
+    // Modifiers
+
+    std::pair<iterator, bool> insert(const key_type &key)
+    {
+        if (empty())
+        {
+            base_node_ptr node = create_node(key);
+            node->set_left_thread(&end_);
+            node->set_right_thread(&end_);
+
+            set_root(node);
+            set_leftmost(node);
+            set_rightmost(node);
+            size_ = 1;
+
+            return std::pair{iterator{node}, true};
+        }
+
+        auto [root, left_max, right_min] = splay_root(by_key(key));
+
+        if (equal_to(root, key))
+            return std::pair{iterator{root}, false};
+
+        base_node_ptr node = create_node(key);
+
+        if (comp_(key, key_of(root)))
+        {
+            // key is between left_max and root: node takes the left subtree of root
+            node->copy_left_link(*root);
+            node->set_right(root);
+            root->set_left_thread(node);
+
+            if (left_max)
+                left_max->set_right_thread(node);
+            else
+                set_leftmost(node);
+        }
+        else
+        {
+            // key is between root and right_min: node takes the right subtree of root
+            node->copy_right_link(*root);
+            node->set_left(root);
+            root->set_right_thread(node);
+
+            if (right_min)
+                right_min->set_left_thread(node);
+            else
+                set_rightmost(node);
+        }
+
+        update_node(root);
+        update_node(node);
+
+        set_root(node);
+        size_++;
+
+        return std::pair{iterator{node}, true};
+    }
+
+    template<std::input_iterator It>
+    void insert(It first, It last)
+    {
+        if (empty())
+            first = load_sorted_prefix(std::move(first), last);
+
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    // replaces the content of the tree with keys from [first, last) in O(n) if they are sorted
+    template<std::input_iterator It>
+    void assign_sorted(It first, It last)
+    {
+        clear();
+        insert(std::move(first), last);
+    }
+
+    void insert(std::initializer_list<value_type> ilist) { insert(ilist.begin(), ilist.end()); }
+
+    iterator erase(iterator pos)
+    {
+        base_node_ptr node = base_ptr(pos);
+        auto res = std::next(pos);
+
+        [[maybe_unused]] auto root = splay_root(by_key(key_of(node))).root;
+        assert(root == node);
+
+        unlink_root();
+        size_--;
+
+        destroy_node(node);
+
+        return res;
+    }
+
+    size_type erase(const key_type &key) { return erase_key_at(find(key)); }
+
+    template<typename K>
+    requires transparent_comparator<key_compare> && (!std::convertible_to<K, iterator>)
+    size_type erase(const K &key) { return erase_key_at(find(key)); }
+
+    bool join(Top_Down_Splay_Tree_Base &&rhs)
+    {
+        if (empty())
+            swap(rhs); // leads to change of the comparator if one of rhs differs from ours
+        else if (!rhs.empty())
+        {
+            base_node_ptr rhs_leftmost = rhs.get_leftmost();
+
+            if (!comp_(key_of(get_rightmost()), key_of(rhs_leftmost)))
+                return false;
+
+            adopt_allocator_of(rhs);
+
+            base_node_ptr root = splay_root(to_maximum).root;
+            assert(root == get_rightmost());
+
+            root->set_right(rhs.get_root());
+            update_node(root);
+
+            rhs_leftmost->set_left_thread(root);
+            rhs.get_rightmost()->set_right_thread(&end_);
+            set_rightmost(rhs.get_rightmost());
+
+            rhs.reset();
+
+            size_ += std::exchange(rhs.size_, 0);
+        }
+
+        return true;
+    }
+
+    /*
+     * Leaves keys not greater than key in this tree and returns the rest. Returns an empty tree
+     * if key is not in the tree
+     */
+    Top_Down_Splay_Tree_Base split(const key_type &key)
+    requires contains_subtree_size<node_type>
+    {
+        if (!contains(key))
+            return {};
+
+        return cut(key, Split_Bound::upper);
+    }
+
+    template<typename K>
+    requires contains_subtree_size<node_type> && transparent_comparator<key_compare>
+    Top_Down_Splay_Tree_Base split(const K &key)
+    {
+        if (!contains(key))
+            return {};
+
+        return cut(key, Split_Bound::upper);
+    }
+
+    /*
+     * Splits the tree into keys less than key and the rest (Split_Bound::lower) or into keys not
+     * greater than key and the rest (Split_Bound::upper); key need not be in the tree. The tree is
+     * left empty. Takes O(log n) amortized
+     */
+    std::pair<Top_Down_Splay_Tree_Base, Top_Down_Splay_Tree_Base>
+    split(const key_type &key, Split_Bound bound) &&
+    requires contains_subtree_size<node_type>
+    {
+        auto right_tree = cut(key, bound);
+        return std::pair{std::move(*this), std::move(right_tree)};
+    }
+
+    template<typename K>
+    requires contains_subtree_size<node_type> && transparent_comparator<key_compare>
+    std::pair<Top_Down_Splay_Tree_Base, Top_Down_Splay_Tree_Base>
+    split(const K &key, Split_Bound bound) &&
+    {
+        auto right_tree = cut(key, bound);
+        return std::pair{std::move(*this), std::move(right_tree)};
+    }
+
+private:
+
+    enum class Way { left, right, stop };
+
+    struct Splay_Result
+    {
+        base_node_ptr root;
+        base_node_ptr left_max;  // the greatest node of the left tree; nullptr if it is empty
+        base_node_ptr right_min; // the least node of the right tree; nullptr if it is empty
+    };
+
+    template<typename K>
+    bool equal_to(const_base_node_ptr node, const K &key) const
+    {
+        return !comp_(key, key_of(node)) && !comp_(key_of(node), key);
+    }
+
+    template<typename K>
+    auto by_key(const K &key) const
+    {
+        return [this, &key](const_base_node_ptr node)
+        {
+            if (comp_(key, key_of(node)))
+                return Way::left;
+            else if (comp_(key_of(node), key))
+                return Way::right;
+            else
+                return Way::stop;
+        };
+    }
+
+    // lookups shared by the overloads for key_type and for keys of a transparent comparator
+
+    template<typename K>
+    const_iterator do_find(const K &key) const
+    {
+        if (empty())
+            return end();
+
+        const_base_node_ptr root = splay_root(by_key(key)).root;
+        return equal_to(root, key) ? const_iterator{root} : end();
+    }
+
+    template<typename K>
+    const_iterator do_lower_bound(const K &key) const
+    {
+        if (empty())
+            return end();
+
+        const_base_node_ptr root = splay_root(by_key(key)).root;
+        return const_iterator{comp_(key_of(root), key) ? root->successor() : root};
+    }
+
+    template<typename K>
+    const_iterator do_upper_bound(const K &key) const
+    {
+        if (empty())
+            return end();
+
+        const_base_node_ptr root = splay_root(by_key(key)).root;
+        return const_iterator{comp_(key, key_of(root)) ? root : root->successor()};
+    }
+
+    template<typename K>
+    size_type do_n_less_than(const K &key) const
+    {
+        if (empty())
+            return 0;
+
+        const_base_node_ptr root = splay_root(by_key(key)).root;
+        return node_type::size(static_cast<const_node_ptr>(root->get_left())) +
+               comp_(key_of(root), key);
+    }
+
+    size_type erase_key_at(const_iterator pos)
+    {
+        if (pos == end())
+            return 0;
+
+        erase(pos);
+        return 1;
+    }
+
+    static Way to_minimum(const_base_node_ptr) noexcept { return Way::left; }
+    static Way to_maximum(const_base_node_ptr) noexcept { return Way::right; }
+
+    /*
+     * Moves keys greater than key (Split_Bound::upper) or not less than key (Split_Bound::lower)
+     * to the returned tree. After key is splayed, the root and one of its subtrees stay here
+     */
+    template<typename K>
+    Top_Down_Splay_Tree_Base cut(const K &key, Split_Bound bound)
+    requires contains_subtree_size<node_type>
+    {
+        // both trees share the allocator as nodes of one of them may be freed by the other
+        Top_Down_Splay_Tree_Base right_tree{comp_, get_allocator()};
+
+        if (empty())
+            return right_tree;
+
+        base_node_ptr root = splay_root(by_key(key)).root;
+        const bool root_goes_left = (bound == Split_Bound::upper) ? !comp_(key, key_of(root))
+                                                                  : comp_(key_of(root), key);
+        if (root_goes_left)
+        {
+            base_node_ptr right_root = root->get_right();
+            if (!right_root)
+                return right_tree;
+
+            base_node_ptr right_leftmost = root->successor();
+            root->set_right_thread(&end_);
+            update_node(root);
+
+            right_tree.set_root(right_root);
+            right_tree.set_leftmost(right_leftmost);
+            right_tree.set_rightmost(get_rightmost());
+            set_rightmost(root);
+        }
+        else
+        {
+            base_node_ptr left_root = root->get_left();
+            if (!left_root)
+            {
+                swap(right_tree);
+                return right_tree;
+            }
+
+            base_node_ptr left_rightmost = root->predecessor();
+            left_rightmost->set_right_thread(&end_);
+            root->set_left(nullptr);
+            update_node(root);
+
+            right_tree.set_root(root);
+            right_tree.set_leftmost(root);
+            right_tree.set_rightmost(get_rightmost());
+            set_root(left_root);
+            set_rightmost(left_rightmost);
+        }
+
+        right_tree.get_leftmost()->set_left_thread(&right_tree.end_);
+        right_tree.get_rightmost()->set_right_thread(&right_tree.end_);
+
+        const auto right_size = node_type::size(static_cast<node_ptr>(right_tree.get_root()));
+        right_tree.size_ = right_size;
+        size_ -= right_size;
+
+        return right_tree;
+    }
+
+    // Splaying
+
+    template<typename Choose_Way>
+    Splay_Result splay_root(Choose_Way choose_way) const
+    {
+        auto &end_node = const_cast<base_node_type &>(end_);
+        auto result = splay(end_node.get_left(), choose_way);
+        end_node.set_left(result.root);
+
+        return result;
+    }
+
+    /*
+     * Splays the subtree rooted at t: choose_way(node) tells where the desired node is relative to
+     * node. The last node on the way becomes the root of the subtree. Threads to nodes outside of
+     * the subtree are preserved
+     */
+    template<typename Choose_Way>
+    static Splay_Result splay(base_node_ptr t, Choose_Way choose_way)
+    {
+        assert(t);
+
+        base_node_type header; // the left tree hangs on its right, the right tree on its left
+        base_node_ptr l = &header;
+        base_node_ptr r = &header;
+
+        for (;;)
+        {
+            if (auto way = choose_way(t); way == Way::left)
+            {
+                if (t->has_left_thread())
+                    break;
+
+                if (choose_way(t->get_left_unsafe()) == Way::left)
+                {
+                    t = rotate_right(t);
+                    if (t->has_left_thread())
+                        break;
+                }
+
+                link_right(r, t);
+            }
+            else if (way == Way::right)
+            {
+                if (t->has_right_thread())
+                    break;
+
+                if (choose_way(t->get_right_unsafe()) == Way::right)
+                {
+                    t = rotate_left(t);
+                    if (t->has_right_thread())
+                        break;
+                }
+
+                link_left(l, t);
+            }
+            else
+                break;
+        }
+
+        assemble(header, l, t, r);
+
+        return Splay_Result{t, (l == &header) ? nullptr : l, (r == &header) ? nullptr : r};
+    }
+
+    /*
+     * Rotations keep augmented data of both nodes valid as their subtrees are complete
+     *
+     *       |           |
+     *       t           y
+     *      / \         / \
+     *     y   c  -->  a   t
+     *    / \             / \
+     *   a   b           b   c
+     */
+    static base_node_ptr rotate_right(base_node_ptr t) noexcept
+    {
+        base_node_ptr y = t->get_left_unsafe();
+
+        if (y->has_right_thread()) // y is the predecessor of t
+            t->set_left_thread(y);
+        else
+            t->set_left(y->get_right_unsafe());
+
+        y->set_right(t);
+
+        update_node(t);
+        update_node(y);
+
+        return y;
+    }
+
+    static base_node_ptr rotate_left(base_node_ptr t) noexcept
+    {
+        base_node_ptr y = t->get_right_unsafe();
+
+        if (y->has_left_thread()) // y is the successor of t
+            t->set_right_thread(y);
+        else
+            t->set_right(y->get_left_unsafe());
+
+        y->set_left(t);
+
+        update_node(t);
+        update_node(y);
+
+        return y;
+    }
+
+    /*
+     * link_right moves t with its right subtree to the right tree as its new least node r and
+     * descends to the left child of t; link_left is symmetric.
+     *
+     * Nodes without augmented data are linked to the spine of the side tree at once. Otherwise,
+     * the node keeps a link to the previous node of the spine instead, so that assemble() could
+     * fix the spine bottom-up and reverse the links in the same pass
+     */
+    static void link_right(base_node_ptr &r, base_node_ptr &t) noexcept
+    {
+        base_node_ptr left = t->get_left_unsafe();
+
+        if constexpr (maintains_subtree_data<node_type>)
+            t->set_left(r);
+        else
+            r->set_left(t);
+
+        r = std::exchange(t, left);
+    }
+
+    static void link_left(base_node_ptr &l, base_node_ptr &t) noexcept
+    {
+        base_node_ptr right = t->get_right_unsafe();
+
+        if constexpr (maintains_subtree_data<node_type>)
+            t->set_right(l);
+        else
+            l->set_right(t);
+
+        l = std::exchange(t, right);
+    }
+
+    /*
+     * Makes the left tree the left subtree of t and the right tree the right subtree of t.
+     * The former subtrees of t become the rightmost subtree of the left tree and the leftmost
+     * subtree of the right tree respectively. If t has no left child, it is the successor of l;
+     * if it has no right child, it is the predecessor of r
+     */
+    static void assemble(base_node_type &header, base_node_ptr l, base_node_ptr t,
+                         base_node_ptr r) noexcept
+    {
+        const base_node_ptr header_ptr = &header;
+
+        if (l != header_ptr)
+        {
+            base_node_ptr up = l->get_right_unsafe();
+
+            if (t->has_left_thread())
+                l->set_right_thread(t);
+            else
+                l->set_right(t->get_left_unsafe());
+
+            base_node_ptr left_root = header.get_right_unsafe();
+
+            if constexpr (maintains_subtree_data<node_type>)
+            {
+                update_node(l);
+
+                for (left_root = l; up != header_ptr; )
+                {
+                    base_node_ptr next = up->get_right_unsafe();
+                    up->set_right(left_root);
+                    update_node(up);
+                    left_root = std::exchange(up, next);
+                }
+            }
+
+            t->set_left(left_root);
+        }
+
+        if (r != header_ptr)
+        {
+            base_node_ptr up = r->get_left_unsafe();
+
+            if (t->has_right_thread())
+                r->set_left_thread(t);
+            else
+                r->set_left(t->get_right_unsafe());
+
+            base_node_ptr right_root = header.get_left_unsafe();
+
+            if constexpr (maintains_subtree_data<node_type>)
+            {
+                update_node(r);
+
+                for (right_root = r; up != header_ptr; )
+                {
+                    base_node_ptr next = up->get_left_unsafe();
+                    up->set_left(right_root);
+                    update_node(up);
+                    right_root = std::exchange(up, next);
+                }
+            }
+
+            t->set_right(right_root);
+        }
+
+        update_node(t);
+    }
+
+    // removes the root from the tree without destroying it
+    void unlink_root() noexcept
+    {
+        base_node_ptr root = get_root();
+        base_node_ptr left = root->get_left();
+        base_node_ptr right = root->get_right();
+
+        if (left)
+        {
+            // the predecessor of root becomes the root
+            left = splay(left, to_maximum).root;
+
+            if (right)
+            {
+                right = splay(right, to_minimum).root;
+                right->set_left_thread(left);
+                left->set_right(right);
+            }
+            else
+            {
+                left->copy_right_link(*root);
+                set_rightmost(left);
+            }
+
+            update_node(left);
+            set_root(left);
+        }
+        else if (right)
+        {
+            // root is the leftmost node
+            right = splay(right, to_minimum).root;
+            right->copy_left_link(*root);
+
+            set_leftmost(right);
+            set_root(right);
+        }
+        else
+            reset();
+    }
+};
+
+} // namespace yLab
+
+#endif // INCLUDE_TREES_TOP_DOWN_SPLAY_TREE_BASE_HPP
@@ -2,27 +2,80 @@
 #define INCLUDE_TREES_TREES_HPP
 
 #include <functional>
+#include <memory>
+#include <utility>
 
 #include "nodes/node.hpp"
 #include "nodes/augmented_node.hpp"
+#include "nodes/monoid_node.hpp"
+#include "nodes/lazy_node.hpp"
+#include "nodes/map_node.hpp"
+#include "nodes/counted_node.hpp"
+#include "nodes/parentless_node_base.hpp"
 
 #include "trees/search_tree.hpp"
 #include "trees/splay_tree_base.hpp"
+#include "trees/splay_strategies.hpp"
+#include "trees/top_down_splay_tree_base.hpp"
+#include "trees/sharded_splay_tree.hpp"
+#include "trees/implicit_splay_sequence.hpp"
 
 namespace yLab
 {
 
-template<typename Key_T, typename Compare = std::less<Key_T>>
-using BST = Search_Tree<Node<Key_T>, Compare>;
+template<typename Key_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>>
+using BST = Search_Tree<Node<Key_T>, Compare, Allocator>;
 
-template<typename Key_T, typename Compare = std::less<Key_T>>
-using Augmented_BST = Search_Tree<Augmented_Node<Key_T>, Compare>;
+template<typename Key_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>>
+using Augmented_BST = Search_Tree<Augmented_Node<Key_T>, Compare, Allocator>;
 
-template<typename Key_T, typename Compare = std::less<Key_T>>
-using Splay_Tree = Splay_Tree_Base<Node<Key_T>, Compare>;
+template<typename Key_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>, typename Splay_Strategy = Full_Splay>
+using Splay_Tree = Splay_Tree_Base<Node<Key_T>, Compare, Allocator, Splay_Strategy>;
 
-template<typename Key_T, typename Compare = std::less<Key_T>>
-using Augmented_Splay_Tree = Splay_Tree_Base<Augmented_Node<Key_T>, Compare>;
+template<typename Key_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>, typename Splay_Strategy = Full_Splay>
+using Augmented_Splay_Tree =
+    Splay_Tree_Base<Augmented_Node<Key_T>, Compare, Allocator, Splay_Strategy>;
+
+template<typename Key_T, typename Monoid, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>, typename Splay_Strategy = Full_Splay>
+using Monoid_Splay_Tree =
+    Splay_Tree_Base<Monoid_Node<Key_T, Monoid>, Compare, Allocator, Splay_Strategy>;
+
+// lookups in trees with lazy updates always splay fully, so there is no choice of a strategy
+template<typename Key_T, typename Monoid, typename Action, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>>
+using Lazy_Splay_Tree =
+    Splay_Tree_Base<Lazy_Node<Key_T, Monoid, Action>, Compare, Allocator>;
+
+// repeated keys are stored once with their counts; order statistics count occurrences
+template<typename Key_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>, typename Splay_Strategy = Full_Splay>
+using Splay_Multiset = Splay_Tree_Base<Counted_Node<Key_T>, Compare, Allocator, Splay_Strategy>;
+
+template<typename Key_T, typename Mapped_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<std::pair<const Key_T, Mapped_T>>,
+         typename Splay_Strategy = Full_Splay>
+using Splay_Map = Splay_Tree_Base<Map_Node<Key_T, Mapped_T>, Compare, Allocator, Splay_Strategy>;
+
+template<typename Key_T, typename Mapped_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<std::pair<const Key_T, Mapped_T>>,
+         typename Splay_Strategy = Full_Splay>
+using Augmented_Splay_Map =
+    Splay_Tree_Base<Augmented_Map_Node<Key_T, Mapped_T>, Compare, Allocator, Splay_Strategy>;
+
+template<typename Key_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>>
+using Top_Down_Splay_Tree =
+    Top_Down_Splay_Tree_Base<Node<Key_T, Parentless_Node_Base>, Compare, Allocator>;
+
+template<typename Key_T, typename Compare = std::less<Key_T>,
+         typename Allocator = std::allocator<Key_T>>
+using Augmented_Top_Down_Splay_Tree =
+    Top_Down_Splay_Tree_Base<Augmented_Node<Key_T, Parentless_Node_Base>, Compare, Allocator>;
 
 } // namespace yLab
 
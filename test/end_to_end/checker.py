@@ -13,7 +13,7 @@ def parse_options():
                         "executables produced by the build system", type = str, dest = "dir",
                         metavar = "PATH", required = True)
     parser.add_argument("--tree", help = "the tree to use in tests", required = True,
-                        choices = ["splay", "splay+"])
+                        choices = ["splay", "splay+", "top-down", "top-down+"])
     parser.add_argument("-k", "--keys", help = "the number of random keys in test", type = int,
                         dest = "keys", metavar = "N", required = True)
     parser.add_argument("-q", "--queries", help = "the number of random queries in test", type = int,
@@ -6,6 +6,10 @@
 #include <iterator>
 #include <chrono>
 #include <set>
+#include <string>
+#include <functional>
+#include <memory>
+#include <algorithm>
 
 #include <fmt/format.h>
 #include <fmt/ranges.h>
@@ -42,16 +46,52 @@ std::size_t answer_query(const Tree_T &tree, std::pair<key_type, key_type> range
     if (range.first > range.second)
         return 0;
 
-    if constexpr (yLab::contains_subtree_size<typename Tree_T::node_type>)
+    if constexpr (requires { tree.count_in_range(range.first, range.second); })
+        return tree.count_in_range(range.first, range.second);
+    else if constexpr (yLab::contains_subtree_size<typename Tree_T::node_type>)
         return tree.n_less_than(range.second) - tree.n_less_than(range.first);
     else
         return std::distance(tree.lower_bound(range.first), tree.lower_bound(range.second));
 }
 
 template<typename Tree_T>
-auto run_test()
+void answer_batch(const Tree_T &tree, const std::vector<std::pair<key_type, key_type>> &ranges,
+                  std::vector<std::size_t> &answers)
+{
+    if constexpr (requires { tree.count_ranges_batch(ranges); })
+        std::ranges::copy(tree.count_ranges_batch(ranges), std::back_inserter(answers));
+    else
+    {
+        for (auto range : ranges)
+            answers.push_back(answer_query(tree, range));
+    }
+}
+
+template<typename Tree_T>
+void insert_batch(Tree_T &tree, const std::vector<key_type> &batch)
+{
+    if constexpr (requires { tree.insert_batch(batch); })
+        tree.insert_batch(batch);
+    else
+        tree.insert(batch.begin(), batch.end());
+}
+
+struct Batch_Sizes final
+{
+    std::size_t keys = 1;
+    std::size_t queries = 1;
+};
+
+/*
+ * Keys are inserted in batches of batch_sizes.keys keys; a batch is also flushed before every
+ * query. Queries are answered in batches of batch_sizes.queries queries in the same way
+ */
+template<typename Tree_T>
+auto run_test(Batch_Sizes batch_sizes)
 {
     std::vector<std::size_t> answers;
+    std::vector<key_type> batch;
+    std::vector<std::pair<key_type, key_type>> queries;
     Tree_T tree;
 
     auto start = std::chrono::high_resolution_clock::now();
@@ -66,11 +106,45 @@ auto run_test()
         switch (query)
         {
             case 'k':
-                tree.insert(get_key());
+                if (!queries.empty())
+                {
+                    answer_batch(tree, queries, answers);
+                    queries.clear();
+                }
+
+                if (batch_sizes.keys <= 1)
+                    tree.insert(get_key());
+                else
+                {
+                    batch.push_back(get_key());
+
+                    if (batch.size() == batch_sizes.keys)
+                    {
+                        insert_batch(tree, batch);
+                        batch.clear();
+                    }
+                }
                 break;
 
             case 'q':
-                answers.push_back(answer_query(tree, get_range()));
+                if (!batch.empty())
+                {
+                    insert_batch(tree, batch);
+                    batch.clear();
+                }
+
+                if (batch_sizes.queries <= 1)
+                    answers.push_back(answer_query(tree, get_range()));
+                else
+                {
+                    queries.push_back(get_range());
+
+                    if (queries.size() == batch_sizes.queries)
+                    {
+                        answer_batch(tree, queries, answers);
+                        queries.clear();
+                    }
+                }
                 break;
 
             default:
@@ -78,6 +152,12 @@ auto run_test()
         }
     }
 
+    if (!batch.empty())
+        insert_batch(tree, batch);
+
+    if (!queries.empty())
+        answer_batch(tree, queries, answers);
+
     auto finish = std::chrono::high_resolution_clock::now();
     return std::pair{std::move(answers), finish - start};
 }
@@ -93,19 +173,43 @@ int main(int argc, char **argv) try
 
     std::string tree_type;
     app.add_option("--tree", tree_type, "The type of search tree to run benchmark on")
-        ->check(CLI::IsMember({"std::set", "splay", "splay+"}))
+        ->check(CLI::IsMember({"std::set", "splay", "splay+", "top-down", "top-down+"}))
         ->required();
 
+    std::string strategy = "full";
+    app.add_option("--strategy", strategy, "The way splay and splay+ restructure on lookups")
+        ->check(CLI::IsMember({"full", "semi"}));
+
+    Batch_Sizes batch_sizes;
+    app.add_option("--insert-batch", batch_sizes.keys, "Insert keys in batches of at most N keys")
+        ->check(CLI::PositiveNumber);
+    app.add_option("--batch", batch_sizes.queries,
+                   "Answer range queries in batches of at most N queries")
+        ->check(CLI::PositiveNumber);
+
     CLI11_PARSE(app, argc, argv);
 
+    using compare = std::less<key_type>;
+    using allocator = std::allocator<key_type>;
+
     auto [answers, time] = [&]
     {
         if (tree_type == "std::set")
-            return run_test<std::set<key_type>>();
+            return run_test<std::set<key_type>>(batch_sizes);
         else if (tree_type == "splay")
-            return run_test<yLab::Splay_Tree<key_type>>();
+            return (strategy == "semi")
+                ? run_test<yLab::Splay_Tree<key_type, compare, allocator,
+                                            yLab::Semi_Splay>>(batch_sizes)
+                : run_test<yLab::Splay_Tree<key_type>>(batch_sizes);
         else if (tree_type == "splay+")
-            return run_test<yLab::Augmented_Splay_Tree<key_type>>();
+            return (strategy == "semi")
+                ? run_test<yLab::Augmented_Splay_Tree<key_type, compare, allocator,
+                                                      yLab::Semi_Splay>>(batch_sizes)
+                : run_test<yLab::Augmented_Splay_Tree<key_type>>(batch_sizes);
+        else if (tree_type == "top-down")
+            return run_test<yLab::Top_Down_Splay_Tree<key_type>>(batch_sizes);
+        else if (tree_type == "top-down+")
+            return run_test<yLab::Augmented_Top_Down_Splay_Tree<key_type>>(batch_sizes);
         std::unreachable();
     }();
 
@@ -8,6 +8,17 @@
 #include <set>
 #include <numeric>
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <ranges>
+#include <thread>
+#include <random>
+#include <tuple>
+#include <iterator>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <bit>
 
 #include "trees/trees.hpp"
 
@@ -271,6 +282,81 @@ TEST(Augmented_Splay_Tree, Split)
     EXPECT_TRUE(empty_tree.empty());
 }
 
+TEST(Augmented_Splay_Tree, Split_At_Bound)
+{
+    std::vector<key_type> vec(100);
+    std::ranges::generate(vec, [key = 0]() mutable { return key += 2; });
+
+    for (auto key = 1; key != 202; ++key)
+        for (auto bound : {yLab::Split_Bound::lower, yLab::Split_Bound::upper})
+        {
+            tree_type tree(vec.begin(), vec.end());
+            tree.find(vec[key % vec.size()]); // varies the shape of the tree
+
+            auto middle = (bound == yLab::Split_Bound::lower) ? std::ranges::lower_bound(vec, key)
+                                                              : std::ranges::upper_bound(vec, key);
+            auto [left, right] = std::move(tree).split(key, bound);
+
+            EXPECT_TRUE(tree.empty());
+            EXPECT_TRUE(std::ranges::equal(left, std::ranges::subrange(vec.begin(), middle)));
+            EXPECT_TRUE(std::ranges::equal(right, std::ranges::subrange(middle, vec.end())));
+            EXPECT_TRUE(std::equal(left.rbegin(), left.rend(),
+                                   std::make_reverse_iterator(middle), vec.rend()));
+            EXPECT_TRUE(std::equal(right.rbegin(), right.rend(),
+                                   vec.rbegin(), std::make_reverse_iterator(middle)));
+            EXPECT_EQ(left.size(), static_cast<std::size_t>(middle - vec.begin()));
+            EXPECT_EQ(right.size(), static_cast<std::size_t>(vec.end() - middle));
+            EXPECT_TRUE(left.subtree_sizes_verifier());
+            EXPECT_TRUE(right.subtree_sizes_verifier());
+
+            left.insert(key);
+            right.insert(key + 1000);
+            EXPECT_TRUE(left.contains(key));
+            EXPECT_EQ(*std::prev(right.end()), key + 1000);
+        }
+}
+
+TEST(Augmented_Splay_Tree, Split_Plain_Tree)
+{
+    using plain_tree_type = yLab::Splay_Tree<key_type>;
+
+    std::vector<key_type> vec(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    plain_tree_type tree(vec.begin(), vec.end());
+    std::vector<plain_tree_type> pieces;
+
+    // cuts off pieces of 100 keys from the back
+    for (auto key = 899; key > 0; key -= 100)
+        pieces.push_back(tree.split(key));
+
+    pieces.push_back(std::move(tree));
+    std::ranges::reverse(pieces);
+
+    plain_tree_type all;
+    for (auto i = 0; auto &piece : pieces)
+    {
+        EXPECT_TRUE(std::ranges::equal(piece, std::views::iota(i, i + 100)));
+        EXPECT_TRUE(all.join(std::move(piece)));
+        i += 100;
+    }
+
+    EXPECT_EQ(all.size(), 1000);
+    EXPECT_TRUE(std::ranges::equal(all, vec));
+
+    auto [left, right] = std::move(all).split(250, yLab::Split_Bound::lower);
+    left.erase(0);
+    left.insert(-1);
+    left.insert(-2);
+    right.erase(250);
+
+    EXPECT_EQ(left.size(), 251);
+    EXPECT_EQ(right.size(), 749);
+    EXPECT_EQ(*left.begin(), -2);
+    EXPECT_EQ(*std::prev(left.end()), 249);
+    EXPECT_EQ(*right.begin(), 251);
+    EXPECT_TRUE(all.empty());
+}
 
 TEST(Augmented_Splay_Tree, Swap)
 {
@@ -323,6 +409,173 @@ TEST(Augmented_Splay_Tree, Insert_By_Key)
     EXPECT_TRUE(tree.subtree_sizes_verifier());
 }
 
+namespace
+{
+
+// a move-only key that counts the moves made by the tree
+struct Move_Only_Key final
+{
+    int id;
+    std::unique_ptr<int> payload;
+    static inline int n_moves = 0;
+
+    Move_Only_Key(int id, int payload) : id{id}, payload{std::make_unique<int>(payload)} {}
+
+    Move_Only_Key(Move_Only_Key &&rhs) noexcept : id{rhs.id}, payload{std::move(rhs.payload)}
+    {
+        ++n_moves;
+    }
+
+    Move_Only_Key &operator=(Move_Only_Key &&rhs) = default;
+
+    bool operator<(const Move_Only_Key &rhs) const { return id < rhs.id; }
+};
+
+// counts the comparisons made by the tree
+struct Counting_Less final
+{
+    static inline long n_calls = 0;
+
+    bool operator()(int lhs, int rhs) const
+    {
+        ++n_calls;
+        return lhs < rhs;
+    }
+};
+
+// counts the comparisons that involve a key outside [first, last), e.g. a key of the tree
+struct Outside_Counting_Less final
+{
+    static inline const key_type *first = nullptr;
+    static inline const key_type *last = nullptr;
+    static inline long n_calls = 0;
+
+    bool operator()(const key_type &lhs, const key_type &rhs) const
+    {
+        auto is_inside = [](const key_type &key)
+        {
+            return !std::less<>{}(&key, first) && std::less<>{}(&key, last);
+        };
+
+        n_calls += !is_inside(lhs) || !is_inside(rhs);
+        return lhs < rhs;
+    }
+};
+
+} // unnamed namespace
+
+TEST(Augmented_Splay_Tree, Emplace)
+{
+    yLab::Augmented_Splay_Tree<Move_Only_Key> tree;
+
+    // the key is constructed in the node
+    auto [it, is_inserted] = tree.emplace(2, 20);
+    EXPECT_TRUE(is_inserted);
+    EXPECT_EQ(*it->payload, 20);
+    EXPECT_EQ(Move_Only_Key::n_moves, 0);
+
+    std::tie(it, is_inserted) = tree.emplace(2, 21);
+    EXPECT_FALSE(is_inserted);
+    EXPECT_EQ(*it->payload, 20);
+
+    // a key passed by rvalue is looked up first and moved once
+    std::tie(it, is_inserted) = tree.insert(Move_Only_Key{1, 10});
+    EXPECT_TRUE(is_inserted);
+    EXPECT_EQ(Move_Only_Key::n_moves, 1);
+
+    Move_Only_Key present{1, 11};
+    std::tie(it, is_inserted) = tree.emplace(std::move(present));
+    EXPECT_FALSE(is_inserted);
+    EXPECT_EQ(Move_Only_Key::n_moves, 1);
+    EXPECT_NE(present.payload, nullptr);
+
+    it = tree.emplace_hint(tree.end(), 3, 30);
+    EXPECT_EQ(it->id, 3);
+
+    std::vector<Move_Only_Key> keys;
+    for (auto id = 4; id != 8; ++id)
+        keys.emplace_back(id, id * 10);
+
+    tree.insert(std::make_move_iterator(keys.begin()), std::make_move_iterator(keys.end()));
+
+    EXPECT_EQ(tree.size(), 7);
+    EXPECT_EQ(*tree.select(6)->payload, 70);
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+}
+
+TEST(Augmented_Splay_Tree, Hinted_Insert)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{0, 499};
+
+    tree_type tree;
+    std::set<key_type> model;
+
+    for (auto i = 0; i != 5000; ++i)
+    {
+        auto key = keys(gen);
+
+        // good hints, hints off by one position and arbitrary ones
+        auto hint = tree.lower_bound(key + static_cast<key_type>(i % 3) - 1);
+        if (i % 5 == 4)
+            hint = tree.begin();
+
+        auto it = tree.insert(hint, key);
+        model.insert(key);
+
+        ASSERT_EQ(*it, key);
+        ASSERT_EQ(tree.size(), model.size());
+    }
+
+    EXPECT_TRUE(std::ranges::equal(tree, model));
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+
+    // ascending keys are appended to the rightmost node whatever the hint is
+    tree_type stream;
+    for (auto key = 0; key != 1000; ++key)
+        stream.insert(key % 2 ? stream.end() : stream.begin(), key);
+    for (auto key = 1000; key != 2000; ++key)
+        stream.insert(key);
+
+    EXPECT_EQ(stream.size(), 2000);
+    EXPECT_EQ(*stream.select(1234), 1234);
+    EXPECT_TRUE(stream.subtree_sizes_verifier());
+
+    // a descending stream hinted by the key inserted last does not descend from the root
+    yLab::Augmented_Splay_Tree<key_type, Counting_Less> descending{0, 100000};
+    Counting_Less::n_calls = 0;
+
+    auto pos = descending.find(100000);
+    for (auto key = 99999; key != 0; --key)
+        pos = descending.insert(pos, key);
+
+    EXPECT_EQ(descending.size(), 100001);
+    EXPECT_LE(Counting_Less::n_calls, 6 * 100000); // a descent takes about 17 comparisons
+    EXPECT_TRUE(descending.subtree_sizes_verifier());
+}
+
+TEST(Augmented_Splay_Tree, Append_Without_Splaying)
+{
+    yLab::Splay_Tree<key_type> tree{5, 1, 3};
+
+    EXPECT_TRUE(tree.splays_on_append());
+    tree.set_splay_on_append(false);
+
+    auto end = tree.end();
+    for (auto key = 10; key != 100000; ++key)
+        tree.insert(end, key);
+
+    // keys that are not appended are still inserted as usual
+    tree.insert(4);
+    tree.insert(tree.find(10), 7);
+
+    EXPECT_EQ(tree.size(), 99990 + 5);
+    EXPECT_EQ(*std::prev(tree.end()), 99999);
+    EXPECT_EQ(*tree.lower_bound(6), 7);
+    EXPECT_TRUE(std::ranges::is_sorted(tree));
+    EXPECT_TRUE(tree.contains(50000));
+}
+
 TEST(Augmented_Splay_Tree, Insert_Range)
 {
     std::set model{1, 6, 3, 7, 1, 8, 5, 3, 8, 35162, -46, 35};
@@ -389,6 +642,258 @@ TEST(Augmented_Splay_Tree, Erase_By_Key)
     EXPECT_EQ(tree_2, empty_tree);
 }
 
+TEST(Augmented_Splay_Tree, Batches)
+{
+    std::mt19937 gen{7};
+    std::uniform_int_distribution<key_type> keys{0, 3000};
+
+    tree_type tree;
+    std::set<key_type> model;
+
+    // batch sizes cover both merging with all nodes and key by key processing
+    for (auto batch_size : {0, 1, 10, 500, 3, 2000, 40, 7})
+    {
+        std::vector<key_type> batch(batch_size);
+        std::ranges::generate(batch, [&]{ return keys(gen); });
+
+        auto n_new = std::ranges::count_if(std::set(batch.begin(), batch.end()),
+                                           [&](key_type key){ return !model.contains(key); });
+        model.insert(batch.begin(), batch.end());
+
+        EXPECT_EQ(tree.insert_batch(batch), n_new);
+        EXPECT_TRUE(std::ranges::equal(tree, model));
+        EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), model.rbegin(), model.rend()));
+        EXPECT_TRUE(tree.subtree_sizes_verifier());
+    }
+
+    for (auto batch_size : {5, 1000, 1, 30, 3000})
+    {
+        std::vector<key_type> batch(batch_size);
+        std::ranges::generate(batch, [&]{ return keys(gen); });
+
+        std::size_t n_erased = 0;
+        for (auto key : std::set(batch.begin(), batch.end()))
+            n_erased += model.erase(key);
+
+        EXPECT_EQ(tree.erase_batch(batch), n_erased);
+        EXPECT_TRUE(std::ranges::equal(tree, model));
+        EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), model.rbegin(), model.rend()));
+        EXPECT_TRUE(tree.subtree_sizes_verifier());
+    }
+
+    EXPECT_EQ(tree.size(), model.size());
+    EXPECT_EQ(tree.n_less_than(1500),
+              std::distance(model.begin(), model.lower_bound(1500)));
+}
+
+TEST(Augmented_Splay_Tree, Batches_In_Slice)
+{
+    std::mt19937 gen{17};
+    std::uniform_int_distribution<key_type> starts{0, 20000};
+
+    std::vector<key_type> evens(10000);
+    std::ranges::generate(evens, [key = 0]() mutable { return (key += 2); });
+
+    tree_type tree(evens.begin(), evens.end());
+    yLab::Splay_Tree<key_type> plain_tree(evens.begin(), evens.end());
+    std::set<key_type> model(evens.begin(), evens.end());
+
+    // small batches crowded into narrow key ranges are merged with the slices they span
+    for (auto round = 0; round != 20; ++round)
+    {
+        auto start = starts(gen);
+        std::uniform_int_distribution<key_type> keys{start, start + 300};
+
+        std::vector<key_type> batch(100);
+        std::ranges::generate(batch, [&]{ return keys(gen); });
+
+        if (round % 2 == 0)
+        {
+            auto n_new = std::ranges::count_if(std::set(batch.begin(), batch.end()),
+                                               [&](key_type key){ return !model.contains(key); });
+            model.insert(batch.begin(), batch.end());
+
+            EXPECT_EQ(tree.insert_batch(batch), n_new);
+            EXPECT_EQ(plain_tree.insert_batch(batch), n_new);
+        }
+        else
+        {
+            std::size_t n_erased = 0;
+            for (auto key : std::set(batch.begin(), batch.end()))
+                n_erased += model.erase(key);
+
+            EXPECT_EQ(tree.erase_batch(batch), n_erased);
+            EXPECT_EQ(plain_tree.erase_batch(batch), n_erased);
+        }
+
+        ASSERT_TRUE(std::ranges::equal(tree, model));
+        ASSERT_TRUE(std::ranges::equal(plain_tree, model));
+        ASSERT_TRUE(std::equal(tree.rbegin(), tree.rend(), model.rbegin(), model.rend()));
+        ASSERT_TRUE(tree.subtree_sizes_verifier());
+        EXPECT_EQ(tree.size(), model.size());
+        EXPECT_EQ(plain_tree.size(), model.size());
+    }
+
+    EXPECT_EQ(tree.n_less_than(10000), std::distance(model.begin(), model.lower_bound(10000)));
+}
+
+TEST(Augmented_Splay_Tree, Set_Operations)
+{
+    std::mt19937 gen{11};
+
+    auto random_set = [&gen](std::size_t size, key_type max_key)
+    {
+        std::uniform_int_distribution<key_type> keys{0, max_key};
+        std::set<key_type> set;
+
+        while (set.size() != size)
+            set.insert(keys(gen));
+
+        return set;
+    };
+
+    auto check = [](const tree_type &tree, const std::vector<key_type> &expected)
+    {
+        EXPECT_TRUE(std::ranges::equal(tree, expected));
+        EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), expected.rbegin(), expected.rend()));
+        EXPECT_EQ(tree.size(), expected.size());
+        EXPECT_TRUE(tree.subtree_sizes_verifier());
+    };
+
+    // sizes cover comparable trees, much smaller and much larger rhs, disjoint and empty trees
+    for (auto [lhs_size, rhs_size, max_key] : {std::tuple{300uz, 200uz, 1000},
+                                               {2000uz, 10uz, 5000}, {10uz, 2000uz, 5000},
+                                               {0uz, 50uz, 100}, {50uz, 0uz, 100},
+                                               {40000uz, 30000uz, 100000}})
+    {
+        auto lhs = random_set(lhs_size, max_key);
+        auto rhs = random_set(rhs_size, max_key);
+
+        std::vector<key_type> expected;
+        std::ranges::set_union(lhs, rhs, std::back_inserter(expected));
+
+        tree_type tree(lhs.begin(), lhs.end());
+        tree_type other(rhs.begin(), rhs.end());
+        tree.merge_union(std::move(other));
+        check(tree, expected);
+        EXPECT_TRUE(other.empty());
+
+        tree_type par_tree(lhs.begin(), lhs.end());
+        tree_type par_other(rhs.begin(), rhs.end());
+        par_tree.merge_union(std::move(par_other), yLab::parallel);
+        check(par_tree, expected);
+        EXPECT_TRUE(par_other.empty());
+
+        expected.clear();
+        std::ranges::set_intersection(lhs, rhs, std::back_inserter(expected));
+
+        const tree_type rhs_tree(rhs.begin(), rhs.end());
+
+        tree_type intersection(lhs.begin(), lhs.end());
+        intersection.intersect(rhs_tree);
+        check(intersection, expected);
+
+        tree_type par_intersection(lhs.begin(), lhs.end());
+        par_intersection.intersect(rhs_tree, yLab::parallel);
+        check(par_intersection, expected);
+
+        expected.clear();
+        std::ranges::set_difference(lhs, rhs, std::back_inserter(expected));
+
+        tree_type difference(lhs.begin(), lhs.end());
+        difference.subtract(rhs_tree);
+        check(difference, expected);
+
+        tree_type par_difference(lhs.begin(), lhs.end());
+        par_difference.subtract(rhs_tree, yLab::parallel);
+        check(par_difference, expected);
+
+        EXPECT_TRUE(std::ranges::equal(rhs_tree, rhs));
+    }
+
+    tree_type low{1, 2, 3};
+    low.merge_union(tree_type{7, 8});
+    low.merge_union(tree_type{-1, 0});
+    check(low, {-1, 0, 1, 2, 3, 7, 8});
+
+    low.intersect(low);
+    check(low, {-1, 0, 1, 2, 3, 7, 8});
+    low.subtract(low);
+    EXPECT_TRUE(low.empty());
+}
+
+TEST(Augmented_Splay_Tree, Set_Operations_By_Runs)
+{
+    using counting_tree = yLab::Augmented_Splay_Tree<key_type, Counting_Less>;
+    using plain_tree = yLab::Splay_Tree<key_type, Counting_Less>;
+
+    // blocks of keys alternate between the trees, and neighbouring blocks share a key
+    std::vector<key_type> lhs, rhs;
+    for (key_type block = 0; block != 8; ++block)
+    {
+        for (auto key = block * 10000; key <= (block + 1) * 10000; ++key)
+            (block % 2 ? rhs : lhs).push_back(key);
+    }
+
+    std::vector<key_type> united, common, difference;
+    std::ranges::set_union(lhs, rhs, std::back_inserter(united));
+    std::ranges::set_intersection(lhs, rhs, std::back_inserter(common));
+    std::ranges::set_difference(lhs, rhs, std::back_inserter(difference));
+
+    auto check = [](const auto &tree, const std::vector<key_type> &expected)
+    {
+        EXPECT_TRUE(std::ranges::equal(tree, expected));
+        EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), expected.rbegin(), expected.rend()));
+        EXPECT_EQ(tree.size(), expected.size());
+    };
+
+    // the runs are joined as a whole instead of merging 80000 nodes one by one
+    counting_tree tree(lhs.begin(), lhs.end());
+    counting_tree other(rhs.begin(), rhs.end());
+    Counting_Less::n_calls = 0;
+    tree.merge_union(std::move(other));
+    EXPECT_LT(Counting_Less::n_calls, 5000);
+    check(tree, united);
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+    EXPECT_TRUE(other.empty());
+
+    const counting_tree rhs_tree(rhs.begin(), rhs.end());
+    counting_tree rest(lhs.begin(), lhs.end());
+    Counting_Less::n_calls = 0;
+    rest.subtract(rhs_tree);
+    EXPECT_LT(Counting_Less::n_calls, 5000);
+    check(rest, difference);
+    EXPECT_TRUE(rest.subtree_sizes_verifier());
+
+    counting_tree intersection(lhs.begin(), lhs.end());
+    intersection.intersect(rhs_tree);
+    check(intersection, common);
+
+    plain_tree plain(lhs.begin(), lhs.end());
+    plain.merge_union(plain_tree(rhs.begin(), rhs.end()));
+    check(plain, united);
+
+    const plain_tree plain_rhs(rhs.begin(), rhs.end());
+    plain_tree plain_rest(lhs.begin(), lhs.end());
+    plain_rest.subtract(plain_rhs);
+    check(plain_rest, difference);
+
+    // sparse keys of the tree skip long runs of rhs with lower_bound()
+    std::vector<key_type> sparse, dense(52000);
+    std::iota(dense.begin(), dense.end(), 0);
+    for (key_type key = 0; key < 50000; key += 500)
+        sparse.push_back(key);
+    for (key_type key = 50000; key != 52000; ++key)
+        sparse.push_back(key);
+
+    const counting_tree dense_tree(dense.begin(), dense.end());
+    counting_tree sparse_tree(sparse.begin(), sparse.end());
+    Counting_Less::n_calls = 0;
+    sparse_tree.intersect(dense_tree);
+    EXPECT_LT(Counting_Less::n_calls, 26000);
+    check(sparse_tree, sparse);
+}
+
 // Comparison
 
 TEST(Augmented_Splay_Tree, Equality)
@@ -430,3 +935,495 @@ TEST(Augmented_Splay_Tree, Ordering)
     EXPECT_GT(tree_1, tree_5);
     EXPECT_LE(tree_5, tree_1);
 }
+
+// Splay strategies
+
+TEST(Augmented_Splay_Tree, Semi_Splay)
+{
+    using semi_splay_tree = yLab::Augmented_Splay_Tree<key_type, std::less<key_type>,
+                                                       std::allocator<key_type>, yLab::Semi_Splay>;
+
+    std::vector<key_type> vec(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    semi_splay_tree tree(vec.begin(), vec.end()); // sorted insertions make a path
+    std::set<key_type> model(vec.begin(), vec.end());
+
+    for (auto key = 0; key < 990; key += 7)
+    {
+        EXPECT_EQ(*tree.find(key), key);
+        EXPECT_EQ(*tree.lower_bound(key), key);
+        EXPECT_EQ(*tree.upper_bound(key), key + 1);
+        EXPECT_EQ(tree.n_less_than(key), key);
+        EXPECT_TRUE(tree.subtree_sizes_verifier());
+    }
+
+    for (auto key = 0; key < 1000; key += 3)
+    {
+        tree.erase(key);
+        model.erase(key);
+        EXPECT_TRUE(tree.subtree_sizes_verifier());
+    }
+
+    EXPECT_TRUE(std::ranges::equal(tree, model));
+
+    auto right_part = tree.split(500);
+    EXPECT_TRUE(std::ranges::equal(right_part, std::ranges::subrange(model.upper_bound(500),
+                                                                     model.end())));
+    EXPECT_TRUE(tree.join(std::move(right_part)));
+    EXPECT_TRUE(std::ranges::equal(tree, model));
+}
+
+// Non-mutating lookup
+
+TEST(Augmented_Splay_Tree, Cursor)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{0, 9999};
+
+    tree_type tree;
+    std::set<key_type> model;
+
+    for (auto i = 0; i != 2000; ++i)
+    {
+        auto key = keys(gen) * 2;
+        tree.insert(key);
+        model.insert(key);
+    }
+
+    auto cursor = tree.cursor();
+    EXPECT_EQ(cursor.position(), tree.begin());
+
+    // nearby keys, far jumps in both directions and keys beyond the ends
+    key_type key = 0;
+    std::uniform_int_distribution<key_type> steps{-40, 40};
+    for (auto i = 0; i != 20000; ++i)
+    {
+        key = (i % 100 == 0) ? keys(gen) * 2 - 50 : key + steps(gen);
+
+        auto expected = model.lower_bound(key);
+        bool found = cursor.seek(key);
+
+        ASSERT_EQ(found, expected != model.end() && *expected == key);
+        if (expected == model.end())
+            ASSERT_EQ(cursor.position(), tree.end());
+        else
+            ASSERT_EQ(*cursor.position(), *expected);
+
+        if (i % 3 == 0)
+            cursor.splay_here();
+    }
+
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+
+    // merge-join of a sorted probe list against the tree
+    std::vector<key_type> probes(500);
+    std::ranges::generate(probes, [&]{ return keys(gen) * 2; });
+    std::ranges::sort(probes);
+
+    auto join = tree.cursor(tree.end());
+    auto n_matches = std::ranges::count_if(probes, [&](key_type probe){ return join.seek(probe); });
+    auto expected = std::ranges::count_if(probes, [&](key_type probe){ return model.contains(probe); });
+    EXPECT_EQ(n_matches, expected);
+
+    tree_type empty_tree;
+    auto empty_cursor = empty_tree.cursor();
+    EXPECT_FALSE(empty_cursor.seek(1));
+    EXPECT_EQ(empty_cursor.position(), empty_tree.end());
+}
+
+TEST(Augmented_Splay_Tree, Cursor_Gallop)
+{
+    using counting_tree = yLab::Augmented_Splay_Tree<key_type, Counting_Less>;
+    constexpr key_type n = 1 << 16;
+    constexpr auto limit = static_cast<key_type>(counting_tree::cursor_gallop_limit);
+
+    // a perfectly balanced tree: a climb from a leaf to the root alone takes 16 comparisons
+    std::vector<key_type> keys(n);
+    std::iota(keys.begin(), keys.end(), 0);
+    counting_tree tree(keys.begin(), keys.end());
+
+    for (key_type distance : {1, 3, 7, 2 * limit - 1})
+    {
+        auto cursor = tree.cursor();
+        long max_comparisons = 0;
+
+        auto seek = [&](key_type key)
+        {
+            Counting_Less::n_calls = 0;
+            ASSERT_TRUE(cursor.seek(key));
+            ASSERT_EQ(*cursor.position(), key);
+            max_comparisons = std::max(max_comparisons, Counting_Less::n_calls);
+        };
+
+        for (key_type key = 0; key < n; key += distance)
+            seek(key);
+        for (key_type key = n - 1; key >= 0; key -= distance)
+            seek(key);
+
+        // probes at strides 1, 2, 4, ..., a scan of the last stride and two more comparisons
+        EXPECT_LE(max_comparisons, std::bit_width(static_cast<unsigned>(distance)) + limit + 2);
+    }
+}
+
+TEST(Augmented_Splay_Tree, Batched_Queries)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{0, 9999};
+
+    tree_type tree;
+    yLab::Splay_Tree<key_type> plain_tree;
+    std::set<key_type> model;
+
+    for (auto i = 0; i != 3000; ++i)
+    {
+        auto key = keys(gen);
+        tree.insert(key);
+        plain_tree.insert(key);
+        model.insert(key);
+    }
+
+    auto n_less_than = [&](key_type key)
+    {
+        return static_cast<std::size_t>(std::distance(model.begin(), model.lower_bound(key)));
+    };
+
+    // both dense batches stepping through the list and sparse ones jumping over long gaps
+    for (auto n_keys : {10, 5000})
+    {
+        std::vector<key_type> probes(n_keys);
+        std::ranges::generate(probes, [&]{ return keys(gen) - 100; });
+
+        std::vector<std::size_t> ranks(probes.size()), plain_ranks(probes.size());
+        tree.rank_batch(probes, ranks);
+        plain_tree.rank_batch(probes, plain_ranks);
+
+        for (auto i = 0uz; i != probes.size(); ++i)
+            ASSERT_EQ(ranks[i], n_less_than(probes[i]));
+        EXPECT_EQ(plain_ranks, ranks);
+
+        std::vector<std::pair<key_type, key_type>> ranges(n_keys);
+        std::ranges::generate(ranges, [&]{ return std::pair{keys(gen), keys(gen)}; });
+
+        for (auto interval : {yLab::Interval::closed, yLab::Interval::right_open,
+                              yLab::Interval::left_open, yLab::Interval::open})
+        {
+            auto counts = tree.count_ranges_batch(ranges, interval);
+            EXPECT_EQ(plain_tree.count_ranges_batch(ranges, interval), counts);
+
+            for (auto i = 0uz; i != ranges.size(); ++i)
+                ASSERT_EQ(counts[i], tree.peek_count_in_range(ranges[i].first, ranges[i].second,
+                                                              interval));
+        }
+    }
+
+    yLab::Splay_Multiset<key_type> multiset{1, 1, 2, 5, 5, 5};
+    std::vector<key_type> probes{6, 0, 5, 2};
+    std::vector<std::size_t> ranks(probes.size());
+
+    multiset.rank_batch(probes, ranks);
+    EXPECT_EQ(ranks, (std::vector<std::size_t>{6, 0, 3, 2}));
+
+    std::vector<std::pair<key_type, key_type>> ranges{{1, 5}, {5, 1}, {5, 5}};
+    EXPECT_EQ(multiset.count_ranges_batch(ranges, yLab::Interval::closed),
+              (std::vector<std::size_t>{6, 0, 3}));
+}
+
+TEST(Augmented_Splay_Tree, Batched_Queries_Cost)
+{
+    using counting_tree = yLab::Augmented_Splay_Tree<key_type, Outside_Counting_Less>;
+    constexpr key_type n = 1 << 16;
+
+    std::vector<key_type> keys(n);
+    std::iota(keys.begin(), keys.end(), 0);
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> probes{0, n};
+
+    /*
+     * Dense batches are mostly answered by steps, sparser ones by leaps of a finger search. Batches
+     * with gaps beyond sqrt(n) descend from the root and cost about as much as separate lookups
+     */
+    for (key_type n_queries : {n / 2, n / 8, n / 64, n / 256})
+    {
+        counting_tree tree(keys.begin(), keys.end());
+
+        std::vector<key_type> batch(n_queries);
+        std::ranges::generate(batch, [&]{ return probes(gen); });
+        std::vector<std::size_t> ranks(batch.size());
+
+        // comparisons between keys of the batch, made by sorting it, are not counted
+        Outside_Counting_Less::first = batch.data();
+        Outside_Counting_Less::last = batch.data() + batch.size();
+
+        Outside_Counting_Less::n_calls = 0;
+        tree.rank_batch(batch, ranks);
+        auto n_sweep_comparisons = Outside_Counting_Less::n_calls;
+
+        Outside_Counting_Less::n_calls = 0;
+        for (auto i = 0uz; i != batch.size(); ++i)
+            ASSERT_EQ(tree.n_less_than(batch[i]), ranks[i]);
+        auto n_independent_comparisons = Outside_Counting_Less::n_calls;
+
+        EXPECT_LT(n_sweep_comparisons, n_independent_comparisons) << n_queries << " queries";
+    }
+}
+
+TEST(Augmented_Splay_Tree, Count_In_Range)
+{
+    using yLab::Interval;
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{0, 1000};
+
+    tree_type tree;
+    yLab::Splay_Tree<key_type> plain_tree;
+    std::set<key_type> model;
+
+    for (auto i = 0; i != 500; ++i)
+    {
+        auto key = keys(gen);
+        tree.insert(key);
+        plain_tree.insert(key);
+        model.insert(key);
+    }
+
+    auto count = [&model](key_type lo, key_type hi, Interval interval)
+    {
+        return static_cast<std::size_t>(std::ranges::count_if(model, [=](key_type key)
+        {
+            bool after_lo = (interval == Interval::closed || interval == Interval::right_open)
+                          ? lo <= key : lo < key;
+            bool before_hi = (interval == Interval::closed || interval == Interval::left_open)
+                           ? key <= hi : key < hi;
+            return after_lo && before_hi;
+        }));
+    };
+
+    for (auto i = 0; i != 2000; ++i)
+    {
+        auto lo = keys(gen);
+        auto hi = (i % 4 == 0) ? lo : keys(gen);
+
+        for (auto interval : {Interval::closed, Interval::right_open, Interval::left_open,
+                              Interval::open})
+        {
+            EXPECT_EQ(tree.count_in_range(lo, hi, interval), count(lo, hi, interval));
+            EXPECT_EQ(tree.peek_count_in_range(lo, hi, interval), count(lo, hi, interval));
+        }
+
+        auto [first, last] = tree.equal_range(lo);
+        auto [model_first, model_last] = model.equal_range(lo);
+        EXPECT_EQ(first == tree.end() ? -1 : *first,
+                  model_first == model.end() ? -1 : *model_first);
+        EXPECT_EQ(last == tree.end() ? -1 : *last, model_last == model.end() ? -1 : *model_last);
+        EXPECT_EQ(std::distance(first, last), std::distance(model_first, model_last));
+
+        auto [plain_first, plain_last] = plain_tree.equal_range(hi);
+        EXPECT_TRUE(std::ranges::equal(std::ranges::subrange(plain_first, plain_last),
+                                       std::ranges::subrange(model.equal_range(hi).first,
+                                                             model.equal_range(hi).second)));
+        EXPECT_EQ(plain_last, plain_tree.upper_bound(hi));
+    }
+
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+    EXPECT_TRUE(std::ranges::equal(tree, model));
+    EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), model.rbegin(), model.rend()));
+
+    tree_type empty_tree;
+    EXPECT_EQ(empty_tree.count_in_range(0, 10), 0);
+    EXPECT_EQ(empty_tree.equal_range(0).first, empty_tree.end());
+}
+
+TEST(Augmented_Splay_Tree, Order_Statistics)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{0, 10000};
+
+    tree_type tree;
+    std::set<key_type> model;
+
+    for (auto i = 0; i != 2000; ++i)
+    {
+        auto key = keys(gen);
+        tree.insert(key);
+        model.insert(key);
+    }
+
+    std::vector<key_type> sorted(model.begin(), model.end());
+
+    for (auto i = 0; i != 2000; ++i)
+    {
+        auto k = static_cast<std::size_t>(keys(gen)) % sorted.size();
+
+        auto it = tree.select(k);
+        ASSERT_NE(it, tree.end());
+        EXPECT_EQ(*it, sorted[k]);
+        EXPECT_EQ(tree.rank(tree.find(sorted[k])), k);
+        EXPECT_EQ(*tree.peek_select(k), sorted[k]);
+    }
+
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+    EXPECT_EQ(tree.select(sorted.size()), tree.end());
+    EXPECT_EQ(tree.rank(tree.end()), tree.size());
+    EXPECT_EQ(tree.rank(tree.begin()), 0);
+
+    tree_type percentiles;
+    for (auto key = 1; key <= 101; ++key)
+        percentiles.insert(key);
+
+    EXPECT_EQ(*percentiles.quantile(0.0), 1);
+    EXPECT_EQ(*percentiles.quantile(0.5), 51);
+    EXPECT_EQ(*percentiles.quantile(0.9), 91);
+    EXPECT_EQ(*percentiles.quantile(0.99), 100);
+    EXPECT_EQ(*percentiles.quantile(1.0), 101);
+    EXPECT_EQ(*percentiles.median(), 51);
+
+    tree_type even_tree{1, 2, 3, 4};
+    EXPECT_EQ(*even_tree.median(), 2);
+
+    tree_type empty_tree;
+    EXPECT_EQ(empty_tree.select(0), empty_tree.end());
+    EXPECT_EQ(empty_tree.median(), empty_tree.end());
+    EXPECT_EQ(empty_tree.quantile(0.5), empty_tree.end());
+}
+
+TEST(Augmented_Splay_Tree, Peek)
+{
+    tree_type tree{1, 3, 5, 7};
+    tree_type empty_tree;
+
+    EXPECT_EQ(*tree.peek_find(5), 5);
+    EXPECT_EQ(tree.peek_find(4), tree.end());
+    EXPECT_TRUE(tree.peek_contains(1));
+    EXPECT_FALSE(empty_tree.peek_contains(1));
+
+    EXPECT_EQ(*tree.peek_lower_bound(2), 3);
+    EXPECT_EQ(*tree.peek_lower_bound(3), 3);
+    EXPECT_EQ(tree.peek_lower_bound(8), tree.end());
+
+    EXPECT_EQ(*tree.peek_upper_bound(3), 5);
+    EXPECT_EQ(tree.peek_upper_bound(7), tree.end());
+
+    for (auto key = 0; key != 9; ++key)
+        EXPECT_EQ(tree.peek_n_less_than(key), key / 2);
+    EXPECT_EQ(empty_tree.peek_n_less_than(0), 0);
+}
+
+TEST(Augmented_Splay_Tree, Frozen_Concurrent_Readers)
+{
+    std::vector<key_type> vec(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    tree_type tree(vec.begin(), vec.end());
+    auto copy{tree};
+
+    tree.freeze();
+    EXPECT_TRUE(tree.is_frozen());
+
+    std::vector<std::thread> readers;
+    std::vector<int> n_mismatches(4);
+
+    for (auto i = 0; i != 4; ++i)
+        readers.emplace_back([&tree, &mismatches = n_mismatches[i], i]
+        {
+            for (auto key = i; key < 1000; key += 3)
+            {
+                mismatches += (*tree.find(key) != key);
+                mismatches += (*tree.lower_bound(key) != key);
+                mismatches += (tree.n_less_than(key) != static_cast<std::size_t>(key));
+                mismatches += (*tree.select(key) != key);
+                mismatches += (tree.rank(tree.find(key)) != static_cast<std::size_t>(key));
+            }
+        });
+
+    for (auto &reader : readers)
+        reader.join();
+
+    EXPECT_EQ(std::accumulate(n_mismatches.begin(), n_mismatches.end(), 0), 0);
+
+    tree.thaw();
+    EXPECT_FALSE(tree.is_frozen());
+
+    tree.insert(1000);
+    EXPECT_EQ(tree.n_less_than(1000), 1000);
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+    EXPECT_NE(tree, copy);
+}
+
+namespace
+{
+
+struct Record final
+{
+    int id;
+    int payload;
+};
+
+// orders records by their ids and compares them with ids directly
+struct By_Id final
+{
+    using is_transparent = void;
+
+    bool operator()(const Record &lhs, const Record &rhs) const { return lhs.id < rhs.id; }
+    bool operator()(const Record &lhs, int rhs) const { return lhs.id < rhs; }
+    bool operator()(int lhs, const Record &rhs) const { return lhs < rhs.id; }
+    bool operator()(int lhs, int rhs) const { return lhs < rhs; }
+};
+
+} // unnamed namespace
+
+TEST(Augmented_Splay_Tree, Transparent_Lookup)
+{
+    using record_tree = yLab::Augmented_Splay_Tree<Record, By_Id>;
+
+    record_tree tree;
+    for (auto id = 0; id != 100; id += 2)
+        tree.insert(Record{id, -id});
+
+    // ids are not convertible to records, so these calls take the heterogeneous overloads
+    EXPECT_EQ(tree.find(42)->payload, -42);
+    EXPECT_EQ(tree.find(43), tree.end());
+    EXPECT_TRUE(tree.contains(10));
+    EXPECT_EQ(tree.count(11), 0);
+    EXPECT_EQ(tree.lower_bound(43)->id, 44);
+    EXPECT_EQ(tree.upper_bound(44)->id, 46);
+    EXPECT_EQ(tree.n_less_than(51), 26);
+    EXPECT_EQ(tree.count_in_range(10, 20), 5);
+    EXPECT_EQ(tree.count_in_range(10, 20, yLab::Interval::closed), 6);
+    EXPECT_EQ(tree.equal_range(42).first->id, 42);
+    EXPECT_EQ(tree.equal_range(42).second->id, 44);
+    EXPECT_EQ(tree.erase(50), 1);
+
+    EXPECT_EQ(tree.peek_find(42)->payload, -42);
+    EXPECT_TRUE(tree.peek_contains(98));
+    EXPECT_EQ(tree.peek_lower_bound(43)->id, 44);
+    EXPECT_EQ(tree.peek_upper_bound(44)->id, 46);
+    EXPECT_EQ(tree.peek_n_less_than(51), 25);
+    EXPECT_EQ(tree.peek_count_in_range(0, 100), 49);
+
+    auto right = tree.split(60);
+    EXPECT_EQ(tree.size(), 30);
+    EXPECT_EQ(right.begin()->id, 62);
+
+    auto [left, rest] = std::move(right).split(81, yLab::Split_Bound::lower);
+    EXPECT_EQ(left.size(), 10);
+    EXPECT_EQ(rest.begin()->id, 82);
+    EXPECT_TRUE(left.subtree_sizes_verifier());
+
+    yLab::Augmented_Top_Down_Splay_Tree<Record, By_Id> top_down{{1, 10}, {3, 30}, {5, 50}};
+    EXPECT_EQ(top_down.find(3)->payload, 30);
+    EXPECT_EQ(top_down.lower_bound(4)->id, 5);
+    EXPECT_EQ(top_down.n_less_than(4), 2);
+
+    auto [low, high] = std::move(top_down).split(3, yLab::Split_Bound::lower);
+    EXPECT_EQ(low.size(), 1);
+    EXPECT_EQ(high.begin()->id, 3);
+    EXPECT_EQ(high.erase(5), 1);
+
+    // the aliases accept std::less<> as well
+    yLab::Splay_Tree<std::string, std::less<>> strings{"alpha", "beta"};
+    EXPECT_TRUE(strings.contains(std::string_view{"beta"}));
+    EXPECT_EQ(strings.erase("alpha"), 1);
+    EXPECT_EQ(strings.size(), 1);
+}
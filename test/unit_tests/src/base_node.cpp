@@ -29,6 +29,32 @@ TEST(Node_Base, Constructor)
     EXPECT_EQ(node_3.get_parent(), &node_2);
 }
 
+TEST(Node_Base, Thread_Flags)
+{
+    static_assert(sizeof(yLab::Node_Base) == 3 * sizeof(void *));
+
+    yLab::Node_Base prev, next;
+    yLab::Node_Base node;
+
+    node.set_left_thread(&prev);
+    node.set_right(&next);
+
+    EXPECT_TRUE(node.has_left_thread());
+    EXPECT_EQ(node.get_left(), nullptr);
+    EXPECT_EQ(node.get_left_unsafe(), &prev);
+    EXPECT_FALSE(node.has_right_thread());
+    EXPECT_EQ(node.get_right(), &next);
+
+    node.set_left(&prev);
+    node.set_right_thread(&next);
+
+    EXPECT_FALSE(node.has_left_thread());
+    EXPECT_EQ(node.get_left(), &prev);
+    EXPECT_TRUE(node.has_right_thread());
+    EXPECT_EQ(node.get_right(), nullptr);
+    EXPECT_EQ(node.get_right_unsafe(), &next);
+}
+
 TEST(Node_Base, Is_Left_Child)
 {
     yLab::Node_Base left, right;
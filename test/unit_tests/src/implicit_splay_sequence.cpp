@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <iterator>
+#include <utility>
+#include <cstddef>
+#include <ranges>
+
+#include "trees/trees.hpp"
+
+using value_type = int;
+using sequence_type = yLab::Implicit_Splay_Sequence<value_type>;
+
+TEST(Implicit_Splay_Sequence, Constructors)
+{
+    sequence_type empty_sequence;
+    EXPECT_TRUE(empty_sequence.empty());
+    EXPECT_EQ(empty_sequence.begin(), empty_sequence.end());
+
+    sequence_type sequence{3, 1, 2, 1};
+    EXPECT_EQ(sequence.size(), 4);
+    EXPECT_TRUE(std::ranges::equal(sequence, std::vector{3, 1, 2, 1}));
+    EXPECT_TRUE(std::ranges::equal(sequence | std::views::reverse, std::vector{1, 2, 1, 3}));
+
+    auto copy{sequence};
+    EXPECT_EQ(copy, sequence);
+
+    auto moved_to{std::move(copy)};
+    EXPECT_EQ(moved_to, sequence);
+    EXPECT_TRUE(copy.empty());
+
+    copy = moved_to;
+    EXPECT_EQ(copy, sequence);
+
+    sequence_type other{7};
+    other.swap(copy);
+    EXPECT_EQ(other, sequence);
+    EXPECT_TRUE(std::ranges::equal(copy, std::vector{7}));
+}
+
+TEST(Implicit_Splay_Sequence, Access)
+{
+    std::vector<value_type> vec(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    sequence_type sequence(vec.begin(), vec.end());
+
+    for (auto i = 0uz; i < vec.size(); i += 7)
+        EXPECT_EQ(sequence[i], vec[i]);
+
+    sequence[500] = -1;
+    EXPECT_EQ(std::as_const(sequence)[500], -1);
+    EXPECT_EQ(std::ranges::count(sequence, -1), 1);
+}
+
+TEST(Implicit_Splay_Sequence, Random_Edits)
+{
+    std::mt19937 gen{42};
+
+    sequence_type sequence;
+    std::vector<value_type> model;
+
+    auto random_range = [&gen](std::size_t size)
+    {
+        auto pos = std::uniform_int_distribution<std::size_t>{0, size}(gen);
+        auto len = std::uniform_int_distribution<std::size_t>{0, size - pos}(gen);
+
+        return std::pair{pos, len};
+    };
+
+    for (auto i = 0; i != 4000; ++i)
+    {
+        switch (i % 5)
+        {
+            case 0:
+            case 1:
+            {
+                auto pos = std::uniform_int_distribution<std::size_t>{0, model.size()}(gen);
+                auto it = sequence.insert_at(pos, i);
+
+                EXPECT_EQ(*it, i);
+                model.insert(model.begin() + pos, i);
+                break;
+            }
+            case 2:
+            {
+                auto [pos, len] = random_range(model.size());
+
+                sequence.reverse(pos, len);
+                std::reverse(model.begin() + pos, model.begin() + pos + len);
+                break;
+            }
+            case 3:
+            {
+                // moves a range to another place
+                auto [pos, len] = random_range(model.size());
+                auto cut = sequence.extract(pos, len);
+
+                EXPECT_EQ(cut.size(), len);
+                EXPECT_TRUE(std::equal(cut.begin(), cut.end(), model.begin() + pos));
+
+                std::vector<value_type> moved(model.begin() + pos, model.begin() + pos + len);
+                model.erase(model.begin() + pos, model.begin() + pos + len);
+
+                auto to = std::uniform_int_distribution<std::size_t>{0, model.size()}(gen);
+                sequence.splice(to, std::move(cut));
+                model.insert(model.begin() + to, moved.begin(), moved.end());
+
+                EXPECT_TRUE(cut.empty());
+                break;
+            }
+            case 4:
+            {
+                auto [pos, len] = random_range(model.size());
+                len = std::min<std::size_t>(len, 3);
+
+                sequence.erase_range(pos, len);
+                model.erase(model.begin() + pos, model.begin() + pos + len);
+                break;
+            }
+        }
+
+        ASSERT_EQ(sequence.size(), model.size());
+
+        if (!model.empty())
+        {
+            auto pos = std::uniform_int_distribution<std::size_t>{0, model.size() - 1}(gen);
+            EXPECT_EQ(sequence[pos], model[pos]);
+        }
+
+        if (i % 100 == 0)
+        {
+            EXPECT_TRUE(std::ranges::equal(sequence, model));
+            EXPECT_TRUE(std::ranges::equal(sequence | std::views::reverse,
+                                           model | std::views::reverse));
+        }
+    }
+
+    EXPECT_TRUE(std::ranges::equal(sequence, model));
+}
+
+TEST(Implicit_Splay_Sequence, Reverse_Without_Iteration)
+{
+    std::vector<value_type> vec(100);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    sequence_type sequence(vec.begin(), vec.end());
+
+    // reversals stay pending across moves, swaps and splices
+    sequence.reverse(0, 100);
+    sequence.reverse(10, 50);
+
+    sequence_type tail = sequence.extract(60, 40);
+    sequence_type moved{std::move(tail)};
+    sequence.splice(0, std::move(moved));
+
+    std::reverse(vec.begin(), vec.end());
+    std::reverse(vec.begin() + 10, vec.begin() + 60);
+    std::rotate(vec.begin(), vec.begin() + 60, vec.end());
+
+    EXPECT_EQ(sequence[0], vec[0]);
+    EXPECT_EQ(sequence[99], vec[99]);
+    EXPECT_TRUE(std::ranges::equal(sequence, vec));
+
+    sequence.erase_range(0, 100);
+    EXPECT_TRUE(sequence.empty());
+    EXPECT_EQ(sequence.begin(), sequence.end());
+}
@@ -0,0 +1,303 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <fmt/ranges.h> // graphic_dump() of tuple-like keys
+
+#include "trees/trees.hpp"
+
+namespace
+{
+
+using sample_type = std::pair<int, long>;
+
+// samples are ordered by their timestamps, while their values are updated
+struct By_Time final
+{
+    using is_transparent = void;
+
+    bool operator()(const sample_type &lhs, const sample_type &rhs) const
+    {
+        return lhs.first < rhs.first;
+    }
+
+    bool operator()(const sample_type &lhs, int rhs) const { return lhs.first < rhs; }
+    bool operator()(int lhs, const sample_type &rhs) const { return lhs < rhs.first; }
+    bool operator()(int lhs, int rhs) const { return lhs < rhs; }
+};
+
+struct Value final
+{
+    long &operator()(sample_type &sample) const { return sample.second; }
+    long operator()(const sample_type &sample) const { return sample.second; }
+};
+
+template<template<typename, typename> typename Monoid>
+using tree_type = yLab::Lazy_Splay_Tree<sample_type, Monoid<long, Value>,
+                                        yLab::Add_Action<long, Value>, By_Time>;
+
+using sum_tree = tree_type<yLab::Sum_Monoid>;
+using min_tree = tree_type<yLab::Min_Monoid>;
+using max_tree = tree_type<yLab::Max_Monoid>;
+
+sample_type at(int time) { return sample_type{time, 0}; }
+
+} // unnamed namespace
+
+TEST(Lazy_Splay_Tree, Node)
+{
+    using node_type = yLab::Lazy_Node<sample_type, yLab::Sum_Monoid<long, Value>,
+                                      yLab::Add_Action<long, Value>>;
+
+    static_assert(yLab::contains_lazy_tags<node_type>);
+    static_assert(!yLab::contains_lazy_tags<yLab::Monoid_Node<int, yLab::Sum_Monoid<long>>>);
+
+    node_type a{{1, 10}}, c{{3, 30}};
+    node_type b{{2, 20}, &a, &c};
+
+    b.apply(5);
+    EXPECT_EQ(b.get_key().second, 25);
+    EXPECT_EQ(node_type::aggregate(&b), 75);
+    EXPECT_EQ(a.get_key().second, 10);
+
+    b.apply(1);
+    b.push();
+    EXPECT_FALSE(b.has_pending_tag());
+    EXPECT_EQ(a.get_key().second, 16);
+    EXPECT_EQ(c.get_key().second, 36);
+    EXPECT_EQ(node_type::aggregate(&a), 16);
+
+    b.update();
+    EXPECT_EQ(node_type::aggregate(&b), 78);
+}
+
+TEST(Lazy_Splay_Tree, Range_Apply)
+{
+    using yLab::Interval;
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> times{-500, 500};
+    std::uniform_int_distribution<long> deltas{-100, 100};
+
+    sum_tree sums;
+    min_tree mins;
+    max_tree maxs;
+    std::map<int, long> model;
+
+    auto in_range = [](int time, int lo, int hi, Interval interval)
+    {
+        bool has_lo = (interval == Interval::closed || interval == Interval::right_open);
+        bool has_hi = (interval == Interval::closed || interval == Interval::left_open);
+
+        return (has_lo ? lo <= time : lo < time) && (has_hi ? time <= hi : time < hi);
+    };
+
+    constexpr Interval intervals[] = {Interval::closed, Interval::right_open,
+                                      Interval::left_open, Interval::open};
+
+    for (auto i = 0; i != 6000; ++i)
+    {
+        auto time = times(gen);
+
+        if (i % 4 == 3)
+        {
+            sums.erase(at(time));
+            mins.erase(at(time));
+            maxs.erase(at(time));
+            model.erase(time);
+        }
+        else if (i % 4 == 2)
+        {
+            auto lo = times(gen), hi = times(gen);
+            auto delta = deltas(gen);
+            auto interval = intervals[i % 3];
+
+            sums.range_apply(at(lo), at(hi), delta, interval);
+            mins.range_apply(at(lo), at(hi), delta, interval);
+            maxs.range_apply(at(lo), at(hi), delta, interval);
+
+            for (auto &[t, value] : model)
+                if (in_range(t, lo, hi, interval))
+                    value += delta;
+        }
+        else
+        {
+            sample_type sample{time, deltas(gen)};
+
+            sums.insert(sample);
+            mins.insert(sample);
+            maxs.insert(sample);
+            model.emplace(sample);
+        }
+
+        auto lo = times(gen), hi = times(gen);
+
+        for (auto interval : intervals)
+        {
+            long sum = 0;
+            long min = std::numeric_limits<long>::max();
+            long max = std::numeric_limits<long>::lowest();
+
+            for (auto [t, value] : model)
+                if (in_range(t, lo, hi, interval))
+                {
+                    sum += value;
+                    min = std::min(min, value);
+                    max = std::max(max, value);
+                }
+
+            EXPECT_EQ(sums.aggregate(at(lo), at(hi), interval), sum);
+            EXPECT_EQ(mins.aggregate(at(lo), at(hi), interval), min);
+            EXPECT_EQ(maxs.aggregate(at(lo), at(hi), interval), max);
+        }
+
+        // a splayed node carries all updates of its former ancestors
+        if (auto it = sums.find(at(time)); it != sums.end())
+        {
+            EXPECT_EQ(it->second, model.at(time));
+        }
+    }
+
+    EXPECT_TRUE(sums.subtree_sizes_verifier());
+
+    auto same = [](const sample_type &sample, const auto &entry)
+    {
+        return sample.first == entry.first && sample.second == entry.second;
+    };
+
+    sums.flush_updates();
+    mins.flush_updates();
+    EXPECT_TRUE(std::equal(sums.begin(), sums.end(), model.begin(), model.end(), same));
+    EXPECT_TRUE(std::equal(mins.begin(), mins.end(), model.begin(), model.end(), same));
+}
+
+TEST(Lazy_Splay_Tree, Restructuring)
+{
+    std::vector<sample_type> samples;
+    for (auto time = 1; time <= 1000; ++time)
+        samples.emplace_back(time, 1);
+
+    sum_tree tree(samples.begin(), samples.end());
+    tree.range_apply(at(1), at(500), 1, yLab::Interval::closed);
+
+    // copies, splits and joins see pending updates
+    auto copy{tree};
+    EXPECT_EQ(copy.aggregate(at(0), at(1001)), 1500);
+
+    auto right = copy.split(at(250));
+    EXPECT_EQ(copy.aggregate(at(0), at(1001)), 500);
+    EXPECT_EQ(right.aggregate(at(0), at(1001)), 1000);
+
+    right.range_apply(at(0), at(1001), 10);
+    EXPECT_TRUE(copy.join(std::move(right)));
+    EXPECT_EQ(copy.aggregate(at(0), at(1001)), 1500 + 750 * 10);
+    EXPECT_EQ(copy.aggregate(at(251), at(252)), 12);
+
+    tree.erase(at(1));
+    EXPECT_EQ(tree.aggregate(at(0), at(1001)), 1498);
+
+    // a frozen tree keeps its shape and is updated eagerly, so peek lookups see the update at once
+    auto links = [](const sum_tree &tree)
+    {
+        std::stringstream dump;
+        tree.graphic_dump(dump);
+
+        std::vector<std::string> result;
+        for (std::string line; std::getline(dump, line); )
+            if (line.find("->") != std::string::npos)
+                result.push_back(line);
+
+        return result;
+    };
+
+    tree.freeze();
+    auto frozen_links = links(tree);
+
+    tree.range_apply(at(900), at(1000), 5, yLab::Interval::closed);
+    tree.range_apply(at(10), at(20), -1, yLab::Interval::open);
+    EXPECT_EQ(links(tree), frozen_links);
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+
+    EXPECT_EQ(tree.aggregate(at(0), at(1001)), 1498 + 101 * 5 - 9);
+    EXPECT_EQ(tree.aggregate(at(11), at(20)), 9);
+    EXPECT_EQ(tree.find(at(950))->second, 6);
+    EXPECT_EQ(tree.find(at(2))->second, 2);
+    EXPECT_EQ(links(tree), frozen_links);
+
+    // timestamps alone make up ranges as the comparator is transparent
+    EXPECT_EQ(tree.peek_aggregate(900, 1000, yLab::Interval::closed), 101 * 6);
+
+    tree.thaw();
+    tree.range_apply(995, 1000, 1);
+    EXPECT_EQ(tree.aggregate(990, 1001), 11 * 6 + 5);
+    EXPECT_EQ(tree.count_in_range(990, 1001), 11);
+
+    tree.range_apply(at(2), at(2), 100, yLab::Interval::closed);
+    tree.flush_updates();
+    EXPECT_EQ(tree.begin()->second, 102);
+}
+
+TEST(Lazy_Splay_Tree, Frozen_Tree_Takes_Updated_Nodes)
+{
+    // keys of b are updated lazily: only the root of b knows of the update
+    auto updated = [](int first, int last)
+    {
+        sum_tree tree;
+        for (auto time = first; time != last; ++time)
+            tree.insert(sample_type{time, 1});
+
+        tree.range_apply(first, last - 1, 5, yLab::Interval::closed);
+        return tree;
+    };
+
+    auto check = [](sum_tree &tree, int time, long value)
+    {
+        EXPECT_EQ(tree.peek_find(time)->second, value);
+        EXPECT_EQ(tree.find(time)->second, value);
+    };
+
+    sum_tree a{sample_type{0, 1}, sample_type{1, 1}};
+    a.freeze();
+
+    EXPECT_TRUE(a.join(updated(10, 20)));
+    check(a, 15, 6);
+    check(a, 0, 1);
+
+    auto b = updated(30, 40);
+    a.swap(b);
+    EXPECT_TRUE(a.is_frozen());
+    check(a, 35, 6);
+    EXPECT_EQ(b.find(15)->second, 6);
+
+    a.merge_union(updated(35, 50));
+    check(a, 45, 6);
+    check(a, 31, 6);
+    EXPECT_EQ(a.aggregate(30, 49, yLab::Interval::closed), 20 * 6);
+
+    auto c = updated(60, 70);
+    a.merge(c);
+    check(a, 65, 6);
+
+    auto d = updated(80, 90);
+    auto handle = d.extract(d.find(85));
+    EXPECT_TRUE(a.insert(std::move(handle)).inserted);
+    check(a, 85, 6);
+    EXPECT_TRUE(a.subtree_sizes_verifier());
+}
+
+// the payload to update has to be named, as the whole key is what the tree is ordered by
+template<template<typename...> typename Action>
+constexpr bool has_default_projection = requires { typename Action<long>; };
+
+static_assert(!has_default_projection<yLab::Add_Action>);
+static_assert(!yLab::action_of<yLab::Add_Action<long, std::identity>, long,
+                               yLab::Sum_Monoid<long>>);
+static_assert(yLab::action_of<yLab::Add_Action<long, Value>, sample_type,
+                              yLab::Sum_Monoid<long, Value>>);
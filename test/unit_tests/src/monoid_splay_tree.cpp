@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <set>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <limits>
+
+#include "trees/trees.hpp"
+
+using key_type = int;
+using sum_tree = yLab::Monoid_Splay_Tree<key_type, yLab::Sum_Monoid<long>>;
+using min_tree = yLab::Monoid_Splay_Tree<key_type, yLab::Min_Monoid<key_type>>;
+using max_tree = yLab::Monoid_Splay_Tree<key_type, yLab::Max_Monoid<key_type>>;
+
+TEST(Monoid_Splay_Tree, Node)
+{
+    using node_type = yLab::Monoid_Node<key_type, yLab::Sum_Monoid<long>>;
+
+    static_assert(yLab::contains_subtree_size<node_type>);
+    static_assert(yLab::contains_subtree_aggregate<node_type>);
+    static_assert(yLab::maintains_subtree_data<node_type>);
+
+    node_type a{1}, c{3};
+    node_type b{2, &a, &c};
+
+    EXPECT_EQ(node_type::aggregate(&b), 6);
+    EXPECT_EQ(node_type::size(&b), 3);
+    EXPECT_EQ(node_type::aggregate(nullptr), 0);
+
+    node_type root{4, &b};
+    EXPECT_EQ(node_type::aggregate(&root), 10);
+    EXPECT_EQ(node_type::size(&root), 4);
+}
+
+TEST(Monoid_Splay_Tree, Aggregate)
+{
+    using yLab::Interval;
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{-1000, 1000};
+
+    sum_tree sums;
+    min_tree mins;
+    max_tree maxs;
+    std::set<key_type> model;
+
+    auto fold = [&model](key_type lo, key_type hi, Interval interval, auto init, auto combine)
+    {
+        bool has_lo = (interval == Interval::closed || interval == Interval::right_open);
+        bool has_hi = (interval == Interval::closed || interval == Interval::left_open);
+
+        for (auto key : model)
+            if ((has_lo ? lo <= key : lo < key) && (has_hi ? key <= hi : key < hi))
+                init = combine(init, key);
+
+        return init;
+    };
+
+    for (auto i = 0; i != 6000; ++i)
+    {
+        auto key = keys(gen);
+
+        if (i % 3 == 2)
+        {
+            sums.erase(key);
+            mins.erase(key);
+            maxs.erase(key);
+            model.erase(key);
+        }
+        else
+        {
+            sums.insert(key);
+            mins.insert(key);
+            maxs.insert(key);
+            model.insert(key);
+        }
+
+        auto lo = keys(gen), hi = keys(gen);
+
+        for (auto interval : {Interval::closed, Interval::right_open, Interval::left_open,
+                              Interval::open})
+        {
+            auto sum = fold(lo, hi, interval, 0L, std::plus<long>{});
+            auto min = fold(lo, hi, interval, std::numeric_limits<key_type>::max(),
+                            [](key_type x, key_type y) { return std::min(x, y); });
+            auto max = fold(lo, hi, interval, std::numeric_limits<key_type>::lowest(),
+                            [](key_type x, key_type y) { return std::max(x, y); });
+
+            EXPECT_EQ(sums.aggregate(lo, hi, interval), sum);
+            EXPECT_EQ(mins.aggregate(lo, hi, interval), min);
+            EXPECT_EQ(maxs.aggregate(lo, hi, interval), max);
+
+            EXPECT_EQ(sums.peek_aggregate(lo, hi, interval), sum);
+            EXPECT_EQ(mins.peek_aggregate(lo, hi, interval), min);
+        }
+    }
+
+    EXPECT_TRUE(sums.subtree_sizes_verifier());
+    EXPECT_EQ(sums.aggregate(-1000, 1000, Interval::closed),
+              std::accumulate(model.begin(), model.end(), 0L));
+    EXPECT_EQ(sums.count_in_range(-1000, 1000, Interval::closed), model.size());
+}
+
+TEST(Monoid_Splay_Tree, Restructuring)
+{
+    std::vector<key_type> vec(1000);
+    std::iota(vec.begin(), vec.end(), 1);
+
+    // sorted bulk load, structural copy, split and join recompute aggregates
+    sum_tree tree(vec.begin(), vec.end());
+    auto copy{tree};
+    auto right = copy.split(500);
+
+    EXPECT_EQ(copy.aggregate(0, 1001), 500L * 501 / 2);
+    EXPECT_EQ(right.aggregate(0, 1001), 1000L * 1001 / 2 - 500L * 501 / 2);
+    EXPECT_TRUE(copy.join(std::move(right)));
+    EXPECT_EQ(copy.aggregate(0, 1001), tree.aggregate(0, 1001));
+
+    tree.erase_batch(std::vector<key_type>(vec.begin(), vec.begin() + 900));
+    EXPECT_EQ(tree.aggregate(0, 1001), 100L * (901 + 1000) / 2);
+
+    tree.freeze();
+    EXPECT_EQ(tree.aggregate(950, 960), 9545);
+    EXPECT_EQ(tree.aggregate(0, 0), 0);
+}
+
+namespace
+{
+
+struct Bytes final
+{
+    long operator()(const std::pair<key_type, long> &sample) const { return sample.second; }
+};
+
+} // unnamed namespace
+
+TEST(Monoid_Splay_Tree, Projection)
+{
+    using sample_type = std::pair<key_type, long>;
+    using tree_type = yLab::Monoid_Splay_Tree<sample_type, yLab::Sum_Monoid<long, Bytes>>;
+
+    tree_type samples{{1, 100}, {2, 50}, {4, 25}, {8, 10}};
+
+    EXPECT_EQ(samples.aggregate({2, 0}, {8, 0}), 75);
+    EXPECT_EQ(samples.aggregate({0, 0}, {9, 0}), 185);
+    EXPECT_EQ(samples.aggregate({3, 0}, {4, 0}), 0);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <vector>
+#include <type_traits>
 
 #include "nodes/node.hpp"
 
@@ -8,10 +9,17 @@ TEST(Node, Constructors)
     std::vector vec{1, 2, 3, 4, 5};
     auto vec_copy = vec;
 
-    yLab::Node node_1{nullptr, vec};
+    yLab::Node node_1{vec};
     EXPECT_EQ(node_1.get_key(), vec);
 
-    yLab::Node node_2{nullptr, std::move(vec)};
+    yLab::Node node_2{std::move(vec)};
     EXPECT_TRUE(vec.empty());
     EXPECT_EQ(node_2.get_key(), vec_copy);
 }
+
+TEST(Node, Static_Dispatch)
+{
+    static_assert(!std::is_polymorphic_v<yLab::Node_Base>);
+    static_assert(!std::is_polymorphic_v<yLab::Node<int>>);
+    static_assert(std::is_trivially_destructible_v<yLab::Node<int>>);
+}
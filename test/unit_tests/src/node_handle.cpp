@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <utility>
+
+#include "allocators/slab_allocator.hpp"
+#include "trees/trees.hpp"
+
+namespace
+{
+
+using key_type = int;
+using tree_type = yLab::Augmented_Splay_Tree<key_type>;
+
+// counts the comparisons made by the tree
+struct Counting_Less final
+{
+    static inline long n_calls = 0;
+
+    bool operator()(key_type lhs, key_type rhs) const
+    {
+        ++n_calls;
+        return lhs < rhs;
+    }
+};
+
+} // unnamed namespace
+
+TEST(Node_Handle, Extract_And_Insert)
+{
+    tree_type source{1, 2, 3, 4};
+    tree_type target{3, 10};
+
+    auto handle = source.extract(source.find(2));
+    ASSERT_FALSE(handle.empty());
+    EXPECT_EQ(handle.value(), 2);
+    EXPECT_EQ(source.size(), 3);
+    EXPECT_FALSE(source.contains(2));
+
+    const key_type *address = &handle.value();
+
+    auto [it, inserted, rest] = target.insert(std::move(handle));
+    EXPECT_TRUE(inserted);
+    EXPECT_TRUE(rest.empty());
+    EXPECT_TRUE(handle.empty());
+    EXPECT_EQ(&*it, address); // the same node is relinked
+
+    // a handle which key is in the tree comes back
+    auto result = target.insert(source.extract(3));
+    EXPECT_FALSE(result.inserted);
+    EXPECT_EQ(*result.position, 3);
+    EXPECT_EQ(result.node.value(), 3);
+
+    EXPECT_TRUE(source.extract(42).empty());
+    EXPECT_FALSE(target.insert(tree_type::node_handle{}).inserted);
+
+    it = target.insert(target.end(), source.extract(source.begin()));
+    EXPECT_EQ(*it, 1);
+
+    EXPECT_TRUE(std::ranges::equal(source, std::vector{4}));
+    EXPECT_TRUE(std::ranges::equal(target, std::vector{1, 2, 3, 10}));
+    EXPECT_TRUE(source.subtree_sizes_verifier());
+    EXPECT_TRUE(target.subtree_sizes_verifier());
+    EXPECT_EQ(*target.select(2), 3);
+}
+
+TEST(Node_Handle, Map)
+{
+    yLab::Splay_Map<int, std::string> map{{1, "one"}, {2, "two"}};
+
+    auto handle = map.extract(1);
+    EXPECT_EQ(handle.key(), 1);
+    handle.mapped() = "uno";
+
+    yLab::Splay_Map<int, std::string> other;
+    other.insert(std::move(handle));
+
+    EXPECT_EQ(other.at(1), "uno");
+    EXPECT_FALSE(map.contains(1));
+}
+
+TEST(Node_Handle, Merge)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{0, 9999};
+
+    for (auto round = 0; round != 20; ++round)
+    {
+        tree_type lhs, rhs;
+        std::set<key_type> lhs_model, rhs_model;
+
+        for (auto i = 0; i != 500; ++i)
+        {
+            auto key = keys(gen);
+            lhs.insert(key);
+            lhs_model.insert(key);
+        }
+
+        // disjoint ranges and interleaving keys
+        for (auto i = 0; i != 500; ++i)
+        {
+            auto key = (round % 2) ? keys(gen) + 10000 : keys(gen);
+            rhs.insert(key);
+            rhs_model.insert(key);
+        }
+
+        lhs.merge(rhs);
+        lhs_model.merge(rhs_model);
+
+        ASSERT_TRUE(std::ranges::equal(lhs, lhs_model));
+        ASSERT_TRUE(std::ranges::equal(rhs, rhs_model));
+        EXPECT_EQ(lhs.size(), lhs_model.size());
+        EXPECT_EQ(rhs.size(), rhs_model.size());
+        EXPECT_TRUE(lhs.subtree_sizes_verifier());
+        EXPECT_TRUE(rhs.subtree_sizes_verifier());
+    }
+}
+
+TEST(Node_Handle, Merge_In_Linear_Time)
+{
+    using counting_tree = yLab::Augmented_Splay_Tree<key_type, Counting_Less>;
+    constexpr key_type n = 50000;
+
+    // interleaving keys are linked next to the hint, which walks the tree along with the source
+    counting_tree lhs, rhs;
+    for (key_type key = 0; key != n; ++key)
+    {
+        lhs.insert(lhs.end(), 2 * key);
+        rhs.insert(rhs.end(), 2 * key + 1);
+    }
+
+    Counting_Less::n_calls = 0;
+    lhs.merge(rhs);
+
+    EXPECT_LE(Counting_Less::n_calls, 8 * 2 * n); // descents would take about 17 comparisons
+    EXPECT_TRUE(rhs.empty());
+    EXPECT_EQ(lhs.size(), 2 * n);
+    EXPECT_EQ(*lhs.select(12345), 12345);
+    EXPECT_TRUE(lhs.subtree_sizes_verifier());
+
+    // sparse keys make the hint jump over long runs of the tree
+    counting_tree sparse;
+    for (key_type key = 0; key < 2 * n; key += 1000)
+        sparse.insert(key + 1);
+    sparse.insert(-1);
+
+    lhs.merge(sparse);
+    EXPECT_EQ(sparse.size(), 100);
+    EXPECT_EQ(lhs.size(), 2 * n + 1);
+    EXPECT_EQ(*lhs.begin(), -1);
+    EXPECT_TRUE(lhs.subtree_sizes_verifier());
+}
+
+TEST(Node_Handle, Merge_Multiset)
+{
+    yLab::Splay_Multiset<key_type> lhs{1, 1, 3};
+    yLab::Splay_Multiset<key_type> rhs{1, 2, 2, 3};
+
+    // occurrences of common keys are added up
+    lhs.merge(rhs);
+
+    EXPECT_TRUE(rhs.empty());
+    EXPECT_EQ(lhs.count(1), 3);
+    EXPECT_EQ(lhs.count(2), 2);
+    EXPECT_EQ(lhs.count(3), 2);
+    EXPECT_EQ(lhs.total_count(), 7);
+    EXPECT_TRUE(lhs.subtree_sizes_verifier());
+
+    auto handle = lhs.extract(2);
+    EXPECT_EQ(lhs.total_count(), 5);
+
+    lhs.insert(2);
+    EXPECT_FALSE(lhs.insert(std::move(handle)).inserted);
+    EXPECT_EQ(lhs.count(2), 3);
+}
+
+TEST(Node_Handle, Slab_Allocator)
+{
+    using slab_tree = yLab::Splay_Tree<key_type, std::less<key_type>,
+                                       yLab::Slab_Allocator<key_type>>;
+
+    slab_tree lhs{1, 3, 5};
+    slab_tree::node_handle handle;
+
+    {
+        slab_tree rhs{2, 4, 6};
+        handle = rhs.extract(4);
+
+        // nodes of rhs are moved into lhs, which adopts the arena of rhs
+        lhs.merge(rhs);
+        EXPECT_TRUE(rhs.empty());
+    }
+
+    EXPECT_EQ(handle.value(), 4);
+    lhs.insert(std::move(handle));
+
+    EXPECT_TRUE(std::ranges::equal(lhs, std::vector{1, 2, 3, 4, 5, 6}));
+    lhs.erase(4);
+    EXPECT_EQ(lhs.size(), 5);
+}
@@ -3,8 +3,12 @@
 #include <set>
 #include <numeric>
 #include <algorithm>
+#include <sstream>
+#include <iterator>
+#include <cstddef>
 
 #include "nodes/node.hpp"
+#include "nodes/augmented_node.hpp"
 #include "trees/search_tree.hpp"
 
 using key_type = int;
@@ -311,3 +315,134 @@ TEST(Search_Tree, Ordering)
     EXPECT_GT(tree_1, tree_5);
     EXPECT_LE(tree_5, tree_1);
 }
+
+TEST(Search_Tree, Augmented_Subtree_Sizes)
+{
+    using augmented_tree = yLab::Search_Tree<yLab::Augmented_Node<key_type>>;
+
+    std::vector<key_type> vec{8, 4, 12, 2, 6, 10, 14, 1, 3, 5, 7, 9, 11, 13, 15};
+    augmented_tree tree(vec.begin(), vec.end());
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+
+    for (auto key : {1, 4, 8, 15, 12})
+    {
+        tree.erase(key);
+        EXPECT_TRUE(tree.subtree_sizes_verifier());
+    }
+}
+
+TEST(Search_Tree, Sorted_Bulk_Load)
+{
+    // counts comparisons: a lookup in a balanced tree of 1023 keys makes at most 2 * 10 of them
+    struct counting_less
+    {
+        bool operator()(key_type lhs, key_type rhs) const
+        {
+            ++*n_calls;
+            return lhs < rhs;
+        }
+
+        std::size_t *n_calls;
+    };
+
+    using augmented_tree =
+        yLab::Search_Tree<yLab::Augmented_Node<key_type>, counting_less>;
+
+    std::vector<key_type> vec(1023);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    std::size_t n_calls = 0;
+    augmented_tree tree(vec.begin(), vec.end(), counting_less{&n_calls});
+
+    EXPECT_EQ(n_calls, vec.size() - 1);
+    EXPECT_TRUE(std::ranges::equal(tree, vec));
+    EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), vec.rbegin(), vec.rend()));
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+
+    for (auto key : {0, 511, 1022, 1023})
+    {
+        n_calls = 0;
+        tree.find(key);
+        EXPECT_LE(n_calls, 20);
+    }
+
+    // the unsorted tail is inserted one by one
+    std::istringstream is{"1 3 5 7 6 2 9"};
+    tree_type input_tree(std::istream_iterator<key_type>{is}, std::istream_iterator<key_type>{});
+    EXPECT_TRUE(std::ranges::equal(input_tree, std::vector{1, 2, 3, 5, 6, 7, 9}));
+
+    input_tree.assign_sorted(vec.begin(), vec.end());
+    EXPECT_TRUE(std::ranges::equal(input_tree, vec));
+
+    input_tree.erase(511);
+    input_tree.insert(1500);
+    EXPECT_EQ(input_tree.size(), vec.size());
+    EXPECT_EQ(*std::prev(input_tree.end()), 1500);
+}
+
+TEST(Search_Tree, Structural_Copy)
+{
+    struct counting_less
+    {
+        bool operator()(key_type lhs, key_type rhs) const
+        {
+            ++*n_calls;
+            return lhs < rhs;
+        }
+
+        std::size_t *n_calls;
+    };
+
+    using augmented_tree =
+        yLab::Search_Tree<yLab::Augmented_Node<key_type>, counting_less>;
+
+    std::size_t n_calls = 0;
+    augmented_tree tree{counting_less{&n_calls}};
+
+    // a chain leaning to the right with a few branches
+    for (auto key = 0; key != 200; ++key)
+        tree.insert(key % 3 ? key : -key);
+
+    n_calls = 0;
+    augmented_tree copy{tree};
+    EXPECT_EQ(n_calls, 0);
+    EXPECT_EQ(copy, tree);
+    EXPECT_TRUE(std::equal(copy.rbegin(), copy.rend(), tree.rbegin(), tree.rend()));
+    EXPECT_TRUE(copy.subtree_sizes_verifier());
+
+    // lookups of every key make the same number of comparisons in both trees
+    for (auto key : tree)
+    {
+        n_calls = 0;
+        tree.find(key);
+        auto n_calls_in_tree = n_calls;
+
+        n_calls = 0;
+        copy.find(key);
+        EXPECT_EQ(n_calls, n_calls_in_tree);
+    }
+
+    augmented_tree balanced{tree, yLab::Copy_Shape::balance};
+    EXPECT_EQ(balanced, tree);
+    EXPECT_TRUE(balanced.subtree_sizes_verifier());
+
+    for (auto key : tree)
+    {
+        n_calls = 0;
+        balanced.find(key);
+        EXPECT_LE(n_calls, 2 * 8);
+    }
+
+    copy.erase(copy.begin());
+    copy.insert(1000);
+    EXPECT_NE(copy, tree);
+    EXPECT_TRUE(copy.subtree_sizes_verifier());
+
+    std::vector<key_type> vec(tree_type::parallel_copy_threshold + 1);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    tree_type big_tree(vec.begin(), vec.end());
+    tree_type big_copy{big_tree};
+    EXPECT_EQ(big_copy, big_tree);
+    EXPECT_TRUE(std::equal(big_copy.rbegin(), big_copy.rend(), vec.rbegin(), vec.rend()));
+}
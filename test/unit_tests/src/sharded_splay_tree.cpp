@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <set>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <iterator>
+#include <thread>
+#include <cstddef>
+
+#include "trees/trees.hpp"
+
+using key_type = int;
+using tree_type = yLab::Sharded_Splay_Tree<key_type>;
+
+TEST(Sharded_Splay_Tree, Constructors)
+{
+    tree_type empty_tree(4);
+    EXPECT_TRUE(empty_tree.empty());
+    EXPECT_EQ(empty_tree.n_shards(), 4);
+    EXPECT_EQ(empty_tree.begin(), empty_tree.end());
+    EXPECT_EQ(empty_tree.n_less_than(0), 0);
+
+    tree_type tree({5, 1, 4, 2, 3, 2, 1}, 8);
+    EXPECT_EQ(tree.size(), 5);
+    EXPECT_TRUE(std::ranges::equal(tree, std::vector{1, 2, 3, 4, 5}));
+    EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), std::vector{5, 4, 3, 2, 1}.begin()));
+
+    tree_type default_tree;
+    EXPECT_GE(default_tree.n_shards(), 1);
+}
+
+TEST(Sharded_Splay_Tree, Random_Operations)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{0, 2000};
+
+    tree_type tree(4);
+    std::set<key_type> model;
+
+    for (auto i = 0; i != 20000; ++i)
+    {
+        const auto key = keys(gen);
+
+        switch (i % 4)
+        {
+            case 0:
+            case 1:
+                EXPECT_EQ(tree.insert(key), model.insert(key).second);
+                break;
+
+            case 2:
+                EXPECT_EQ(tree.erase(key), model.erase(key));
+                break;
+
+            default:
+            {
+                const auto last = keys(gen);
+                auto it = model.lower_bound(key);
+
+                EXPECT_EQ(tree.contains(key), it != model.end() && *it == key);
+                EXPECT_EQ(tree.n_less_than(key),
+                          static_cast<std::size_t>(std::distance(model.begin(), it)));
+                EXPECT_EQ(tree.count_in_range(key, last),
+                          key < last ? static_cast<std::size_t>(
+                                           std::distance(it, model.lower_bound(last)))
+                                     : 0);
+                break;
+            }
+        }
+    }
+
+    EXPECT_EQ(tree.size(), model.size());
+    EXPECT_TRUE(std::ranges::equal(tree, model));
+    EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), model.rbegin(), model.rend()));
+}
+
+TEST(Sharded_Splay_Tree, Rebalance)
+{
+    tree_type tree(4);
+
+    // ascending keys always land in the last shard
+    for (auto key = 0; key != 1000; ++key)
+        tree.insert(key);
+
+    for (std::size_t i = 0; i != tree.n_shards(); ++i)
+        EXPECT_LE(2 * tree.n_shards() * tree.shard_size(i), 3 * tree.size()
+                                                            + 2 * tree.n_shards()
+                                                                * tree_type::min_rebalance_size);
+
+    for (auto key = 0; key != 1000; key += 2)
+        tree.erase(key);
+
+    tree.rebalance();
+
+    for (std::size_t i = 0; i != tree.n_shards(); ++i)
+        EXPECT_EQ(tree.shard_size(i), 125);
+
+    std::vector<key_type> odd(500);
+    std::ranges::generate(odd, [key = -1]() mutable { return key += 2; });
+
+    EXPECT_TRUE(std::ranges::equal(tree, odd));
+    EXPECT_EQ(tree.n_less_than(500), 250);
+    EXPECT_EQ(tree.count_in_range(240, 760), 260);
+
+    tree.clear();
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.begin(), tree.end());
+}
+
+TEST(Sharded_Splay_Tree, Local_Rebalancing)
+{
+    tree_type tree(8);
+    std::set<key_type> model;
+    const auto n_shards = tree.n_shards();
+
+    // the last shard passes ascending keys on to its neighbours
+    for (auto key = 0; key != 10000; ++key)
+    {
+        tree.insert(key);
+        model.insert(key);
+    }
+
+    for (std::size_t i = 0; i != n_shards; ++i)
+    {
+        EXPECT_GT(tree.shard_size(i), 0);
+        EXPECT_LE(2 * n_shards * tree.shard_size(i), 3 * tree.size());
+    }
+
+    // the first shards take keys from their neighbours as they lose their own ones
+    for (auto key = 0; key != 3000; ++key)
+    {
+        tree.erase(key);
+        model.erase(key);
+    }
+
+    for (std::size_t i = 0; i != n_shards; ++i)
+        EXPECT_GE(2 * n_shards * tree.shard_size(i), tree.size());
+
+    EXPECT_EQ(tree.size(), model.size());
+    EXPECT_TRUE(std::ranges::equal(tree, model));
+
+    for (auto key = 2500; key < 10500; key += 250)
+    {
+        auto n_less = std::distance(model.begin(), model.lower_bound(key));
+        EXPECT_EQ(tree.n_less_than(key), static_cast<std::size_t>(n_less));
+        EXPECT_EQ(tree.contains(key), model.contains(key));
+    }
+}
+
+TEST(Sharded_Splay_Tree, Concurrent_Operations)
+{
+    constexpr auto n_threads = 4;
+    constexpr auto n_keys = 5000;
+
+    tree_type tree(n_threads);
+    std::vector<std::thread> threads;
+    std::vector<int> n_failures(n_threads);
+
+    // thread i owns keys equal to i modulo n_threads
+    for (auto i = 0; i != n_threads; ++i)
+        threads.emplace_back([&tree, &failures = n_failures[i], i]
+        {
+            for (auto key = i; key < n_keys; key += n_threads)
+                failures += !tree.insert(key);
+
+            for (auto key = i; key < n_keys; key += 2 * n_threads)
+                failures += (tree.erase(key) != 1);
+
+            for (auto key = i; key < n_keys; key += n_threads)
+            {
+                failures += (tree.contains(key) != (key % (2 * n_threads) >= n_threads));
+                failures += (tree.n_less_than(key) > static_cast<std::size_t>(key));
+                failures += (tree.count_in_range(key, key + 1) > 1);
+            }
+        });
+
+    for (auto &thread : threads)
+        thread.join();
+
+    EXPECT_EQ(std::accumulate(n_failures.begin(), n_failures.end(), 0), 0);
+
+    std::vector<key_type> expected;
+    for (auto key = 0; key != n_keys; ++key)
+        if (key % (2 * n_threads) >= n_threads)
+            expected.push_back(key);
+
+    EXPECT_EQ(tree.size(), expected.size());
+    EXPECT_TRUE(std::ranges::equal(tree, expected));
+    EXPECT_EQ(tree.n_less_than(n_keys), expected.size());
+}
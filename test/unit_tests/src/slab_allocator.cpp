@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <set>
+#include <numeric>
+#include <algorithm>
+#include <string>
+
+#include "allocators/slab_allocator.hpp"
+#include "allocators/allocator_concepts.hpp"
+#include "trees/trees.hpp"
+
+using key_type = int;
+using allocator_type = yLab::Slab_Allocator<key_type>;
+using tree_type = yLab::Augmented_Splay_Tree<key_type, std::less<key_type>, allocator_type>;
+
+TEST(Slab_Arena, Reuse_Freed_Blocks)
+{
+    yLab::Slab_Arena arena;
+
+    void *block_1 = arena.allocate(24);
+    void *block_2 = arena.allocate(24);
+    EXPECT_NE(block_1, block_2);
+    EXPECT_EQ(arena.n_slabs(), 1);
+
+    arena.deallocate(block_1, 24);
+    EXPECT_EQ(arena.allocate(24), block_1);
+
+    arena.release();
+    EXPECT_EQ(arena.n_slabs(), 0);
+}
+
+TEST(Slab_Arena, Merge)
+{
+    auto lhs = std::make_shared<yLab::Slab_Arena>();
+    auto rhs = std::make_shared<yLab::Slab_Arena>();
+
+    void *block = rhs->allocate(32);
+    lhs->allocate(32);
+
+    lhs->merge(*rhs);
+
+    EXPECT_EQ(&rhs->root(), lhs.get());
+    EXPECT_EQ(lhs->n_slabs(), 2);
+    EXPECT_EQ(rhs->n_slabs(), 0);
+
+    lhs->deallocate(block, 32);
+    EXPECT_EQ(lhs->allocate(32), block);
+}
+
+TEST(Slab_Allocator, Concepts)
+{
+    static_assert(yLab::releasable_allocator<allocator_type>);
+    static_assert(yLab::adoptable_allocator<allocator_type>);
+    static_assert(!yLab::releasable_allocator<std::allocator<key_type>>);
+}
+
+TEST(Slab_Allocator, Rebind_Shares_Arena)
+{
+    allocator_type alloc;
+    yLab::Slab_Allocator<double> rebound{alloc};
+
+    EXPECT_TRUE(alloc == rebound);
+    EXPECT_FALSE(alloc == allocator_type{});
+
+    auto copy = alloc.select_on_container_copy_construction();
+    EXPECT_FALSE(copy == alloc);
+}
+
+TEST(Slab_Allocator, Insert_Erase)
+{
+    std::vector<key_type> vec(10000);
+    std::iota(vec.begin(), vec.end(), -5000);
+    std::ranges::reverse(vec);
+
+    tree_type tree(vec.begin(), vec.end());
+    std::set<key_type> model(vec.begin(), vec.end());
+
+    for (auto key = -5000; key < 5000; key += 3)
+    {
+        tree.erase(key);
+        model.erase(key);
+    }
+
+    EXPECT_TRUE(std::ranges::equal(tree, model));
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+
+    const auto n_slabs = tree.get_allocator().n_slabs();
+    tree.insert(vec.begin(), vec.end()); // reuses freed nodes
+    EXPECT_EQ(tree.get_allocator().n_slabs(), n_slabs);
+}
+
+TEST(Slab_Allocator, Clear_Drops_Slabs)
+{
+    tree_type tree;
+    for (auto key = 0; key != 10000; ++key)
+        tree.insert(key);
+
+    EXPECT_GT(tree.get_allocator().n_slabs(), 1);
+
+    tree.clear();
+
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.get_allocator().n_slabs(), 0);
+
+    tree.insert({3, 1, 2});
+    EXPECT_TRUE(std::ranges::equal(tree, std::vector{1, 2, 3}));
+}
+
+TEST(Slab_Allocator, Non_Trivial_Keys)
+{
+    using string_tree = yLab::Splay_Tree<std::string, std::less<std::string>,
+                                         yLab::Slab_Allocator<std::string>>;
+
+    string_tree tree{"splay", "tree", "with", "a", "slab", "allocator"};
+    auto copy{tree};
+
+    tree.erase("splay");
+    tree.clear();
+
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(copy.size(), 6);
+}
+
+TEST(Slab_Allocator, Copy_And_Move)
+{
+    tree_type tree{5, 2, 4, 1, 3};
+
+    auto copy{tree};
+    EXPECT_EQ(copy, tree);
+    EXPECT_FALSE(copy.get_allocator() == tree.get_allocator());
+
+    auto moved_to{std::move(copy)};
+    EXPECT_EQ(moved_to, tree);
+
+    copy.insert(42); // moved-from tree is still usable
+    EXPECT_EQ(copy.size(), 1);
+}
+
+TEST(Slab_Allocator, Join_And_Split)
+{
+    tree_type tree_1{1, 2, 3, 4, 5};
+    tree_type tree_2{6, 7, 8, 9, 10};
+
+    EXPECT_TRUE(tree_1.join(std::move(tree_2)));
+    EXPECT_TRUE(tree_1.get_allocator() == tree_2.get_allocator());
+
+    tree_2 = tree_type{11};
+
+    auto right_part = tree_1.split(5);
+    EXPECT_TRUE(right_part.get_allocator() == tree_1.get_allocator());
+
+    right_part.erase(8);
+    tree_1.erase(1);
+
+    EXPECT_TRUE(std::ranges::equal(tree_1, std::vector{2, 3, 4, 5}));
+    EXPECT_TRUE(std::ranges::equal(right_part, std::vector{6, 7, 9, 10}));
+    EXPECT_TRUE(tree_1.subtree_sizes_verifier());
+    EXPECT_TRUE(right_part.subtree_sizes_verifier());
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <stdexcept>
+#include <iterator>
+
+#include "trees/trees.hpp"
+
+namespace
+{
+
+using map_type = yLab::Splay_Map<int, std::string>;
+using augmented_map_type = yLab::Augmented_Splay_Map<int, long>;
+
+template<typename Map, typename Model>
+bool same_entries(const Map &map, const Model &model)
+{
+    return std::equal(map.begin(), map.end(), model.begin(), model.end(),
+                      [](const auto &lhs, const auto &rhs)
+                      {
+                          return lhs.first == rhs.first && lhs.second == rhs.second;
+                      });
+}
+
+} // unnamed namespace
+
+TEST(Splay_Map, Node)
+{
+    using node_type = yLab::Map_Node<int, std::string>;
+
+    static_assert(yLab::contains_mapped_value<node_type>);
+    static_assert(yLab::contains_mapped_value<yLab::Augmented_Map_Node<int, long>>);
+    static_assert(!yLab::contains_mapped_value<yLab::Node<std::pair<int, int>>>);
+
+    // iterators of maps give access to the pairs stored in the nodes
+    static_assert(std::same_as<std::iter_reference_t<map_type::iterator>,
+                               std::pair<const int, std::string> &>);
+    static_assert(std::same_as<std::iter_reference_t<yLab::Splay_Tree<int>::iterator>,
+                               const int &>);
+
+    node_type node{std::in_place, std::piecewise_construct, std::forward_as_tuple(1),
+                   std::forward_as_tuple(3, 'a')};
+    EXPECT_EQ(node.get_key(), 1);
+    EXPECT_EQ(node.get_value().second, "aaa");
+}
+
+TEST(Splay_Map, Access)
+{
+    map_type map{{2, "two"}, {1, "one"}};
+
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(map.at(1), "one");
+    EXPECT_THROW(map.at(3), std::out_of_range);
+    EXPECT_THROW(std::as_const(map).at(3), std::out_of_range);
+
+    // operator[] value-initializes missing values
+    EXPECT_EQ(map[3], "");
+    map[3] = "three";
+    EXPECT_EQ(std::as_const(map).at(3), "three");
+    EXPECT_EQ(map.size(), 3);
+
+    auto [it, inserted] = map.try_emplace(1, "uno");
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(it->second, "one");
+
+    std::tie(it, inserted) = map.try_emplace(4, 2, '4');
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(it->second, "44");
+
+    std::tie(it, inserted) = map.insert_or_assign(1, "uno");
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(map.at(1), "uno");
+
+    std::tie(it, inserted) = map.insert({5, "five"});
+    EXPECT_TRUE(inserted);
+    EXPECT_FALSE(map.insert({5, "cinque"}).second);
+
+    EXPECT_TRUE(map.emplace(6, "six").second);
+    EXPECT_FALSE(map.emplace(std::pair<const int, std::string>{6, "sei"}).second);
+    EXPECT_EQ(map.erase(6), 1);
+
+    map.find(2)->second += "!";
+    EXPECT_EQ(map.at(2), "two!");
+
+    EXPECT_EQ(map.erase(4), 1);
+    EXPECT_FALSE(map.contains(4));
+
+    std::map<int, std::string> model{{1, "uno"}, {2, "two!"}, {3, "three"}, {5, "five"}};
+    EXPECT_TRUE(same_entries(map, model));
+
+    auto copy{map};
+    EXPECT_EQ(copy, map);
+    copy[1] = "one";
+    EXPECT_NE(copy, map);
+}
+
+TEST(Splay_Map, Random_Operations)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> keys{0, 999};
+
+    augmented_map_type map;
+    std::map<int, long> model;
+
+    for (auto i = 0; i != 20000; ++i)
+    {
+        auto key = keys(gen);
+
+        switch (i % 4)
+        {
+            case 0:
+                map[key] += i;
+                model[key] += i;
+                break;
+            case 1:
+                map.insert_or_assign(key, i);
+                model.insert_or_assign(key, i);
+                break;
+            case 2:
+                EXPECT_EQ(map.try_emplace(key, i).second, model.try_emplace(key, i).second);
+                break;
+            case 3:
+                EXPECT_EQ(map.erase(key), model.erase(key));
+                break;
+        }
+
+        ASSERT_EQ(map.size(), model.size());
+    }
+
+    EXPECT_TRUE(map.subtree_sizes_verifier());
+    EXPECT_TRUE(same_entries(map, model));
+
+    auto k = model.size() / 3;
+    EXPECT_EQ(*map.select(k), *std::next(model.begin(), k));
+
+    // the balanced copy is built from pairs in O(n)
+    augmented_map_type balanced{map, yLab::Copy_Shape::balance};
+    EXPECT_TRUE(same_entries(balanced, model));
+
+    auto pivot = std::next(model.begin(), k)->first;
+    auto right = map.split(pivot);
+
+    EXPECT_EQ(map.size(), k + 1);
+    EXPECT_EQ(map.size() + right.size(), model.size());
+    EXPECT_TRUE(map.join(std::move(right)));
+    EXPECT_TRUE(same_entries(map, model));
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <iterator>
+#include <utility>
+
+#include "trees/trees.hpp"
+
+namespace
+{
+
+using key_type = int;
+using multiset_type = yLab::Splay_Multiset<key_type>;
+
+// checks that every key of the model occurs in multiset as many times as in the model
+bool same_counts(const multiset_type &multiset, const std::multiset<key_type> &model)
+{
+    if (multiset.total_count() != model.size())
+        return false;
+
+    for (auto it = model.begin(); it != model.end(); it = model.upper_bound(*it))
+        if (multiset.count(*it) != model.count(*it))
+            return false;
+
+    return true;
+}
+
+} // unnamed namespace
+
+TEST(Splay_Multiset, Node)
+{
+    using node_type = yLab::Counted_Node<key_type>;
+
+    static_assert(yLab::contains_key_count<node_type>);
+    static_assert(!yLab::contains_key_count<yLab::Augmented_Node<key_type>>);
+
+    node_type a{1}, c{3};
+    node_type b{2, &a, &c};
+
+    b.set_count(4);
+    EXPECT_EQ(b.count(), 4);
+    EXPECT_EQ(node_type::size(&b), 6);
+
+    a.set_count(2);
+    b.update();
+    EXPECT_EQ(node_type::size(&b), 7);
+}
+
+TEST(Splay_Multiset, Counting)
+{
+    multiset_type multiset{3, 1, 3, 2, 3, 1};
+
+    // one node per distinct key
+    EXPECT_EQ(multiset.size(), 3);
+    EXPECT_EQ(multiset.total_count(), 6);
+    EXPECT_TRUE(std::ranges::equal(multiset, std::vector{1, 2, 3}));
+
+    EXPECT_EQ(multiset.count(3), 3);
+    EXPECT_EQ(multiset.count(4), 0);
+
+    EXPECT_FALSE(multiset.insert(2).second);
+    EXPECT_TRUE(multiset.insert(4).second);
+    EXPECT_EQ(multiset.count(2), 2);
+
+    EXPECT_EQ(multiset.n_less_than(3), 4);
+    EXPECT_EQ(multiset.count_in_range(1, 3, yLab::Interval::closed), 7);
+    EXPECT_EQ(*multiset.select(3), 2);
+    EXPECT_EQ(*multiset.select(4), 3);
+    EXPECT_EQ(multiset.rank(multiset.find(4)), 7);
+    EXPECT_EQ(*multiset.median(), 2);
+
+    EXPECT_EQ(multiset.erase_one(3), 1);
+    EXPECT_EQ(multiset.count(3), 2);
+    EXPECT_EQ(multiset.erase_one(5), 0);
+
+    EXPECT_EQ(multiset.erase(1), 2);
+    EXPECT_FALSE(multiset.contains(1));
+    EXPECT_EQ(multiset.total_count(), 5);
+    EXPECT_TRUE(multiset.subtree_sizes_verifier());
+
+    // copies of both shapes keep counts
+    multiset_type copy{multiset};
+    multiset_type balanced{multiset, yLab::Copy_Shape::balance};
+    EXPECT_EQ(copy.count(3), 2);
+    EXPECT_EQ(balanced.count(3), 2);
+    EXPECT_EQ(balanced.total_count(), 5);
+}
+
+TEST(Splay_Multiset, Random_Operations)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{0, 99};
+
+    multiset_type multiset;
+    std::multiset<key_type> model;
+
+    for (auto i = 0; i != 20000; ++i)
+    {
+        auto key = keys(gen);
+
+        if (i % 3 == 2)
+        {
+            auto erased = multiset.erase_one(key);
+            if (auto it = model.find(key); it != model.end())
+            {
+                model.erase(it);
+                EXPECT_EQ(erased, 1);
+            }
+            else
+                EXPECT_EQ(erased, 0);
+        }
+        else
+        {
+            multiset.insert(key);
+            model.insert(key);
+        }
+
+        auto lo = keys(gen), hi = keys(gen);
+
+        EXPECT_EQ(multiset.n_less_than(lo), std::distance(model.begin(), model.lower_bound(lo)));
+
+        auto expected = (lo < hi) ? std::distance(model.lower_bound(lo), model.lower_bound(hi)) : 0;
+        EXPECT_EQ(multiset.count_in_range(lo, hi), expected);
+
+        if (!model.empty())
+        {
+            auto k = std::uniform_int_distribution<std::size_t>{0, model.size() - 1}(gen);
+            EXPECT_EQ(*multiset.select(k), *std::next(model.begin(), k));
+        }
+    }
+
+    EXPECT_TRUE(multiset.subtree_sizes_verifier());
+    EXPECT_TRUE(same_counts(multiset, model));
+
+    auto right = multiset.split(50);
+    EXPECT_EQ(multiset.total_count(), std::distance(model.begin(), model.upper_bound(50)));
+    EXPECT_TRUE(multiset.join(std::move(right)));
+    EXPECT_TRUE(same_counts(multiset, model));
+}
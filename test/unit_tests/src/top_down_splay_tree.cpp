@@ -0,0 +1,249 @@
+/*
+ * Top-down splay tree shares the interface of the bottom-up one, so the following tests focus on
+ * the restructuring: threads, subtree sizes and boundary nodes after every operation
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <set>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <iterator>
+#include <cstddef>
+
+#include "trees/trees.hpp"
+
+using key_type = int;
+using tree_type = yLab::Augmented_Top_Down_Splay_Tree<key_type>;
+
+TEST(Top_Down_Splay_Tree, Parentless_Nodes)
+{
+    static_assert(sizeof(yLab::Parentless_Node_Base) == 2 * sizeof(void *));
+    static_assert(sizeof(yLab::Node<key_type, yLab::Parentless_Node_Base>) <
+                  sizeof(yLab::Node<key_type>));
+}
+
+TEST(Top_Down_Splay_Tree, Constructors)
+{
+    tree_type empty_tree;
+    EXPECT_TRUE(empty_tree.empty());
+    EXPECT_EQ(empty_tree.begin(), empty_tree.end());
+
+    tree_type tree{1, 2, 3, 2, 4, 1, 5};
+    EXPECT_TRUE(std::ranges::equal(tree, std::vector{1, 2, 3, 4, 5}));
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+
+    auto copy{tree};
+    EXPECT_EQ(copy, tree);
+
+    auto moved_to{std::move(copy)};
+    EXPECT_EQ(moved_to, tree);
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(copy.begin(), copy.end());
+
+    copy = moved_to;
+    EXPECT_EQ(copy, tree);
+}
+
+TEST(Top_Down_Splay_Tree, Lookup)
+{
+    tree_type tree{1, 3, 5};
+
+    EXPECT_EQ(tree.find(2), tree.end());
+    EXPECT_EQ(*tree.find(3), 3);
+    EXPECT_TRUE(tree.contains(5));
+
+    EXPECT_EQ(*tree.lower_bound(0), 1);
+    EXPECT_EQ(*tree.lower_bound(2), 3);
+    EXPECT_EQ(*tree.lower_bound(3), 3);
+    EXPECT_EQ(tree.lower_bound(6), tree.end());
+
+    EXPECT_EQ(*tree.upper_bound(0), 1);
+    EXPECT_EQ(*tree.upper_bound(3), 5);
+    EXPECT_EQ(tree.upper_bound(5), tree.end());
+
+    EXPECT_EQ(tree.n_less_than(0), 0);
+    EXPECT_EQ(tree.n_less_than(3), 1);
+    EXPECT_EQ(tree.n_less_than(4), 2);
+    EXPECT_EQ(tree.n_less_than(6), 3);
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+
+    tree_type empty_tree;
+    EXPECT_EQ(empty_tree.lower_bound(0), empty_tree.end());
+    EXPECT_EQ(empty_tree.n_less_than(0), 0);
+}
+
+TEST(Top_Down_Splay_Tree, Random_Operations)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<key_type> keys{0, 500};
+
+    tree_type tree;
+    yLab::Top_Down_Splay_Tree<key_type> plain_tree;
+    std::set<key_type> model;
+
+    for (auto i = 0; i != 5000; ++i)
+    {
+        const auto key = keys(gen);
+
+        switch (i % 3)
+        {
+            case 0:
+                EXPECT_EQ(tree.insert(key).second, model.insert(key).second);
+                plain_tree.insert(key);
+                break;
+
+            case 1:
+                EXPECT_EQ(tree.erase(key), model.erase(key));
+                plain_tree.erase(key);
+                break;
+
+            default:
+            {
+                auto it = model.lower_bound(key);
+                EXPECT_EQ(tree.n_less_than(key),
+                          static_cast<std::size_t>(std::distance(model.begin(), it)));
+                EXPECT_EQ(plain_tree.lower_bound(key) == plain_tree.end(), it == model.end());
+                break;
+            }
+        }
+
+        ASSERT_TRUE(tree.subtree_sizes_verifier());
+    }
+
+    EXPECT_TRUE(std::ranges::equal(tree, model));
+    EXPECT_TRUE(std::ranges::equal(plain_tree, model));
+    EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), model.rbegin(), model.rend()));
+}
+
+TEST(Top_Down_Splay_Tree, Erase)
+{
+    std::vector<key_type> vec(200);
+    std::iota(vec.begin(), vec.end(), 1);
+
+    for (auto key : vec)
+    {
+        tree_type tree(vec.begin(), vec.end());
+        std::set model(vec.begin(), vec.end());
+
+        tree.find(100); // makes both subtrees of the root non-empty
+
+        EXPECT_EQ(tree.erase(key), 1);
+        model.erase(key);
+
+        EXPECT_TRUE(std::ranges::equal(tree, model));
+        EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), model.rbegin(), model.rend()));
+        EXPECT_TRUE(tree.subtree_sizes_verifier());
+    }
+
+    tree_type tree{1};
+    tree.erase(tree.begin());
+    EXPECT_EQ(tree, tree_type{});
+}
+
+TEST(Top_Down_Splay_Tree, Join_And_Split)
+{
+    tree_type tree_1{1, 2, 3, 4, 5};
+    tree_type tree_2{6, 7, 8, 9, 10};
+    tree_type tree_3{5, 6};
+
+    EXPECT_TRUE(tree_1.join(std::move(tree_2)));
+    EXPECT_TRUE(tree_2.empty());
+    EXPECT_FALSE(tree_1.join(std::move(tree_3)));
+
+    std::vector<key_type> vec(10);
+    std::iota(vec.begin(), vec.end(), 1);
+    EXPECT_TRUE(std::ranges::equal(tree_1, vec));
+    EXPECT_TRUE(tree_1.subtree_sizes_verifier());
+
+    auto right_part = tree_1.split(7);
+    EXPECT_TRUE(std::ranges::equal(tree_1, std::vector{1, 2, 3, 4, 5, 6, 7}));
+    EXPECT_TRUE(std::ranges::equal(right_part, std::vector{8, 9, 10}));
+    EXPECT_TRUE(std::equal(right_part.rbegin(), right_part.rend(), vec.rbegin(),
+                           std::next(vec.rbegin(), 3)));
+    EXPECT_EQ(tree_1.size(), 7);
+    EXPECT_EQ(right_part.size(), 3);
+    EXPECT_TRUE(tree_1.subtree_sizes_verifier());
+    EXPECT_TRUE(right_part.subtree_sizes_verifier());
+
+    EXPECT_TRUE(tree_1.split(0).empty());
+    EXPECT_TRUE(tree_1.split(7).empty());
+}
+
+TEST(Top_Down_Splay_Tree, Split_By_Bound)
+{
+    for (auto key : {0, 1, 2, 5, 6, 9, 10, 11})
+    {
+        for (auto bound : {yLab::Split_Bound::lower, yLab::Split_Bound::upper})
+        {
+            tree_type tree{1, 3, 5, 7, 9};
+            tree.find(key % 2 ? 3 : 7); // splay some node to the root first
+
+            auto [left, right] = std::move(tree).split(key, bound);
+            EXPECT_TRUE(tree.empty());
+
+            std::vector<key_type> left_keys, right_keys;
+            for (auto k : {1, 3, 5, 7, 9})
+            {
+                bool goes_left = (bound == yLab::Split_Bound::lower) ? k < key : k <= key;
+                (goes_left ? left_keys : right_keys).push_back(k);
+            }
+
+            EXPECT_TRUE(std::ranges::equal(left, left_keys));
+            EXPECT_TRUE(std::ranges::equal(right, right_keys));
+            EXPECT_TRUE(std::equal(right.rbegin(), right.rend(), right_keys.rbegin(),
+                                   right_keys.rend()));
+            EXPECT_EQ(left.size(), left_keys.size());
+            EXPECT_EQ(right.size(), right_keys.size());
+            EXPECT_TRUE(left.subtree_sizes_verifier());
+            EXPECT_TRUE(right.subtree_sizes_verifier());
+
+            // both halves stay usable
+            left.insert(0);
+            right.insert(100);
+            EXPECT_EQ(*left.begin(), 0);
+            EXPECT_EQ(*right.rbegin(), 100);
+        }
+    }
+}
+
+TEST(Top_Down_Splay_Tree, Swap_And_Clear)
+{
+    tree_type tree_1{1, 2, 3, 4}, tree_2{5, 6, 7};
+    auto copy_1{tree_1}, copy_2{tree_2};
+
+    tree_1.swap(tree_2);
+
+    EXPECT_EQ(tree_1, copy_2);
+    EXPECT_EQ(tree_2, copy_1);
+    EXPECT_EQ(*std::prev(tree_1.end()), 7);
+
+    tree_1.clear();
+    EXPECT_EQ(tree_1, tree_type{});
+
+    tree_1.insert(3);
+    EXPECT_TRUE(std::ranges::equal(tree_1, std::vector{3}));
+}
+
+TEST(Top_Down_Splay_Tree, Sorted_Bulk_Load)
+{
+    std::vector<key_type> vec(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+
+    tree_type tree(vec.begin(), vec.end());
+    EXPECT_EQ(tree.size(), vec.size());
+    EXPECT_TRUE(std::ranges::equal(tree, vec));
+    EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), vec.rbegin(), vec.rend()));
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+    EXPECT_EQ(tree.n_less_than(500), 500);
+
+    tree.assign_sorted(vec.begin() + 10, vec.begin() + 20);
+    tree.insert(5);
+    EXPECT_TRUE(std::ranges::equal(tree, std::vector{5, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19}));
+    EXPECT_TRUE(tree.subtree_sizes_verifier());
+
+    tree_type unsorted{3, 4, 5, 1, 2};
+    EXPECT_TRUE(std::ranges::equal(unsorted, std::vector{1, 2, 3, 4, 5}));
+    EXPECT_TRUE(unsorted.subtree_sizes_verifier());
+}